@@ -17,7 +17,9 @@ enum InstrSize
 	S_NA= 0,			// not applicable
 	S_BYTE,
 	S_WORD,
-	S_LONG
+	S_LONG,
+	S_SINGLE,			// FPU operand formats (disassembler only)
+	S_DOUBLE
 };
 
 
@@ -164,6 +166,18 @@ enum CpuRegister
 	R_ACC1,
 	R_ACC2,
 	R_ACC3,
+
+	R_FP0,
+	R_FP1,
+	R_FP2,
+	R_FP3,
+	R_FP4,
+	R_FP5,
+	R_FP6,
+	R_FP7,
+	R_FPCR,
+	R_FPSR,
+	R_FPIAR,
 };
 
 // register word designation for MAC instructions
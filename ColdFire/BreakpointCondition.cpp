@@ -0,0 +1,370 @@
+/*-----------------------------------------------------------------------------
+	ColdFire Macro Assembler and Simulator
+
+	Copyright (C) 2007-2012 Mike Kowalski
+
+	See License.txt for more details
+-----------------------------------------------------------------------------*/
+
+#include "pch.h"
+#include "BreakpointCondition.h"
+#include "Context.h"
+#include "Exceptions.h"
+#include <boost/format.hpp>
+
+
+// recursive descent parser emitting code for the stack machine
+
+class BreakpointCondition::Parser
+{
+public:
+	Parser(const std::string& text, std::vector<Op>& code) : text_(text), pos_(0), code_(code), depth_(0)
+	{}
+
+	void Parse()
+	{
+		Binary(1);
+		Skip();
+		if (pos_ < text_.size())
+			Error("unexpected character");
+	}
+
+private:
+	const std::string& text_;
+	size_t pos_;
+	std::vector<Op>& code_;
+	int depth_;		// stack depth at this point of code
+
+	void Error(const char* msg) const
+	{
+		throw RunTimeError((boost::format("Breakpoint condition: %s at position %d") % msg % (pos_ + 1)).str());
+	}
+
+	void Emit(OpCode code, uint32 arg= 0)
+	{
+		Op op= { code, arg };
+		code_.push_back(op);
+
+		switch (code)
+		{
+		case PUSH: case REG:
+			if (++depth_ > MAX_DEPTH)
+				Error("expression too complex");
+			break;
+		case LOAD_B: case LOAD_W: case LOAD_L: case NEG: case NOT: case LNOT:
+			break;
+		default:
+			--depth_;	// binary operators
+			break;
+		}
+	}
+
+	void Skip()
+	{
+		while (pos_ < text_.size() && isspace(static_cast<unsigned char>(text_[pos_])))
+			++pos_;
+	}
+
+	bool Accept(const char* token)
+	{
+		Skip();
+		auto len= strlen(token);
+		if (text_.compare(pos_, len, token) != 0)
+			return false;
+		pos_ += len;
+		return true;
+	}
+
+	// binary operators ordered by precedence; longer tokens first, so "<<" is not taken for "<"
+	struct BinOp
+	{
+		const char* token;
+		int precedence;
+		OpCode code;
+	};
+
+	bool AcceptBinary(int min_precedence, OpCode& code, int& precedence)
+	{
+		static const BinOp ops[]=
+		{
+			{ "||", 1, LOR }, { "&&", 2, LAND }, { "==", 6, EQ }, { "!=", 6, NE }, { "<=", 7, LE }, { ">=", 7, GE },
+			{ "<<", 8, SHL }, { ">>", 8, SHR }, { "|", 3, OR }, { "^", 4, XOR }, { "&", 5, AND }, { "<", 7, LT },
+			{ ">", 7, GT }, { "+", 9, ADD }, { "-", 9, SUB }, { "*", 10, MUL }, { "/", 10, DIV }, { "%", 10, MOD }
+		};
+
+		Skip();
+		for (auto& op : ops)
+			if (text_.compare(pos_, strlen(op.token), op.token) == 0)
+			{
+				if (op.precedence < min_precedence)
+					return false;
+				pos_ += strlen(op.token);
+				code = op.code;
+				precedence = op.precedence;
+				return true;
+			}
+
+		return false;
+	}
+
+	void Binary(int min_precedence)
+	{
+		Unary();
+
+		OpCode code;
+		int precedence= 0;
+		while (AcceptBinary(min_precedence, code, precedence))
+		{
+			Binary(precedence + 1);
+			Emit(code);
+		}
+	}
+
+	void Unary()
+	{
+		if (Accept("-"))
+		{
+			Unary();
+			Emit(NEG);
+		}
+		else if (Accept("~"))
+		{
+			Unary();
+			Emit(NOT);
+		}
+		else if (Accept("!"))
+		{
+			Unary();
+			Emit(LNOT);
+		}
+		else
+			Primary();
+	}
+
+	// optional .B/.W/.L suffix; returns size in bytes, or 0 if there's none
+	int Suffix()
+	{
+		Skip();
+		if (pos_ + 1 >= text_.size() || text_[pos_] != '.')
+			return 0;
+
+		switch (toupper(static_cast<unsigned char>(text_[pos_ + 1])))
+		{
+		case 'B':	pos_ += 2; return 1;
+		case 'W':	pos_ += 2; return 2;
+		case 'L':	pos_ += 2; return 4;
+		default:	Error("expected size .B, .W or .L"); return 0;
+		}
+	}
+
+	void Primary()
+	{
+		Skip();
+		if (pos_ >= text_.size())
+			Error("missing operand");
+
+		auto c= text_[pos_];
+
+		if (c == '(')
+		{
+			++pos_;
+			auto start= code_.size();
+			Binary(1);
+			if (!Accept(")"))
+				Error("missing ')'");
+
+			static const OpCode loads[]= { LOAD_L, LOAD_B, LOAD_W, LOAD_L, LOAD_L };
+			if (auto size= Suffix())
+				Emit(loads[size]);
+			else if (code_.size() == start + 1 && code_[start].code == REG && code_[start].arg >= 8 && code_[start].arg < 16)
+				Emit(LOAD_L);	// (An)
+		}
+		else if (c == '$' || isdigit(static_cast<unsigned char>(c)))
+			Number();
+		else if (isalpha(static_cast<unsigned char>(c)) || c == '_')
+			Register();
+		else
+			Error("unexpected character");
+	}
+
+	void Number()
+	{
+		int base= 10;
+		if (text_[pos_] == '$')
+		{
+			base = 16;
+			++pos_;
+		}
+		else if (text_.compare(pos_, 2, "0x") == 0 || text_.compare(pos_, 2, "0X") == 0)
+		{
+			base = 16;
+			pos_ += 2;
+		}
+
+		uint64 value= 0;
+		size_t digits= 0;
+		for ( ; pos_ < text_.size(); ++pos_, ++digits)
+		{
+			auto c= static_cast<unsigned char>(text_[pos_]);
+			int digit= 0;
+			if (isdigit(c))
+				digit = c - '0';
+			else if (base == 16 && isxdigit(c))
+				digit = toupper(c) - 'A' + 10;
+			else
+				break;
+
+			value = value * base + digit;
+			if (value > 0xffffffff)
+				Error("number too big");
+		}
+
+		if (digits == 0)
+			Error("missing digits");
+
+		Emit(PUSH, static_cast<uint32>(value));
+	}
+
+	void Register()
+	{
+		auto start= pos_;
+		while (pos_ < text_.size() && (isalnum(static_cast<unsigned char>(text_[pos_])) || text_[pos_] == '_'))
+			++pos_;
+
+		auto name= text_.substr(start, pos_ - start);
+		for (auto& c : name)
+			c = static_cast<char>(toupper(static_cast<unsigned char>(c)));
+
+		uint32 reg= 0;
+		if (name.size() == 2 && (name[0] == 'D' || name[0] == 'A') && name[1] >= '0' && name[1] <= '7')
+			reg = (name[0] == 'A' ? 8 : 0) + (name[1] - '0');
+		else if (name == "SP")
+			reg = 15;
+		else if (name == "PC")
+			reg = R_PC;
+		else if (name == "SR")
+			reg = R_SR;
+		else if (name == "CCR")
+			reg = R_CCR;
+		else if (name == "USP")
+			reg = R_USP;
+		else if (name == "SSP")
+			reg = R_SSP;
+		else if (name == "VBR")
+			reg = R_VBR;
+		else
+		{
+			pos_ = start;
+			Error("unknown register");
+		}
+
+		Emit(REG, reg);
+
+		switch (Suffix())
+		{
+		case 1:
+			Emit(PUSH, 0xff);
+			Emit(AND);
+			break;
+		case 2:
+			Emit(PUSH, 0xffff);
+			Emit(AND);
+			break;
+		}
+	}
+};
+
+
+BreakpointCondition::BreakpointCondition(const std::string& expression) : expression_(expression)
+{
+	Parser(expression_, code_).Parse();
+}
+
+
+namespace {
+	// read RAM/flash without side effects; anything else reads as 0
+	uint32 Peek(const Context& ctx, uint32 address, uint32 size)
+	{
+		auto da= ctx.GetMemoryAddress(address, size, true);
+		if (da.type != DecodedAddress::RAM && da.type != DecodedAddress::FLASH)
+			return 0;
+
+		auto c= static_cast<const uint8*>(da.address);
+		uint32 value= 0;
+		for (uint32 i= 0; i < size; ++i)
+			value = value << 8 | c[i];
+		return value;
+	}
+}
+
+
+uint32 BreakpointCondition::Value(const Context& ctx) const
+{
+	uint32 stack[MAX_DEPTH];
+	int sp= -1;
+	auto& cpu= ctx.Cpu();
+
+	for (auto& op : code_)
+	{
+		uint32 top= sp >= 0 ? stack[sp] : 0;
+
+		switch (op.code)
+		{
+		case PUSH:
+			stack[++sp] = op.arg;
+			continue;
+
+		case REG:
+			switch (op.arg)
+			{
+			case R_PC:	top = cpu.pc; break;
+			case R_SR:	top = cpu.GetSR(); break;
+			case R_CCR:	top = cpu.GetSR() & 0xff; break;
+			case R_USP:	top = cpu.GetStackPointers().first; break;
+			case R_SSP:	top = cpu.GetStackPointers().second; break;
+			case R_VBR:	top = cpu.vbr; break;
+			default:	top = op.arg < 8 ? cpu.d_reg[op.arg] : cpu.a_reg[op.arg - 8]; break;
+			}
+			stack[++sp] = top;
+			continue;
+
+		case LOAD_B:	stack[sp] = Peek(ctx, top, 1); continue;
+		case LOAD_W:	stack[sp] = Peek(ctx, top, 2); continue;
+		case LOAD_L:	stack[sp] = Peek(ctx, top, 4); continue;
+		case NEG:		stack[sp] = 0 - top; continue;
+		case NOT:		stack[sp] = ~top; continue;
+		case LNOT:		stack[sp] = !top; continue;
+		default:
+			break;
+		}
+
+		// binary operators
+		auto left= stack[--sp];
+		uint32 result= 0;
+		switch (op.code)
+		{
+		case MUL:	result = left * top; break;
+		case DIV:	result = top ? left / top : 0; break;
+		case MOD:	result = top ? left % top : 0; break;
+		case ADD:	result = left + top; break;
+		case SUB:	result = left - top; break;
+		case SHL:	result = top < 32 ? left << top : 0; break;
+		case SHR:	result = top < 32 ? left >> top : 0; break;
+		case LT:	result = left < top; break;
+		case LE:	result = left <= top; break;
+		case GT:	result = left > top; break;
+		case GE:	result = left >= top; break;
+		case EQ:	result = left == top; break;
+		case NE:	result = left != top; break;
+		case AND:	result = left & top; break;
+		case XOR:	result = left ^ top; break;
+		case OR:	result = left | top; break;
+		case LAND:	result = left && top; break;
+		case LOR:	result = left || top; break;
+		default:	break;
+		}
+		stack[sp] = result;
+	}
+
+	return sp >= 0 ? stack[sp] : 0;
+}
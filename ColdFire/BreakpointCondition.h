@@ -0,0 +1,60 @@
+/*-----------------------------------------------------------------------------
+	ColdFire Macro Assembler and Simulator
+
+	Copyright (C) 2007-2012 Mike Kowalski
+
+	See License.txt for more details
+-----------------------------------------------------------------------------*/
+
+#pragma once
+#include "BasicTypes.h"
+
+class Context;
+
+
+// Breakpoint condition compiled once into a small stack machine code, so it can be evaluated by
+// execution thread every time breakpoint is hit.
+//
+// Expressions use C operators (|| && | ^ & == != < <= > >= << >> + - * / % ! ~ unary -) with C precedence;
+// all arithmetic is unsigned 32-bit. Operands:
+//  numbers:	123, $7f, 0x7f
+//  registers:	D0-D7, A0-A7, SP, PC, SR, CCR, USP, SSP, VBR; suffix .B or .W takes low byte/word (D0.W)
+//  memory:		(expr).B, (expr).W, (expr).L; (An) alone reads long word
+// Memory outside of RAM/flash reads as 0; devices are never accessed.
+// The same expressions give values captured by tracepoints.
+
+class BreakpointCondition
+{
+public:
+	// throws RunTimeError describing syntax error
+	explicit BreakpointCondition(const std::string& expression);
+
+	bool Evaluate(const Context& ctx) const	{ return Value(ctx) != 0; }
+
+	uint32 Value(const Context& ctx) const;
+
+	const std::string& Expression() const	{ return expression_; }
+
+private:
+	enum OpCode : uint8
+	{
+		PUSH, REG, LOAD_B, LOAD_W, LOAD_L,
+		NEG, NOT, LNOT,
+		MUL, DIV, MOD, ADD, SUB, SHL, SHR, LT, LE, GT, GE, EQ, NE, AND, XOR, OR, LAND, LOR
+	};
+
+	enum Reg : uint32 { R_PC= 16, R_SR, R_CCR, R_USP, R_SSP, R_VBR };
+
+	struct Op
+	{
+		OpCode code;
+		uint32 arg;
+	};
+
+	enum { MAX_DEPTH= 32 };
+
+	class Parser;
+
+	std::string expression_;
+	std::vector<Op> code_;
+};
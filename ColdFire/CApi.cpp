@@ -0,0 +1,727 @@
+/*-----------------------------------------------------------------------------
+	ColdFire Macro Assembler and Simulator
+
+	Copyright (C) 2007-2012 Mike Kowalski
+
+	See License.txt for more details
+-----------------------------------------------------------------------------*/
+
+#include "pch.h"
+#include "CApi.h"
+#include "Simulator.h"
+#include "Assembler.h"
+#include "BinaryProgram.h"
+#include "GdbServer.h"
+#include "Exceptions.h"
+#include <chrono>
+#include <thread>
+
+
+struct cf_simulator
+{
+	Simulator sim;
+	std::unique_ptr<GdbServer> gdb;		// declared after 'sim', so it goes away first
+};
+
+struct cf_assembler
+{
+	Assembler as;
+	std::string message;
+};
+
+struct cf_program
+{
+	cf::BinaryProgram code;
+};
+
+
+static_assert(CF_R_A0 == cf::R_A0 && CF_R_SP == cf::R_SP && CF_R_CCR == cf::R_CCR && CF_R_USP == cf::R_USP && CF_R_VBR == cf::R_VBR, "register ids out of sync");
+static_assert(CF_SIM_IS_RUNNING == SIM_IS_RUNNING && CF_SIM_INTERNAL_ERROR == SIM_INTERNAL_ERROR, "status codes out of sync");
+static_assert(CF_MEM_READ_ONLY == static_cast<int>(cf::MemoryAccess::ReadOnly) && CF_MEM_NULL == static_cast<int>(cf::MemoryAccess::Null), "memory access out of sync");
+
+
+namespace {
+	thread_local std::string last_error;
+
+	// exceptions cannot cross C interface; they are turned into CF_ERROR and remembered
+	template<class Fn>
+	int Guard(Fn fn)
+	{
+		try
+		{
+			return fn();
+		}
+		catch (std::exception& ex)
+		{
+			last_error = ex.what();
+		}
+		catch (...)
+		{
+			last_error = "Unexpected error";
+		}
+		return CF_ERROR;
+	}
+
+	template<class T, class Fn>
+	T* GuardNew(Fn fn)
+	{
+		T* obj= nullptr;
+		Guard([&]
+		{
+			std::unique_ptr<T> p(new T());
+			fn(*p);
+			obj = p.release();
+			return CF_OK;
+		});
+		return obj;
+	}
+
+	void CheckHandle(const void* handle)
+	{
+		if (handle == nullptr)
+			throw RunTimeError("Null handle passed to C API function");
+	}
+
+	void CheckStopped(const cf_simulator* sim)
+	{
+		CheckHandle(sim);
+		if (sim->sim.GetStatus() == SIM_IS_RUNNING)
+			throw RunTimeError("Simulator state is not accessible while simulation is running");
+	}
+
+	cf::Register ToRegister(int reg, bool write)
+	{
+		switch (reg)
+		{
+		case CF_R_SP:
+			return cf::R_A7;
+
+		case CF_R_USP:
+			if (write)
+				break;
+			return cf::R_USP;
+
+		default:
+			if (reg >= CF_R_D0 && reg <= CF_R_VBR)
+				return static_cast<cf::Register>(reg);
+			break;
+		}
+		throw RunTimeError("Unsupported register id passed to C API function");
+	}
+
+	std::vector<cf::Register> ToRegisters(const int* regs, size_t count, bool write)
+	{
+		std::vector<cf::Register> v(count);
+		for (size_t i= 0; i < count; ++i)
+			v[i] = ToRegister(regs[i], write);
+		return v;
+	}
+
+	void CheckBuffer(const void* buffer, size_t length)
+	{
+		if (buffer == nullptr && length > 0)
+			throw RunTimeError("Null buffer passed to C API function");
+	}
+}
+
+
+int cf_api_version(void)
+{
+	return CF_API_VERSION;
+}
+
+
+const char* cf_last_error(void)
+{
+	return last_error.c_str();
+}
+
+
+int cf_isa_from_string(const char* isa)
+{
+	return Guard([&]
+	{
+		static const char* const names[]= { "ISA_A", "ISA_A+", "ISA_B", "ISA_C", "MAC", "EMAC", "EMAC_B", "FPU", "None" };
+
+		if (isa == nullptr || std::find_if(std::begin(names), std::end(names), [&](const char* name) { return strcmp(name, isa) == 0; }) == std::end(names))
+			throw RunTimeError("Unknown ISA name");
+
+		return static_cast<int>(StringToISA(std::string(isa)));
+	});
+}
+
+
+// --- simulator ---
+
+cf_simulator* cf_sim_create(void)
+{
+	return GuardNew<cf_simulator>([](cf_simulator&) {});
+}
+
+
+void cf_sim_destroy(cf_simulator* sim)
+{
+	if (sim == nullptr)
+		return;
+
+	Guard([&]
+	{
+		// debugger could resume simulation while it's being stopped
+		sim->gdb.reset();
+		if (sim->sim.GetStatus() == SIM_IS_RUNNING)
+		{
+			sim->sim.BreakExecution();
+			cf_sim_wait(sim, -1);
+		}
+		delete sim;
+		return CF_OK;
+	});
+}
+
+
+int cf_sim_load_configuration(cf_simulator* sim, const wchar_t* path)
+{
+	return Guard([&]
+	{
+		CheckStopped(sim);
+		CheckHandle(path);
+		sim->sim.LoadConfiguration(path);
+		return CF_OK;
+	});
+}
+
+
+int cf_sim_set_isa(cf_simulator* sim, uint32_t isa)
+{
+	return Guard([&]
+	{
+		CheckStopped(sim);
+		sim->sim.SetIsa(static_cast<ISA>(isa));
+		return CF_OK;
+	});
+}
+
+
+int cf_sim_create_memory_bank(cf_simulator* sim, const char* name, uint32_t base, uint32_t size, int bank, int access)
+{
+	return Guard([&]
+	{
+		CheckStopped(sim);
+		if (access < CF_MEM_NORMAL || access > CF_MEM_NULL)
+			throw RunTimeError("Invalid memory bank access " __FUNCTION__);
+
+		sim->sim.CreateMemoryBank(name != nullptr ? name : "", base, size, bank, static_cast<cf::MemoryAccess>(access));
+		return CF_OK;
+	});
+}
+
+
+int cf_sim_set_semihosting_root(cf_simulator* sim, const wchar_t* dir)
+{
+	return Guard([&]
+	{
+		CheckStopped(sim);
+		sim->sim.SetSemihostingRoot(dir);
+		return CF_OK;
+	});
+}
+
+
+int cf_sim_set_program(cf_simulator* sim, const cf_program* program)
+{
+	return Guard([&]
+	{
+		CheckStopped(sim);
+		CheckHandle(program);
+		sim->sim.SetProgram(program->code);
+		return CF_OK;
+	});
+}
+
+
+int cf_sim_reset(cf_simulator* sim)
+{
+	return Guard([&]
+	{
+		CheckStopped(sim);
+		sim->sim.Reset();
+		return CF_OK;
+	});
+}
+
+
+int cf_sim_set_breakpoint(cf_simulator* sim, uint32_t address, int set)
+{
+	return Guard([&]
+	{
+		CheckStopped(sim);
+		sim->sim.SetBreakpoint(address, set != 0);
+		return CF_OK;
+	});
+}
+
+
+int cf_sim_clear_breakpoints(cf_simulator* sim)
+{
+	return Guard([&]
+	{
+		CheckStopped(sim);
+		sim->sim.ClearAllBreakpoints();
+		return CF_OK;
+	});
+}
+
+
+int cf_sim_run(cf_simulator* sim)
+{
+	return Guard([&]
+	{
+		CheckHandle(sim);
+		return static_cast<int>(sim->sim.Run());
+	});
+}
+
+
+int cf_sim_step(cf_simulator* sim)
+{
+	return Guard([&]
+	{
+		CheckHandle(sim);
+		return static_cast<int>(sim->sim.Step());
+	});
+}
+
+
+int cf_sim_run_to(cf_simulator* sim, uint32_t address)
+{
+	return Guard([&]
+	{
+		CheckHandle(sim);
+		return static_cast<int>(sim->sim.RunToAddress(address));
+	});
+}
+
+
+int cf_sim_break(cf_simulator* sim)
+{
+	return Guard([&]
+	{
+		CheckHandle(sim);
+		return static_cast<int>(sim->sim.BreakExecution());
+	});
+}
+
+
+int cf_sim_wait(cf_simulator* sim, int timeout_ms)
+{
+	return Guard([&]
+	{
+		CheckHandle(sim);
+
+		auto deadline= std::chrono::steady_clock::now() + std::chrono::milliseconds(timeout_ms);
+
+		for (int spins= 0; sim->sim.GetStatus() == SIM_IS_RUNNING; ++spins)
+		{
+			if (timeout_ms >= 0 && std::chrono::steady_clock::now() >= deadline)
+				return static_cast<int>(CF_TIMEOUT);
+
+			// steps end quickly, so spin for a while before sleeping
+			if (spins < 1000)
+				std::this_thread::yield();
+			else
+				std::this_thread::sleep_for(std::chrono::milliseconds(1));
+		}
+
+		return static_cast<int>(sim->sim.GetStatus());
+	});
+}
+
+
+int cf_sim_status(cf_simulator* sim)
+{
+	return Guard([&]
+	{
+		CheckHandle(sim);
+		return static_cast<int>(sim->sim.GetStatus());
+	});
+}
+
+
+int cf_sim_get_stats(cf_simulator* sim, uint32_t* cycles, uint32_t* instructions)
+{
+	return Guard([&]
+	{
+		CheckHandle(sim);
+		if (cycles)
+			*cycles = sim->sim.CyclesTaken();
+		if (instructions)
+			*instructions = sim->sim.ExecutedInstructions();
+		return CF_OK;
+	});
+}
+
+
+int cf_sim_zero_stats(cf_simulator* sim)
+{
+	return Guard([&]
+	{
+		CheckStopped(sim);
+		sim->sim.ZeroStats();
+		return CF_OK;
+	});
+}
+
+
+int cf_sim_gdb_listen(cf_simulator* sim, uint16_t port)
+{
+	return Guard([&]
+	{
+		CheckStopped(sim);
+		sim->gdb.reset();	// release the port first, in case the same one is requested
+		sim->gdb.reset(new GdbServer(sim->sim, port));
+		return CF_OK;
+	});
+}
+
+
+int cf_sim_gdb_close(cf_simulator* sim)
+{
+	return Guard([&]
+	{
+		CheckHandle(sim);
+		sim->gdb.reset();
+		return CF_OK;
+	});
+}
+
+
+int cf_sim_gdb_connected(cf_simulator* sim)
+{
+	return Guard([&]
+	{
+		CheckHandle(sim);
+		return sim->gdb && sim->gdb->Connected() ? 1 : 0;
+	});
+}
+
+
+int cf_sim_get_profile_report(cf_simulator* sim, char* buffer, size_t capacity)
+{
+	return Guard([&]
+	{
+		CheckStopped(sim);
+
+		auto report= sim->sim.GetProfileReport();
+		if (buffer && capacity > 0)
+		{
+			auto len= std::min(capacity - 1, report.size());
+			memcpy(buffer, report.data(), len);
+			buffer[len] = '\0';
+		}
+		return static_cast<int>(report.size());
+	});
+}
+
+
+int cf_sim_get_registers(cf_simulator* sim, const int* regs, uint32_t* values, size_t count)
+{
+	return Guard([&]
+	{
+		CheckStopped(sim);
+		CheckBuffer(regs, count);
+		CheckBuffer(values, count);
+
+		auto r= ToRegisters(regs, count, false);
+		sim->sim.GetRegisters(r.data(), values, count);
+		return CF_OK;
+	});
+}
+
+
+int cf_sim_set_registers(cf_simulator* sim, const int* regs, const uint32_t* values, size_t count)
+{
+	return Guard([&]
+	{
+		CheckStopped(sim);
+		CheckBuffer(regs, count);
+		CheckBuffer(values, count);
+
+		// validate all of them before changing anything
+		auto r= ToRegisters(regs, count, true);
+		sim->sim.SetRegisters(r.data(), values, count);
+		return CF_OK;
+	});
+}
+
+
+namespace {
+	// cf_cpu_state layout: SR first, so it switches stacks before A7 is set
+	const cf::Register state_regs[]=
+	{
+		cf::R_SR, cf::R_PC,
+		cf::R_D0, cf::R_D1, cf::R_D2, cf::R_D3, cf::R_D4, cf::R_D5, cf::R_D6, cf::R_D7,
+		cf::R_A0, cf::R_A1, cf::R_A2, cf::R_A3, cf::R_A4, cf::R_A5, cf::R_A6, cf::R_A7
+	};
+
+	const size_t STATE_REGS= sizeof(state_regs) / sizeof(state_regs[0]);
+
+	void StateToValues(const cf_cpu_state& state, cf::uint32* values)
+	{
+		values[0] = state.sr;
+		values[1] = state.pc;
+		std::copy(state.d, state.d + 8, values + 2);
+		std::copy(state.a, state.a + 8, values + 10);
+	}
+
+	void ValuesToState(const cf::uint32* values, cf_cpu_state& state)
+	{
+		state.sr = values[0];
+		state.pc = values[1];
+		std::copy(values + 2, values + 10, state.d);
+		std::copy(values + 10, values + 18, state.a);
+	}
+}
+
+
+int cf_sim_get_cpu_state(cf_simulator* sim, cf_cpu_state* state)
+{
+	return Guard([&]
+	{
+		CheckStopped(sim);
+		CheckHandle(state);
+
+		cf::uint32 values[STATE_REGS];
+		sim->sim.GetRegisters(state_regs, values, STATE_REGS);
+		ValuesToState(values, *state);
+		return CF_OK;
+	});
+}
+
+
+int cf_sim_set_cpu_state(cf_simulator* sim, const cf_cpu_state* state)
+{
+	return Guard([&]
+	{
+		CheckStopped(sim);
+		CheckHandle(state);
+
+		cf::uint32 values[STATE_REGS];
+		StateToValues(*state, values);
+		sim->sim.SetRegisters(state_regs, values, STATE_REGS);
+		return CF_OK;
+	});
+}
+
+
+int cf_sim_read_memory(cf_simulator* sim, uint32_t address, uint8_t* buffer, uint32_t length)
+{
+	return Guard([&]
+	{
+		CheckStopped(sim);
+		CheckBuffer(buffer, length);
+
+		if (length > INT_MAX)
+			throw RunTimeError("Block too long " __FUNCTION__);
+
+		return static_cast<int>(sim->sim.ReadMemory(buffer, address, length));
+	});
+}
+
+
+int cf_sim_write_memory(cf_simulator* sim, uint32_t address, const uint8_t* data, uint32_t length)
+{
+	return Guard([&]
+	{
+		CheckStopped(sim);
+		CheckBuffer(data, length);
+
+		if (length > 0)
+			sim->sim.SetMemory(address, data, data + length);
+		return CF_OK;
+	});
+}
+
+
+int cf_sim_read_memory_ranges(cf_simulator* sim, const cf_memory_range* ranges, size_t count, uint8_t* buffer)
+{
+	return Guard([&]
+	{
+		CheckStopped(sim);
+		CheckBuffer(ranges, count);
+
+		for (size_t i= 0; i < count; ++i)
+		{
+			CheckBuffer(buffer, ranges[i].length);
+			auto read= sim->sim.ReadMemory(buffer, ranges[i].address, ranges[i].length);
+			// range wrapped around the end of address space
+			if (read < ranges[i].length)
+				memset(buffer + read, 0xff, ranges[i].length - read);
+			buffer += ranges[i].length;
+		}
+		return CF_OK;
+	});
+}
+
+
+int cf_sim_write_memory_ranges(cf_simulator* sim, const cf_memory_range* ranges, size_t count, const uint8_t* data)
+{
+	return Guard([&]
+	{
+		CheckStopped(sim);
+		CheckBuffer(ranges, count);
+
+		for (size_t i= 0; i < count; ++i)
+		{
+			CheckBuffer(data, ranges[i].length);
+			if (ranges[i].length > 0)
+				sim->sim.SetMemory(ranges[i].address, data, data + ranges[i].length);
+			data += ranges[i].length;
+		}
+		return CF_OK;
+	});
+}
+
+
+// --- assembler ---
+
+cf_assembler* cf_asm_create(void)
+{
+	return GuardNew<cf_assembler>([](cf_assembler&) {});
+}
+
+
+void cf_asm_destroy(cf_assembler* as)
+{
+	delete as;
+}
+
+
+int cf_asm_assemble(cf_assembler* as, const wchar_t* path, uint32_t isa, int case_sensitive)
+{
+	return Guard([&]
+	{
+		CheckHandle(as);
+		CheckHandle(path);
+		return static_cast<int>(as->as.Assemble(path, static_cast<ISA>(isa), case_sensitive != 0));
+	});
+}
+
+
+const char* cf_asm_message(cf_assembler* as)
+{
+	if (as == nullptr)
+		return "";
+
+	Guard([&]
+	{
+		as->message = as->as.LastMessage();
+		return CF_OK;
+	});
+	return as->message.c_str();
+}
+
+
+int cf_asm_line(cf_assembler* as)
+{
+	return as != nullptr ? as->as.LastLine() : 0;
+}
+
+
+cf_program* cf_asm_program(cf_assembler* as)
+{
+	return GuardNew<cf_program>([&](cf_program& p)
+	{
+		CheckHandle(as);
+		p.code = as->as.GetCode();
+	});
+}
+
+
+// --- binary program ---
+
+cf_program* cf_program_load(const wchar_t* path)
+{
+	return GuardNew<cf_program>([&](cf_program& p)
+	{
+		CheckHandle(path);
+		p.code = cf::LoadBinaryProgram(path);
+	});
+}
+
+
+cf_program* cf_program_load_binary(const wchar_t* path, uint32_t isa, uint32_t address)
+{
+	return GuardNew<cf_program>([&](cf_program& p)
+	{
+		CheckHandle(path);
+		p.code = cf::LoadBinaryCode(path, static_cast<ISA>(isa), address);
+	});
+}
+
+
+int cf_program_save(const cf_program* program, const wchar_t* path)
+{
+	return Guard([&]
+	{
+		CheckHandle(program);
+		CheckHandle(path);
+		cf::SaveBinaryCode(path, program->code);
+		return CF_OK;
+	});
+}
+
+
+void cf_program_destroy(cf_program* program)
+{
+	delete program;
+}
+
+
+uint32_t cf_program_start(const cf_program* program)
+{
+	return program != nullptr ? program->code.GetProgramStart() : 0;
+}
+
+
+uint32_t cf_program_isa(const cf_program* program)
+{
+	return program != nullptr ? static_cast<uint32_t>(program->code.GetIsa()) : 0;
+}
+
+
+int cf_program_fragment_count(const cf_program* program)
+{
+	return Guard([&]
+	{
+		CheckHandle(program);
+
+		int count= 0;
+		for (cf::BinaryProgramRange it(program->code); it; ++it)
+			++count;
+		return count;
+	});
+}
+
+
+int cf_program_fragment(const cf_program* program, int index, uint32_t* address, uint8_t* buffer, uint32_t capacity)
+{
+	return Guard([&]
+	{
+		CheckHandle(program);
+
+		cf::BinaryProgramRange it(program->code);
+		for (int i= 0; it && i < index; ++i)
+			++it;
+
+		if (index < 0 || !it)
+			throw RunTimeError("No such program fragment " __FUNCTION__);
+
+		auto data= it.Fragment();
+		if (address)
+			*address = it.Address();
+		if (buffer)
+			memcpy(buffer, data.data(), std::min<size_t>(capacity, data.size()));
+
+		return static_cast<int>(data.size());
+	});
+}
@@ -0,0 +1,197 @@
+/*-----------------------------------------------------------------------------
+	ColdFire Macro Assembler and Simulator
+
+	Copyright (C) 2007-2012 Mike Kowalski
+
+	See License.txt for more details
+-----------------------------------------------------------------------------*/
+
+// Flat C interface to the simulator, assembler and binary programs. Unlike Simulator.h it doesn't expose
+// STL types or C++ classes, so it can be used by clients built with other compilers or written in other
+// languages (Python's ctypes, for instance).
+//
+// Objects are opaque handles created and destroyed by the functions below; a handle can be used by one
+// thread at a time. Functions never throw: those returning int give CF_OK or a non-negative result on
+// success and CF_ERROR on failure, and cf_last_error() describes the last failure on the calling thread.
+// Paths are wide strings, as everywhere else in the simulator.
+
+#pragma once
+#include "Import.h"
+#include <stddef.h>
+#include <stdint.h>
+#include <wchar.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+// incremented when existing functions or structures change
+#define CF_API_VERSION	1
+
+typedef struct cf_simulator cf_simulator;
+typedef struct cf_assembler cf_assembler;
+typedef struct cf_program cf_program;
+
+
+enum
+{
+	CF_OK= 0,
+	CF_ERROR= -1,
+	CF_TIMEOUT= -2		// cf_sim_wait: simulation is still running
+};
+
+// register ids (same as cf::Register); CF_R_CCR is the low byte of SR (writing it leaves the system byte
+// intact); CF_R_USP is read-only
+enum
+{
+	CF_R_D0= 0, CF_R_D1, CF_R_D2, CF_R_D3, CF_R_D4, CF_R_D5, CF_R_D6, CF_R_D7,
+	CF_R_A0, CF_R_A1, CF_R_A2, CF_R_A3, CF_R_A4, CF_R_A5, CF_R_A6, CF_R_A7,
+	CF_R_SP,
+	CF_R_PC, CF_R_SR, CF_R_CCR, CF_R_USP,
+	CF_R_MBAR, CF_R_VBR
+};
+
+// simulator status (same as SimulatorStatus)
+enum
+{
+	CF_SIM_OK= 0,
+	CF_SIM_STOPPED,
+	CF_SIM_BREAKPOINT_HIT,
+	CF_SIM_EXCEPTION,
+	CF_SIM_IS_RUNNING,
+	CF_SIM_FINISHED,
+	CF_SIM_INTERNAL_ERROR
+};
+
+// memory bank access (same as cf::MemoryAccess)
+enum
+{
+	CF_MEM_NORMAL= 0,
+	CF_MEM_READ_ONLY,
+	CF_MEM_NULL
+};
+
+
+// all general purpose registers at once
+typedef struct cf_cpu_state
+{
+	uint32_t d[8];
+	uint32_t a[8];		// a[7] is the active stack pointer
+	uint32_t pc;
+	uint32_t sr;
+} cf_cpu_state;
+
+typedef struct cf_memory_range
+{
+	uint32_t address;
+	uint32_t length;
+} cf_memory_range;
+
+
+CF_DECL int cf_api_version(void);
+
+// message of the last failure on the calling thread; empty if there was none
+CF_DECL const char* cf_last_error(void);
+
+// ISA bit mask (ISA enum) for its name ("ISA_A", "ISA_A+", "ISA_B", "ISA_C", "MAC", "EMAC", "FPU"...);
+// CF_ERROR if name is not recognized
+CF_DECL int cf_isa_from_string(const char* isa);
+
+
+// --- simulator ---
+
+// returns null on failure
+CF_DECL cf_simulator* cf_sim_create(void);
+// stops simulation if it's still running
+CF_DECL void cf_sim_destroy(cf_simulator* sim);
+
+// board configuration (memory banks, peripherals); see Config folder
+CF_DECL int cf_sim_load_configuration(cf_simulator* sim, const wchar_t* path);
+CF_DECL int cf_sim_set_isa(cf_simulator* sim, uint32_t isa);
+CF_DECL int cf_sim_create_memory_bank(cf_simulator* sim, const char* name, uint32_t base, uint32_t size, int bank, int access);
+// host directory guest program can access through semihosting; null or empty string disables it (default)
+CF_DECL int cf_sim_set_semihosting_root(cf_simulator* sim, const wchar_t* dir);
+
+// copy program to memory and set PC to its start address
+CF_DECL int cf_sim_set_program(cf_simulator* sim, const cf_program* program);
+CF_DECL int cf_sim_reset(cf_simulator* sim);
+
+CF_DECL int cf_sim_set_breakpoint(cf_simulator* sim, uint32_t address, int set);
+CF_DECL int cf_sim_clear_breakpoints(cf_simulator* sim);
+
+// execution commands return at once with simulator status (CF_SIM_IS_RUNNING if execution started);
+// cf_sim_wait blocks till simulation stops and returns its status, or CF_TIMEOUT once 'timeout_ms'
+// elapses (negative timeout waits indefinitely)
+CF_DECL int cf_sim_run(cf_simulator* sim);
+CF_DECL int cf_sim_step(cf_simulator* sim);
+CF_DECL int cf_sim_run_to(cf_simulator* sim, uint32_t address);
+CF_DECL int cf_sim_break(cf_simulator* sim);
+CF_DECL int cf_sim_wait(cf_simulator* sim, int timeout_ms);
+CF_DECL int cf_sim_status(cf_simulator* sim);
+
+CF_DECL int cf_sim_get_stats(cf_simulator* sim, uint32_t* cycles, uint32_t* instructions);
+CF_DECL int cf_sim_zero_stats(cf_simulator* sim);
+
+// GDB remote protocol server on a loopback TCP port ("target remote localhost:<port>" in GDB); while
+// debugger is connected it drives the simulator, so don't run or step it through this API;
+// cf_sim_gdb_connected returns 1 if debugger is connected, 0 if not
+CF_DECL int cf_sim_gdb_listen(cf_simulator* sim, uint16_t port);
+CF_DECL int cf_sim_gdb_close(cf_simulator* sim);
+CF_DECL int cf_sim_gdb_connected(cf_simulator* sim);
+
+// cycle counts of profiled code regions as a formatted table (empty if program marks none); copies up to
+// 'capacity' chars including terminating zero and returns report length; 'buffer' may be null to query length
+CF_DECL int cf_sim_get_profile_report(cf_simulator* sim, char* buffer, size_t capacity);
+
+// Functions below fail while simulation is running.
+
+// registers in bulk: values[i] belongs to regs[i] (CF_R_xxx); they are set in the given order
+CF_DECL int cf_sim_get_registers(cf_simulator* sim, const int* regs, uint32_t* values, size_t count);
+CF_DECL int cf_sim_set_registers(cf_simulator* sim, const int* regs, const uint32_t* values, size_t count);
+// SR is set first, so a[7] lands in the stack pointer of the new mode
+CF_DECL int cf_sim_get_cpu_state(cf_simulator* sim, cf_cpu_state* state);
+CF_DECL int cf_sim_set_cpu_state(cf_simulator* sim, const cf_cpu_state* state);
+
+// memory; bytes outside of RAM and ROM banks read as $ff; writes to them fail
+CF_DECL int cf_sim_read_memory(cf_simulator* sim, uint32_t address, uint8_t* buffer, uint32_t length);
+CF_DECL int cf_sim_write_memory(cf_simulator* sim, uint32_t address, const uint8_t* data, uint32_t length);
+// many ranges in one call; their contents are packed one after another in 'buffer'/'data'
+CF_DECL int cf_sim_read_memory_ranges(cf_simulator* sim, const cf_memory_range* ranges, size_t count, uint8_t* buffer);
+CF_DECL int cf_sim_write_memory_ranges(cf_simulator* sim, const cf_memory_range* ranges, size_t count, const uint8_t* data);
+
+
+// --- assembler ---
+
+CF_DECL cf_assembler* cf_asm_create(void);
+CF_DECL void cf_asm_destroy(cf_assembler* as);
+
+// returns assembler status code (StatCode; 0 - success) or CF_ERROR
+CF_DECL int cf_asm_assemble(cf_assembler* as, const wchar_t* path, uint32_t isa, int case_sensitive);
+// last assembler message and line it refers to (0 if none); message is valid till the next call
+CF_DECL const char* cf_asm_message(cf_assembler* as);
+CF_DECL int cf_asm_line(cf_assembler* as);
+// copy of assembled program; destroy it with cf_program_destroy
+CF_DECL cf_program* cf_asm_program(cf_assembler* as);
+
+
+// --- binary program ---
+
+// program in CFB format, or raw binary code placed at 'address'; null on failure
+CF_DECL cf_program* cf_program_load(const wchar_t* path);
+CF_DECL cf_program* cf_program_load_binary(const wchar_t* path, uint32_t isa, uint32_t address);
+CF_DECL int cf_program_save(const cf_program* program, const wchar_t* path);
+CF_DECL void cf_program_destroy(cf_program* program);
+
+CF_DECL uint32_t cf_program_start(const cf_program* program);
+CF_DECL uint32_t cf_program_isa(const cf_program* program);
+
+// code fragments (ORG blocks); cf_program_fragment copies up to 'capacity' bytes of fragment 'index' and
+// returns its size; 'buffer' may be null to query size only
+CF_DECL int cf_program_fragment_count(const cf_program* program);
+CF_DECL int cf_program_fragment(const cf_program* program, int index, uint32_t* address, uint8_t* buffer, uint32_t capacity);
+
+
+#ifdef __cplusplus
+}
+#endif
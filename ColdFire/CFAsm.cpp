@@ -325,6 +325,8 @@ InstructionSize size_attribute(char size_attr)
 		return IS_LONG;
 	else if (size_attr == 's' || size_attr == 'S')
 		return IS_SHORT;
+	else if (size_attr == 'd' || size_attr == 'D')
+		return IS_DOUBLE;
 
 	return IS_NONE;
 }
@@ -742,6 +744,17 @@ CpuRegister CFAsm::proc_register(FixedString str)
 		Pair("ASID", R_ASID),
 		Pair("CACR", R_CACR),
 		Pair("CCR", R_CCR),
+		Pair("FP0", R_FP0),
+		Pair("FP1", R_FP1),
+		Pair("FP2", R_FP2),
+		Pair("FP3", R_FP3),
+		Pair("FP4", R_FP4),
+		Pair("FP5", R_FP5),
+		Pair("FP6", R_FP6),
+		Pair("FP7", R_FP7),
+		Pair("FPCR", R_FPCR),
+		Pair("FPIAR", R_FPIAR),
+		Pair("FPSR", R_FPSR),
 		Pair("MBAR", R_MBAR),
 		Pair("MMUBAR", R_MMUBAR),
 		Pair("PC", R_PC),
@@ -1651,6 +1664,10 @@ Stat CFAsm::proc_instr_syntax(Lexeme& lex, AsmInstruction& asm_instr)
 			if (sizes == IS_UNSIZED)
 				return ERR_UNEXPECTED_INSTR_SIZE;	// this instruction is unsized, it's an error to specify size
 
+			// .S stands for short branch, or single precision in FPU instructions
+			if (explicit_size == IS_SHORT && (sizes & IS_SHORT) == 0 && (sizes & IS_FLOAT))
+				explicit_size = IS_FLOAT;
+
 			if ((sizes & explicit_size) == 0)
 				return ERR_INVALID_INSTR_SIZE;		// this instruction doesn't support requested size
 
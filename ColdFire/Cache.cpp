@@ -0,0 +1,300 @@
+/*-----------------------------------------------------------------------------
+	ColdFire Macro Assembler and Simulator
+
+	Copyright (C) 2007-2012 Mike Kowalski
+
+	See License.txt for more details
+-----------------------------------------------------------------------------*/
+
+#include "pch.h"
+#include "Cache.h"
+#include "Context.h"
+#include "Exceptions.h"
+
+
+// CACR bits (V4)
+enum : uint32
+{
+	CACR_DEC= 1u << 31,			// data cache enable
+	CACR_DDPI= 1u << 28,		// CPUSHL doesn't invalidate data cache lines
+	CACR_DDCM_POS= 25,			// default data cache mode (2 bits)
+	CACR_DCINVA= 1u << 24,		// invalidate entire data cache
+	CACR_IEC= 1u << 15,			// instruction cache enable
+	CACR_IDPI= 1u << 12,		// CPUSHL doesn't invalidate instruction cache lines
+	CACR_IDCM= 1u << 10,		// default instruction cache mode: cache-inhibited
+	CACR_ICINVA= 1u << 8		// invalidate entire instruction cache
+};
+
+// ACRn bits
+enum : uint32
+{
+	ACR_BASE= 0xff000000,		// address base
+	ACR_MASK_POS= 16,			// address mask (8 bits)
+	ACR_E= 1u << 15,			// enable
+	ACR_S_POS= 13,				// 00 - user mode only, 01 - supervisor only, 1x - both
+	ACR_CM_POS= 5				// cache mode (2 bits)
+};
+
+
+CacheConfig::CacheConfig()
+{
+	size = 0;
+	ways = 4;
+	line_size = 16;
+	write_policy = FOLLOW_CACR;
+	always_enabled = false;
+	hit_cycles = 0;
+	miss_cycles = 12;
+	memory_cycles = 3;
+}
+
+
+Cache::Cache(const CacheConfig& config) : config_(config), line_shift_(0), set_mask_(0), clock_(0)
+{
+	if (config.size == 0)
+		return;
+
+	auto pow2= [](uint32 n) { return n != 0 && (n & (n - 1)) == 0; };
+
+	if (!pow2(config.line_size) || config.line_size < 4 || config.ways == 0 || config.size % (config.line_size * config.ways) != 0 ||
+		!pow2(config.size / (config.line_size * config.ways)))
+		throw RunTimeError("Cache size has to be a power of 2 multiple of line size times ways in " __FUNCTION__);
+
+	while ((1u << line_shift_) < config.line_size)
+		++line_shift_;
+
+	set_mask_ = config.size / (config.line_size * config.ways) - 1;
+
+	Line empty= { 0, 0, false, false };
+	lines_.resize(config.size / config.line_size, empty);
+}
+
+
+Cache::Line* Cache::Lookup(uint32 address, bool fill, uint32& cycles)
+{
+	auto tag= address >> line_shift_;
+	auto set= &lines_[(tag & set_mask_) * config_.ways];
+
+	Line* victim= set;
+	for (uint32 way= 0; way < config_.ways; ++way)
+	{
+		auto& line= set[way];
+		if (line.valid && line.tag == tag)
+		{
+			line.used = ++clock_;
+			return &line;
+		}
+		// least recently used, preferring empty lines
+		if (victim->valid && (!line.valid || line.used < victim->used))
+			victim = &line;
+	}
+
+	++stats_.misses;
+
+	if (!fill)
+		return nullptr;
+
+	if (victim->valid && victim->dirty)
+	{
+		++stats_.writebacks;
+		cycles += config_.miss_cycles;
+	}
+
+	cycles += config_.miss_cycles;
+	victim->tag = tag;
+	victim->valid = true;
+	victim->dirty = false;
+	victim->used = ++clock_;
+
+	return victim;
+}
+
+
+uint32 Cache::Access(uint32 address, bool write, Mode mode)
+{
+	if (mode == INHIBITED)
+	{
+		++stats_.uncached;
+		return config_.memory_cycles;
+	}
+
+	++stats_.accesses;
+
+	uint32 cycles= 0;
+	if (!write)
+		Lookup(address, true, cycles);
+	else if (mode == COPY_BACK)
+		Lookup(address, true, cycles)->dirty = true;
+	else
+	{
+		// write-through without allocation: memory is written regardless of a hit
+		Lookup(address, false, cycles);
+		cycles += config_.memory_cycles;
+	}
+
+	return cycles + config_.hit_cycles;
+}
+
+
+uint32 Cache::Read(uint32 address, int size, Mode mode)
+{
+	auto cycles= Access(address, false, mode);
+
+	// misaligned access may span two lines
+	auto last= address + size - 1;
+	if (mode != INHIBITED && (last ^ address) >> line_shift_)
+		cycles += Access(last, false, mode);
+
+	stats_.cycles += cycles;
+	return cycles;
+}
+
+
+uint32 Cache::Write(uint32 address, int size, Mode mode)
+{
+	auto cycles= Access(address, true, mode);
+
+	auto last= address + size - 1;
+	if (mode != INHIBITED && (last ^ address) >> line_shift_)
+		cycles += Access(last, true, mode);
+
+	stats_.cycles += cycles;
+	return cycles;
+}
+
+
+uint32 Cache::PushLine(uint32 set_way, bool invalidate)
+{
+	if (!Present())
+		return 0;
+
+	auto set= (set_way >> line_shift_) & set_mask_;
+	auto way= (set_way & 3) % config_.ways;
+	auto& line= lines_[set * config_.ways + way];
+
+	uint32 cycles= 0;
+	if (line.valid && line.dirty)
+	{
+		++stats_.writebacks;
+		cycles = config_.miss_cycles;
+		line.dirty = false;
+	}
+
+	if (invalidate)
+		line.valid = false;
+
+	stats_.cycles += cycles;
+	return cycles;
+}
+
+
+void Cache::InvalidateAll()
+{
+	// dirty data is lost on real hardware; here memory is always current
+	for (auto& line : lines_)
+		line.valid = line.dirty = false;
+}
+
+//=============================================================================
+
+CacheModel::CacheModel(const CacheConfig& instructions, const CacheConfig& data) : icache_(instructions), dcache_(data)
+{}
+
+
+namespace {
+	// does access control register 'acr' cover 'address'?
+	bool Matches(uint32 acr, uint32 address, bool supervisor)
+	{
+		if (!(acr & ACR_E))
+			return false;
+
+		auto s= (acr >> ACR_S_POS) & 3;
+		if (s == 0 && supervisor || s == 1 && !supervisor)
+			return false;
+
+		auto mask= ~(((acr >> ACR_MASK_POS) & 0xff) << 24) & ACR_BASE;
+		return ((address ^ acr) & mask) == 0;
+	}
+
+	Cache::Mode DataCacheMode(uint32 cm)
+	{
+		static const Cache::Mode modes[]= { Cache::WRITE_THROUGH, Cache::COPY_BACK, Cache::INHIBITED, Cache::INHIBITED };
+		return modes[cm & 3];
+	}
+}
+
+
+Cache::Mode CacheModel::InstructionMode(const CPU& cpu, uint32 address) const
+{
+	if (!icache_.Config().always_enabled && !(cpu.cacr & CACR_IEC))
+		return Cache::INHIBITED;
+
+	for (int i= 2; i < 4; ++i)
+		if (Matches(cpu.acr[i], address, cpu.Supervisor()))
+			return (cpu.acr[i] >> ACR_CM_POS) & 2 ? Cache::INHIBITED : Cache::WRITE_THROUGH;
+
+	return cpu.cacr & CACR_IDCM ? Cache::INHIBITED : Cache::WRITE_THROUGH;
+}
+
+
+Cache::Mode CacheModel::DataMode(const CPU& cpu, uint32 address) const
+{
+	if (!dcache_.Config().always_enabled && !(cpu.cacr & CACR_DEC))
+		return Cache::INHIBITED;
+
+	auto mode= DataCacheMode(cpu.cacr >> CACR_DDCM_POS);
+	for (int i= 0; i < 2; ++i)
+		if (Matches(cpu.acr[i], address, cpu.Supervisor()))
+		{
+			mode = DataCacheMode(cpu.acr[i] >> ACR_CM_POS);
+			break;
+		}
+
+	if (mode != Cache::INHIBITED)
+		switch (dcache_.Config().write_policy)
+		{
+		case CacheConfig::COPY_BACK:		return Cache::COPY_BACK;
+		case CacheConfig::WRITE_THROUGH:	return Cache::WRITE_THROUGH;
+		default:							break;
+		}
+
+	return mode;
+}
+
+
+uint32 CacheModel::Access(const CPU& cpu, uint32 address, int size, Kind kind)
+{
+	switch (kind)
+	{
+	case FETCH:
+		return icache_.Present() ? icache_.Read(address, size, InstructionMode(cpu, address)) : 0;
+
+	case READ:
+		return dcache_.Present() ? dcache_.Read(address, size, DataMode(cpu, address)) : 0;
+
+	case WRITE:
+		return dcache_.Present() ? dcache_.Write(address, size, DataMode(cpu, address)) : 0;
+	}
+
+	return 0;
+}
+
+
+void CacheModel::ControlChanged(uint32 cacr)
+{
+	if (cacr & CACR_DCINVA)
+		dcache_.InvalidateAll();
+	if (cacr & CACR_ICINVA)
+		icache_.InvalidateAll();
+}
+
+
+uint32 CacheModel::PushLine(const CPU& cpu, uint32 set_way, int caches)
+{
+	uint32 cycles= 0;
+	if (caches & 1)
+		cycles += dcache_.PushLine(set_way, !(cpu.cacr & CACR_DDPI));
+	if (caches & 2)
+		cycles += icache_.PushLine(set_way, !(cpu.cacr & CACR_IDPI));
+	return cycles;
+}
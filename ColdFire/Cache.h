@@ -0,0 +1,112 @@
+/*-----------------------------------------------------------------------------
+	ColdFire Macro Assembler and Simulator
+
+	Copyright (C) 2007-2012 Mike Kowalski
+
+	See License.txt for more details
+-----------------------------------------------------------------------------*/
+
+#pragma once
+#include "BasicTypes.h"
+#include "Types.h"
+
+class CPU;
+
+
+// Timing model of instruction and data caches controlled by CACR and ACR0-3 the way V4 cores do it
+// (ACR0/1 data, ACR2/3 instructions). Only tags are kept: memory is always up to date, so caches
+// change cycle counts and statistics, but never program behavior.
+
+struct CacheConfig
+{
+	CacheConfig();
+
+	enum WritePolicy { FOLLOW_CACR, COPY_BACK, WRITE_THROUGH };
+
+	uint32 size;				// in bytes; 0 - no cache, accesses cost nothing extra
+	uint32 ways;
+	uint32 line_size;
+	WritePolicy write_policy;	// cacheable data accesses: mode from CACR/ACR, or forced one
+	bool always_enabled;		// ignore CACR enable bit (for programs that don't configure caches)
+	uint32 hit_cycles;			// extra cycles of a hit
+	uint32 miss_cycles;			// line fill or dirty line write back
+	uint32 memory_cycles;		// single access bypassing the cache, or written through it
+};
+
+
+class Cache
+{
+public:
+	// throws RunTimeError if geometry is not valid
+	explicit Cache(const CacheConfig& config);
+
+	enum Mode { COPY_BACK, WRITE_THROUGH, INHIBITED };
+
+	bool Present() const						{ return !lines_.empty(); }
+	const CacheConfig& Config() const			{ return config_; }
+
+	// access of 'size' bytes at 'address'; returns its cost in cycles
+	uint32 Read(uint32 address, int size, Mode mode);
+	uint32 Write(uint32 address, int size, Mode mode);
+
+	// CPUSHL: write back line selected by set and way, and optionally invalidate it
+	uint32 PushLine(uint32 set_way, bool invalidate);
+
+	void InvalidateAll();
+
+	const cf::CacheStats& Stats() const			{ return stats_; }
+	void ClearStats()							{ stats_ = cf::CacheStats(); }
+
+private:
+	struct Line
+	{
+		uint32 tag;
+		uint64 used;	// LRU stamp
+		bool valid;
+		bool dirty;
+	};
+
+	// find line holding 'address'; on a miss allocates one (if 'fill') and adds fill costs to 'cycles'
+	Line* Lookup(uint32 address, bool fill, uint32& cycles);
+	uint32 Access(uint32 address, bool write, Mode mode);
+
+	CacheConfig config_;
+	uint32 line_shift_;
+	uint32 set_mask_;
+	std::vector<Line> lines_;	// sets one after another
+	uint64 clock_;
+	cf::CacheStats stats_;
+};
+
+
+class CacheModel
+{
+public:
+	CacheModel(const CacheConfig& instructions, const CacheConfig& data);
+
+	enum Kind { FETCH, READ, WRITE };
+
+	// CACR bits that trigger invalidation (data, branch, instruction cache); they are not stored
+	enum : uint32 { CACR_INVALIDATE= 0x01100100 };
+
+	// cost of memory access in cycles; cache mode is decided by CPU's CACR and ACRs
+	uint32 Access(const CPU& cpu, uint32 address, int size, Kind kind);
+
+	// CACR was written: invalidate caches if requested
+	void ControlChanged(uint32 cacr);
+
+	// CPUSHL; 'caches' is the cache field of an opcode (1 - data, 2 - instruction, 3 - both)
+	uint32 PushLine(const CPU& cpu, uint32 set_way, int caches);
+
+	Cache& Instructions()				{ return icache_; }
+	Cache& Data()						{ return dcache_; }
+	const Cache& Instructions() const	{ return icache_; }
+	const Cache& Data() const			{ return dcache_; }
+
+private:
+	Cache::Mode InstructionMode(const CPU& cpu, uint32 address) const;
+	Cache::Mode DataMode(const CPU& cpu, uint32 address) const;
+
+	Cache icache_;
+	Cache dcache_;
+};
@@ -11,7 +11,10 @@
 #include "Instruction.h"
 #include "InstructionRepository.h"
 #include <assert.h>
+#include <algorithm>
+#include <limits>
 #include "Exceptions.h"
+#include "Cache.h"
 
 namespace {
 	bool NoIO(uint32 addr, int access_size, uint32& ret_val, bool)
@@ -30,9 +33,19 @@ Context::Context(ISA isa) : instr_map_(isa), cpu_(isa)
 {
 	current_opcode_ = 0;
 	halted_ = false;
+	stopped_ = false;
 	cycles_ = 0;
 	instructions_ = 0;
+	side_effects_ = 0;
 	continue_on_exceptions_ = false;
+	watch_base_ = watch_span_ = 0;
+	irq_observer_ = nullptr;
+	stack_observer_ = nullptr;
+	mem_observer_ = nullptr;
+	cache_ = nullptr;
+	bus_lock_ = nullptr;
+	stall_cycles_ = 0;
+	observed_sp_ = 0;
 	peripheral_io_ = std::bind(&EmptyIO, std::placeholders::_1, std::placeholders::_2, std::placeholders::_3, std::placeholders::_4);
 	simulator_io_ = &NoIO;
 	current_opcode_addr_ = 0;
@@ -116,6 +129,68 @@ void Context::SetPeripheralCallback(const PeripheralCallback& io)
 	peripheral_io_ = io;
 }
 
+void Context::SetWriteWatch(const void* owner, uint32 base, uint32 size, const WriteWatch& fn)
+{
+	write_watches_.erase(std::remove_if(write_watches_.begin(), write_watches_.end(), [&](const Watch& w) { return w.owner == owner; }), write_watches_.end());
+
+	if (size != 0 && fn != nullptr)
+	{
+		Watch w= { owner, base, size, fn };
+		write_watches_.push_back(w);
+	}
+
+	// recalc range covering all watches
+	watch_base_ = watch_span_ = 0;
+	if (!write_watches_.empty())
+	{
+		uint64 lo= write_watches_.front().base, hi= lo;
+		for (auto& w : write_watches_)
+		{
+			lo = std::min<uint64>(lo, w.base);
+			hi = std::max<uint64>(hi, uint64(w.base) + w.size);
+		}
+		watch_base_ = static_cast<uint32>(lo);
+		watch_span_ = static_cast<uint32>(std::min<uint64>(hi - lo, 0xffffffff));
+	}
+}
+
+
+void Context::WatchedWrite(uint32 address, int size)
+{
+	// write may start below watched area; watchers only learn about the part they observe
+	WatchedBlockWrite(address, static_cast<uint32>(size));
+}
+
+
+// watchers only learn about the part they observe
+void Context::WatchedBlockWrite(uint32 address, uint32 length)
+{
+	for (auto& w : write_watches_)
+	{
+		auto lo= std::max<uint64>(address, w.base);
+		auto hi= std::min<uint64>(uint64(address) + length, uint64(w.base) + w.size);
+		if (lo < hi)
+			w.fn(static_cast<uint32>(lo), static_cast<int>(hi - lo));
+	}
+}
+
+
+void Context::SetTrapHandler(int trap, const TrapHandler& handler)
+{
+	if (trap < 0 || trap > 15)
+		throw LogicError("invalid trap number in " __FUNCTION__);
+
+	trap_handlers_[trap] = handler;
+}
+
+
+bool Context::NativeTrap(int trap)
+{
+	auto& handler= trap_handlers_[trap & 0xf];
+	return handler != nullptr && handler(*this);
+}
+
+
 void Context::SetExceptionCallback(const ExceptionCallback& ex)
 {
 	exception_callback_ = ex;
@@ -256,6 +331,13 @@ int InstrSizeToAccessSize(InstrSize size)
 
 uint32 Context::ReadFromAddress(const DecodedAddress& da, InstrSize size, bool disable_io/*= false*/) const
 {
+	// opcodes, their extension words and immediate data come through the fetch path
+	if (mem_observer_ && da.type != DecodedAddress::REGISTER)
+		mem_observer_->Accessed(da, InstrSizeToAccessSize(size), da.fetch ? MemoryObserver::Fetch : MemoryObserver::Read, current_opcode_addr_);
+
+	if (cache_ && (da.type == DecodedAddress::RAM || da.type == DecodedAddress::FLASH))
+		stall_cycles_ += cache_->Access(cpu_, da.cf_addr, InstrSizeToAccessSize(size), da.fetch ? CacheModel::FETCH : CacheModel::READ);
+
 	switch (da.type)
 	{
 	case DecodedAddress::RAM:		// RAM
@@ -313,6 +395,7 @@ uint32 Context::ReadFromAddress(const DecodedAddress& da, InstrSize size, bool d
 
 		assert(da.big_endian);
 		assert(size != S_NA);
+		++side_effects_;	// simulator I/O is serviced by the client; any access may change something
 		uint32 val= 0;
 		if (!simulator_io_(da.cf_addr, InstrSizeToAccessSize(size), val, true))
 			throw MemoryAccessException(da.cf_addr);
@@ -325,6 +408,15 @@ uint32 Context::ReadFromAddress(const DecodedAddress& da, InstrSize size, bool d
 
 void Context::WriteToAddress(const DecodedAddress& da, uint32 value, InstrSize size)
 {
+	if (da.type != DecodedAddress::REGISTER)
+	{
+		++side_effects_;
+		if (mem_observer_)
+			mem_observer_->Accessed(da, InstrSizeToAccessSize(size), MemoryObserver::Write, current_opcode_addr_);
+		if (cache_ && da.type == DecodedAddress::RAM)
+			stall_cycles_ += cache_->Access(cpu_, da.cf_addr, InstrSizeToAccessSize(size), CacheModel::WRITE);
+	}
+
 	switch (da.type)
 	{
 	case DecodedAddress::RAM:
@@ -368,6 +460,9 @@ void Context::WriteToAddress(const DecodedAddress& da, uint32 value, InstrSize s
 		default:
 			throw RunTimeError("Illegal size " __FUNCTION__);
 		}
+
+		if ((da.cf_addr - watch_base_ < watch_span_ || watch_base_ - da.cf_addr < static_cast<uint32>(InstrSizeToAccessSize(size))) && da.type == DecodedAddress::RAM)
+			WatchedWrite(da.cf_addr, InstrSizeToAccessSize(size));
 		break;
 
 	case DecodedAddress::FLASH:
@@ -472,12 +567,18 @@ void Context::EnterException(CpuExceptions vector, uint32 address)
 	}
 
 	cpu_.EnterException(vector, current_opcode_addr_);
+
+	if (stack_observer_)
+		CheckStack(current_opcode_addr_);
+
+	// exception processing (interrupt, in particular) is what brings CPU out of a STOP state
+	stopped_ = false;
 }
 
 
 const Instruction* Context::ExecuteInstruction(bool continue_on_exceptions)
 {
-	if (halted_)
+	if (halted_ || stopped_)
 		return nullptr;
 
 	const Instruction* i= nullptr;
@@ -515,9 +616,13 @@ const Instruction* Context::ExecuteInstruction(bool continue_on_exceptions)
 		else
 			i->Execute(*this);
 
-		cycles_ += i->Cycles();	// TODO: take addressing modes into account
+		cycles_ += i->Cycles() + stall_cycles_;	// TODO: take addressing modes into account
+		stall_cycles_ = 0;
 		instructions_++;
 
+		if (stack_observer_)
+			CheckStack(current_opcode_addr_);
+
 		// todo: find right placement for trace
 		if (cpu_.Trace())
 			EnterException(EX_Trace, cpu_.pc);
@@ -548,9 +653,20 @@ void Context::HaltExecution(bool halt)
 
 void Context::EnterStopState()
 {
-	//todo
-	// stop normal execution
-	// only interrupts enabled
+	// stop normal execution; only interrupts (or reset) can resume it
+	stopped_ = true;
+}
+
+
+void Context::ExitStopState()
+{
+	stopped_ = false;
+}
+
+
+bool Context::IsInStopState() const
+{
+	return stopped_;
 }
 
 
@@ -643,12 +759,12 @@ DecodedAddress Context::GetMemoryAddress(uint32 addr, uint32 size, bool no_throw
 						switch (m.access_)
 						{
 						case cf::MemoryAccess::Normal:
-							ASSERT(m.mem_.size() == m.end_ - m.base_ + 1);
-							return DecodedAddress(&m.mem_[addr - m.base_], addr, DecodedAddress::RAM);
+							ASSERT(m.mem_->size() == m.end_ - m.base_ + 1);
+							return DecodedAddress(&(*m.mem_)[addr - m.base_], addr, DecodedAddress::RAM);
 
 						case cf::MemoryAccess::ReadOnly:
-							ASSERT(m.mem_.size() == m.end_ - m.base_ + 1);
-							return DecodedAddress(&m.mem_[addr - m.base_], addr, DecodedAddress::FLASH);
+							ASSERT(m.mem_->size() == m.end_ - m.base_ + 1);
+							return DecodedAddress(&(*m.mem_)[addr - m.base_], addr, DecodedAddress::FLASH);
 
 						case cf::MemoryAccess::Null:
 							return DecodedAddress(static_cast<void*>(nullptr), addr, DecodedAddress::NONE);
@@ -708,6 +824,20 @@ uint32 Context::GetLongWord(uint32 addr) const
 	return ReadFromAddress(da, S_LONG);
 }
 
+uint16 Context::FetchWord(uint32 addr) const
+{
+	DecodedAddress da= GetMemoryAddress(addr, S_WORD);
+	da.fetch = true;
+	return static_cast<uint16>(ReadFromAddress(da, S_WORD));
+}
+
+uint32 Context::FetchLongWord(uint32 addr) const
+{
+	DecodedAddress da= GetMemoryAddress(addr, S_LONG);
+	da.fetch = true;
+	return ReadFromAddress(da, S_LONG);
+}
+
 
 Context::Memory::Memory()
 {
@@ -724,7 +854,7 @@ Context::Memory::Memory(std::string name, uint32 base, uint32 end, cf::MemoryAcc
 	end_ = end;
 	access_ = access;
 	if (access != cf::MemoryAccess::Null)
-		mem_.resize(static_cast<size_t>(end) - base + 1, 0);
+		mem_ = std::make_shared<std::vector<uint8>>(static_cast<size_t>(end) - base + 1, 0);
 }
 
 
@@ -743,6 +873,12 @@ void Context::InitMemory(std::string name, uint32 base_addr, uint32 mem_size, in
 }
 
 
+void Context::ShareMemory(const Context& other)
+{
+	memory_banks_ = other.memory_banks_;
+}
+
+
 std::size_t Context::GetMemoryBankCount() const
 {
 	return memory_banks_.size();
@@ -756,7 +892,10 @@ void Context::ClearMemory(int bank)
 	{
 		auto& mem= memory_banks_[index];
 		if (mem.access_ != cf::MemoryAccess::Null)
-			std::fill(begin(mem.mem_), end(mem.mem_), 0);
+		{
+			std::fill(begin(*mem.mem_), end(*mem.mem_), 0);
+			WatchedBlockWrite(mem.base_, static_cast<uint32>(mem.mem_->size()));
+		}
 	}
 }
 
@@ -769,7 +908,10 @@ void Context::ZeroMemory(uint32 address, uint32 size)
 	if (size > 0)
 	{
 		if (da.type == DecodedAddress::RAM || da.type == DecodedAddress::FLASH)
+		{
 			memset(da.address, 0, size);
+			WatchedBlockWrite(address, size);
+		}
 		else
 			throw RunTimeError("Invalid memory type for clearing " __FUNCTION__);
 	}
@@ -821,6 +963,41 @@ cf::uint32 Context::ReadMemory(cf::uint8* dest_buf, cf::uint32 address, cf::uint
 }
 
 
+bool Context::WriteMemory(uint32 address, const cf::uint8* src_buf, uint32 length)
+{
+	if (length == 0)
+		return true;
+
+	auto to= GetMemoryAddress(address, length, true);
+	if (to.type != DecodedAddress::RAM)
+		return false;
+
+	memcpy(to.address, src_buf, length);
+	++side_effects_;
+	WatchedBlockWrite(address, length);
+
+	return true;
+}
+
+
+bool Context::CopyMemory(uint32 dest, uint32 src, uint32 length)
+{
+	if (length == 0)
+		return true;
+
+	auto from= GetMemoryAddress(src, length, true);
+	auto to= GetMemoryAddress(dest, length, true);
+	if ((from.type != DecodedAddress::RAM && from.type != DecodedAddress::FLASH) || to.type != DecodedAddress::RAM)
+		return false;
+
+	memmove(to.address, from.address, length);
+	++side_effects_;
+	WatchedBlockWrite(dest, length);
+
+	return true;
+}
+
+
 cf::MemoryBankInfo Context::GetMemoryBankInfo(int bank) const
 {
 	size_t index= bank;
@@ -844,7 +1021,11 @@ void Context::CopyProgram(const uint8* begin, const uint8* end, uint32 start_add
 	if (size > 0)
 	{
 		if (da.type == DecodedAddress::RAM || da.type == DecodedAddress::FLASH)
+		{
 			memcpy(da.address, begin, size);
+			// memory mapped displays need to see program loads and debugger edits too
+			WatchedBlockWrite(start_address, uint32(size));
+		}
 		else
 			throw RunTimeError("Invalid memory type for copying program to; " __FUNCTION__);
 	}
@@ -883,6 +1064,14 @@ void Context::InterruptAssert(int interrupt_source, CpuExceptions vector)
 	// route it to the system integration module or interrupt controller module(s)
 	for (auto icm : icms_)
 		icm->InterruptAssert(interrupt_source, vector);
+
+	if (irq_observer_)
+	{
+		int level= 0;
+		for (auto icm : icms_)
+			level = std::max(level, icm->InterruptLevel(interrupt_source));
+		irq_observer_->Asserted(interrupt_source, level, TotalCycles());
+	}
 }
 
 
@@ -890,6 +1079,75 @@ void Context::InterruptClear(int interrupt_source)
 {
 	for (auto icm : icms_)
 		icm->InterruptClear(interrupt_source);
+
+	if (irq_observer_)
+		irq_observer_->Cleared(interrupt_source, TotalCycles());
+}
+
+
+void Context::EnterInterrupt(int interrupt_source, CpuExceptions vector, int level)
+{
+	EnterException(vector, cpu_.pc);
+
+	if (irq_observer_)
+		irq_observer_->Entered(interrupt_source, level, TotalCycles());
+
+	cpu_.SetInterruptLevel(level);
+}
+
+
+void Context::SetInterruptObserver(InterruptObserver* observer)
+{
+	irq_observer_ = observer;
+}
+
+
+void Context::InterruptMaskChanged(int mask)
+{
+	if (irq_observer_)
+		irq_observer_->MaskChanged(mask, TotalCycles());
+}
+
+
+void Context::SetMemoryObserver(MemoryObserver* observer)
+{
+	mem_observer_ = observer;
+}
+
+
+void Context::SetCacheModel(CacheModel* caches)
+{
+	cache_ = caches;
+	stall_cycles_ = 0;
+}
+
+
+void Context::SetCACR(uint32 cacr)
+{
+	if (cache_)
+		cache_->ControlChanged(cacr);
+
+	cpu_.cacr = cacr & ~CacheModel::CACR_INVALIDATE;
+}
+
+
+void Context::PushCacheLine(uint32 set_way, int caches)
+{
+	if (cache_)
+		stall_cycles_ += cache_->PushLine(cpu_, set_way, caches);
+}
+
+
+void Context::SetStackObserver(StackObserver* observer)
+{
+	stack_observer_ = observer;
+
+	// report current stack pointer right away
+	if (stack_observer_)
+	{
+		observed_sp_ = ~cpu_.a_reg[7];
+		CheckStack(cpu_.pc);
+	}
 }
 
 
@@ -899,13 +1157,43 @@ void Context::SetICM(std::vector<InterruptController*> icms)
 }
 
 
+const std::vector<InterruptController*>& Context::GetICM() const
+{
+	return icms_;
+}
+
+
+void Context::SetBusLock(std::mutex* lock)
+{
+	bus_lock_ = lock;
+}
+
+
+std::unique_lock<std::mutex> Context::LockBus()
+{
+	return bus_lock_ ? std::unique_lock<std::mutex>(*bus_lock_) : std::unique_lock<std::mutex>();
+}
+
+
 uint32 Context::CyclesTaken() const
 {
-	return cycles_;
+	return static_cast<uint32>(cycles_);
 }
 
 
 uint32 Context::ExecutedInstructions() const
+{
+	return static_cast<uint32>(instructions_);
+}
+
+
+uint64 Context::TotalCycles() const
+{
+	return cycles_;
+}
+
+
+uint64 Context::TotalInstructions() const
 {
 	return instructions_;
 }
@@ -917,10 +1205,35 @@ void Context::ZeroStats()
 	instructions_ = 0;
 }
 
+
+void Context::SkipCycles(uint32 cycles, uint32 instructions/*= 0*/)
+{
+	cycles_ += cycles;
+	instructions_ += instructions;
+}
+
+
+void Context::SetTotalCycles(uint64 cycles)
+{
+	cycles_ = cycles;
+}
+
+
+uint32 Context::SideEffects() const
+{
+	return side_effects_;
+}
+
+
+void Context::NoteSideEffect()
+{
+	++side_effects_;
+}
+
 /////////////////////////////////////////////////////////////////////////////////////////////////////////
 
 
-uint16 CPU::GetSR()
+uint16 CPU::GetSR() const
 {
 	uint16 reg= sr.sr & uint16(~0x1f);
 
@@ -955,6 +1268,8 @@ void CPU::SetSR(uint16 new_sr)
 	else if (!sr.s && (new_sr & cf::SR_SUPERVISOR))
 		EnterSupervisorState();	// this can happen when use changes SR register manually
 
+	int mask= sr.i;
+
 	sr.sr = new_sr;
 	sr.reserved1 = 0;
 	sr.reserved2 = 0;
@@ -962,6 +1277,20 @@ void CPU::SetSR(uint16 new_sr)
 
 	// change flags
 	SetCCR(new_sr);
+
+	if (sr.i != mask && ctx_)
+		ctx_->InterruptMaskChanged(sr.i);
+}
+
+
+void CPU::SetInterruptLevel(int level)
+{
+	if (sr.i == level)
+		return;
+
+	sr.i = level;
+	if (ctx_)
+		ctx_->InterruptMaskChanged(level);
 }
 
 
@@ -1041,7 +1370,7 @@ void CPU::EnterException(CpuExceptions vector, uint32 opcode_addr)
 
 		pc = addr;
 
-		ctx_->GetWord(pc);	// try to fetch first opcode of the exception handler routine
+		ctx_->FetchWord(pc);	// try to fetch first opcode of the exception handler routine
 	}
 	catch (McuException&)
 	{
@@ -1081,6 +1410,13 @@ void CPU::ResetRegs()
 
 	mbar = default_mbar_ & CPU::MBAR_ADDR_MASK;	// MCU-specific address
 
+	cacr = 0;
+	std::fill_n(acr, array_count(acr), 0);
+
+	// FPU data registers come out of reset holding NaNs
+	std::fill_n(fp, array_count(fp), std::numeric_limits<double>::quiet_NaN());
+	fpcr = fpsr = fpiar = 0;
+
 	rambar1 = 0;	// currently those are not used
 	rambar2 = 0;
 	rombar1 = 0;
@@ -1099,6 +1435,8 @@ void CPU::ResetRegs()
 		assert(false);
 		break;
 	}
+	if (IsIsaPresent(isa_, ISA::FPU))
+		d_reg[0] |= 0x1000;
 
 	//todo: D1 - Local Memory Configuration
 	//
@@ -1179,7 +1517,7 @@ uint32 Context::DecodeEffectiveAddress(uint16 mode_reg, int& ext_words)
 
 	case 5:		// d16(An)
 		{
-			auto disp= SignExtendWord(GetWord(cpu_.pc + ext_words));
+			auto disp= SignExtendWord(FetchWord(cpu_.pc + ext_words));
 			++ext_words;
 			return cpu_.a_reg[reg] + disp;
 		}
@@ -1187,7 +1525,7 @@ uint32 Context::DecodeEffectiveAddress(uint16 mode_reg, int& ext_words)
 	case 6:		// d8(An, Xn*s)
 		{
 			ExtensionWordFmt_DISP_REG_IDX ext;
-			ext.word = GetWord(cpu_.pc + ext_words * 2);
+			ext.word = FetchWord(cpu_.pc + ext_words * 2);
 			++ext_words;
 
 			// scaled index register (should be signed when word size, 68k only):
@@ -1202,21 +1540,21 @@ uint32 Context::DecodeEffectiveAddress(uint16 mode_reg, int& ext_words)
 		{
 		case 0:		// (xxxx).W
 			{
-				auto addr= SignExtendWord(GetWord(cpu_.pc + ext_words * 2));
+				auto addr= SignExtendWord(FetchWord(cpu_.pc + ext_words * 2));
 				++ext_words;
 				return addr;
 			}
 
 		case 1:		// (xxxxxxxx).L
 			{
-				uint32 addr= GetLongWord(cpu_.pc + ext_words * 2);
+				uint32 addr= FetchLongWord(cpu_.pc + ext_words * 2);
 				ext_words += 2;
 				return addr;
 			}
 
 		case 2:		// d16(PC)
 			{
-				auto disp= SignExtendWord(GetWord(cpu_.pc + ext_words * 2));
+				auto disp= SignExtendWord(FetchWord(cpu_.pc + ext_words * 2));
 				++ext_words;
 				return cpu_.pc + disp;
 			}
@@ -1224,7 +1562,7 @@ uint32 Context::DecodeEffectiveAddress(uint16 mode_reg, int& ext_words)
 		case 3:		// d8(PC, Xn*s)
 			{
 				ExtensionWordFmt_DISP_REG_IDX ext;
-				ext.word = GetWord(cpu_.pc);
+				ext.word = FetchWord(cpu_.pc);
 				++ext_words;
 
 				// scaled index register (should be signed when word size, 68k only):
@@ -1285,7 +1623,7 @@ DecodedAddress Context::DecodeMemoryAddress(uint16 mode_reg, InstrSize& size, in
 
 	case 5:		// d16(An)
 		{
-			auto disp= SignExtendWord(GetWord(cpu_.pc + ext_words * 2));
+			auto disp= SignExtendWord(FetchWord(cpu_.pc + ext_words * 2));
 			++ext_words;
 			return GetMemoryAddress(cpu_.a_reg[reg] + disp, size);
 		}
@@ -1293,7 +1631,7 @@ DecodedAddress Context::DecodeMemoryAddress(uint16 mode_reg, InstrSize& size, in
 	case 6:		// d8(An, Xn*s)
 		{
 			ExtensionWordFmt_DISP_REG_IDX ext;
-			ext.word = GetWord(cpu_.pc + ext_words * 2);
+			ext.word = FetchWord(cpu_.pc + ext_words * 2);
 			++ext_words;
 
 			// scaled index register (should be signed when word size, 68k only):
@@ -1308,21 +1646,21 @@ DecodedAddress Context::DecodeMemoryAddress(uint16 mode_reg, InstrSize& size, in
 		{
 		case 0:		// (xxxx).W
 			{
-				auto addr= SignExtendWord(GetWord(cpu_.pc + ext_words * 2));
+				auto addr= SignExtendWord(FetchWord(cpu_.pc + ext_words * 2));
 				++ext_words;
 				return GetMemoryAddress(addr, size);
 			}
 
 		case 1:		// (xxxxxxxx).L
 			{
-				uint32 addr= GetLongWord(cpu_.pc + ext_words * 2);
+				uint32 addr= FetchLongWord(cpu_.pc + ext_words * 2);
 				ext_words += 2;
 				return GetMemoryAddress(addr, size);
 			}
 
 		case 2:		// d16(PC)
 			{
-				auto disp= SignExtendWord(GetWord(cpu_.pc + ext_words * 2));
+				auto disp= SignExtendWord(FetchWord(cpu_.pc + ext_words * 2));
 				++ext_words;
 				return GetMemoryAddress(cpu_.pc + disp, size);
 			}
@@ -1330,7 +1668,7 @@ DecodedAddress Context::DecodeMemoryAddress(uint16 mode_reg, InstrSize& size, in
 		case 3:		// d8(PC, Xn*s)
 			{
 				ExtensionWordFmt_DISP_REG_IDX ext;
-				ext.word = GetWord(cpu_.pc);
+				ext.word = FetchWord(cpu_.pc);
 				++ext_words;
 
 				// scaled index register (should be signed when word size, 68k only):
@@ -1343,6 +1681,7 @@ DecodedAddress Context::DecodeMemoryAddress(uint16 mode_reg, InstrSize& size, in
 		case 4:		// #nnnnnnnnn
 			{
 				DecodedAddress da= GetMemoryAddress(cpu_.pc, size);
+				da.fetch = true;
 				if (size == S_LONG)
 					ext_words += 2;
 				else
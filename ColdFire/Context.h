@@ -13,6 +13,9 @@
 #include "CpuExceptions.h"
 #include "InstructionMap.h"
 #include "InterruptController.h"
+#include <mutex>
+
+class CacheModel;
 
 #undef OVERFLOW		// undef offensive definition from math.h
 
@@ -71,24 +74,25 @@ struct DecodedAddress
 	};
 
 	DecodedAddress(const void* address, uint32 cf_addr, AddrType type)
-		: address(const_cast<void*>(address)), big_endian(true), type(type), cf_addr(cf_addr)
+		: address(const_cast<void*>(address)), big_endian(true), type(type), fetch(false), cf_addr(cf_addr)
 	{}
 
 	DecodedAddress(void* address, uint32 cf_addr, AddrType type)
-		: address(address), big_endian(true), type(type), cf_addr(cf_addr)
+		: address(address), big_endian(true), type(type), fetch(false), cf_addr(cf_addr)
 	{}
 
 	DecodedAddress(void* address, uint32 cf_addr, AddrType type, bool big_endian)
-		: address(address), big_endian(big_endian), type(type), cf_addr(cf_addr)
+		: address(address), big_endian(big_endian), type(type), fetch(false), cf_addr(cf_addr)
 	{}
 
 	DecodedAddress(uint32 port, AddrType type)
-		: address(nullptr), type(type), cf_addr(port), big_endian(true)
+		: address(nullptr), type(type), cf_addr(port), big_endian(true), fetch(false)
 	{}
 
 	void* address;	// decoded, physical address (not visible to code executing on CF)
 	bool big_endian;
 	AddrType type;
+	bool fetch;		// instruction stream: opcode, its extension words or immediate data
 	uint32 cf_addr;	// original address as seen by ColdFire
 };
 
@@ -122,7 +126,7 @@ public:
 	std::pair<uint32, uint32> GetStackPointers() const;
 
 	void SetSR(uint16 sr);
-	uint16 GetSR();
+	uint16 GetSR() const;
 	void SetCCR(uint16 ccr);
 
 	void EnterSupervisorState();
@@ -131,7 +135,7 @@ public:
 	bool Supervisor() const				{ return !!sr.s; }
 	bool Trace() const					{ return !!sr.t; }
 	int InterruptLevel() const			{ return sr.i; }
-	void SetInterruptLevel(int level)	{ sr.i = level; }
+	void SetInterruptLevel(int level);
 
 	void EnterException(CpuExceptions vector, uint32 opcode_addr);
 
@@ -179,6 +183,15 @@ public:
 #endif
 	enum : uint32 { MBAR_ADDR_MASK= 0xfffff000 };
 
+	uint32 cacr;		// cache control (invalidate bits always read as 0)
+	uint32 acr[4];		// access control
+
+	// FPU registers
+	double fp[8];
+	uint32 fpcr;		// control: exception enables, rounding precision and mode
+	uint32 fpsr;		// status: condition codes, exception status and accrued exceptions
+	uint32 fpiar;		// address of the last arithmetic FPU instruction
+
 	uint32 rambar1;
 	uint32 rambar2;
 	uint32 rombar1;
@@ -235,6 +248,46 @@ struct ExceptionReported
 {};
 
 
+// receives interrupt life cycle events for instrumentation purposes; times are total simulated cycles
+class InterruptObserver
+{
+public:
+	virtual ~InterruptObserver() {}
+
+	// peripheral raised or withdrew its request; 'level' is the one configured in interrupt controller
+	virtual void Asserted(int source, int level, uint64 at) = 0;
+	virtual void Cleared(int source, uint64 at) = 0;
+	// CPU accepted request and entered its handler
+	virtual void Entered(int source, int level, uint64 at) = 0;
+	// CPU interrupt priority mask changed
+	virtual void MaskChanged(int mask, uint64 at) = 0;
+};
+
+
+// receives new values of A7 after instructions and exceptions that change it
+class StackObserver
+{
+public:
+	virtual ~StackObserver() {}
+
+	// 'supervisor' tells which stack A7 is; 'pc' is the address of instruction that moved it
+	virtual void StackMoved(uint32 sp, bool supervisor, uint32 pc) = 0;
+};
+
+
+// receives every memory and peripheral access (registers excluded)
+class MemoryObserver
+{
+public:
+	virtual ~MemoryObserver() {}
+
+	enum Kind { Fetch, Read, Write };
+
+	// 'pc' is the address of instruction making the access
+	virtual void Accessed(const DecodedAddress& da, int access_size, Kind kind, uint32 pc) = 0;
+};
+
+
 class Context
 {
 public:
@@ -256,6 +309,18 @@ public:
 	// read memory content and copy it to the provided buffer
 	cf::uint32 ReadMemory(cf::uint8* dest_buf, cf::uint32 address, cf::uint32 length);
 
+	// copy buffer to RAM, as if CPU wrote it; range has to fit in a single bank, otherwise nothing is copied
+	// and false is returned
+	bool WriteMemory(uint32 address, const cf::uint8* src_buf, uint32 length);
+
+	// copy 'length' bytes from RAM/flash to RAM, as if CPU wrote them; both ranges have to fit in single banks,
+	// otherwise nothing is copied and false is returned
+	bool CopyMemory(uint32 dest, uint32 src, uint32 length);
+
+	// use memory banks of 'other' context (they are shared, not copied); banks defined by 'other'
+	// later on are not visible here till this call is repeated
+	void ShareMemory(const Context& other);
+
 	// report configured memory area; currently bank = 0 is RAM, bank = 1 is flash
 	cf::MemoryBankInfo GetMemoryBankInfo(int bank) const;
 
@@ -268,14 +333,17 @@ public:
 	uint16 GetWord(uint32 addr) const;
 	int16 GetSWord(uint32 addr) const;
 	uint32 GetLongWord(uint32 addr) const;
+	// same, but reading instruction stream (for memory observer and cache model)
+	uint16 FetchWord(uint32 addr) const;
+	uint32 FetchLongWord(uint32 addr) const;
 
 	// low level routines for memory and peripherals read/write access
 	uint32 ReadFromAddress(const DecodedAddress& da, InstrSize size, bool disable_io= false) const;
 	void WriteToAddress(const DecodedAddress& da, uint32 value, InstrSize size);
 
 	// convenience functions to read word from (PC), and advance program counter
-	uint16 GetNextPCWord()				{ uint16 v= GetWord(cpu_.pc); cpu_.pc += 2; return v; }
-	uint32 GetNextPCLongWord()			{ uint32 v= GetLongWord(cpu_.pc); cpu_.pc += 4; return v; }
+	uint16 GetNextPCWord()				{ uint16 v= FetchWord(cpu_.pc); cpu_.pc += 2; return v; }
+	uint32 GetNextPCLongWord()			{ uint32 v= FetchLongWord(cpu_.pc); cpu_.pc += 4; return v; }
 
 	// this memory read ignores peripherals; used by disassembler to avoid triggering IO changes
 	uint16 ReadMemoryWord(uint32 addr) const;
@@ -326,13 +394,18 @@ public:
 
 	const Instruction* ExecuteInstruction(bool continue_on_exceptions);
 	void HaltExecution(bool halt);
+
+	// low-power STOP state; instructions are not executed until CPU enters exception (interrupt)
 	void EnterStopState();
+	void ExitStopState();
+	bool IsInStopState() const;
 
 	bool IsExecutionHalted() const;
 
 	void EnterException(CpuExceptions vector, uint32 address);
 
 	CPU& Cpu()							{ return cpu_; }
+	const CPU& Cpu() const				{ return cpu_; }
 
 	// CCR
 	bool Carry() const					{ return cpu_.carry; }
@@ -395,17 +468,69 @@ public:
 	typedef std::function<bool (uint32 address, CpuExceptions vector, uint32 pc)> ExceptionCallback;
 	void SetExceptionCallback(const ExceptionCallback& ex);
 
+	// watch CPU writes to RAM in [base, base + size) range; 'fn(address, size)' is called after each such write;
+	// there is one watch per owner, size 0 removes owner's watch
+	typedef std::function<void (uint32 address, int size)> WriteWatch;
+	void SetWriteWatch(const void* owner, uint32 base, uint32 size, const WriteWatch& fn);
+
+	// native (host side) implementation of TRAP #n services; handler returns true if it has performed
+	// the service, false to let CPU enter trap exception as usual
+	typedef std::function<bool (Context& ctx)> TrapHandler;
+	void SetTrapHandler(int trap, const TrapHandler& handler);
+	bool NativeTrap(int trap);
+
 	// pass interrupt requests to system integration module
 	void InterruptAssert(int interrupt_source, CpuExceptions vector);
 	void InterruptClear(int interrupt_source);
 
+	// used by interrupt controller to enter handler of 'interrupt_source' and raise CPU's priority mask to 'level'
+	void EnterInterrupt(int interrupt_source, CpuExceptions vector, int level);
+
+	// optional observer of interrupt requests (non-owning pointer, nullptr to remove)
+	void SetInterruptObserver(InterruptObserver* observer);
+	// called by CPU when its interrupt priority mask changes
+	void InterruptMaskChanged(int mask);
+
+	// optional observer of stack pointer (non-owning pointer, nullptr to remove)
+	void SetStackObserver(StackObserver* observer);
+
+	// optional observer of memory accesses (non-owning pointer, nullptr to remove)
+	void SetMemoryObserver(MemoryObserver* observer);
+
+	// optional cache timing model (non-owning pointer, nullptr to remove); cycles of RAM and flash
+	// accesses it reports are added to the cycle counter with the instruction making them
+	void SetCacheModel(CacheModel* caches);
+	const CacheModel* GetCacheModel() const		{ return cache_; }
+	// MOVEC to CACR and CPUSHL
+	void SetCACR(uint32 cacr);
+	void PushCacheLine(uint32 set_way, int caches);
+
 	void SetICM(std::vector<InterruptController*> icms);
+	const std::vector<InterruptController*>& GetICM() const;
+
+	// lock held by instructions performing indivisible read-modify-write cycles (non-owning pointer shared
+	// by all cores; nullptr if there's only one)
+	void SetBusLock(std::mutex* lock);
+	std::unique_lock<std::mutex> LockBus();
 
 	//TODO:
 	// approx cycle count for running program, increased continually with each executed instruction
 	uint32 CyclesTaken() const;
 	uint32 ExecutedInstructions() const;
+	// full 64-bit counters; CyclesTaken and ExecutedInstructions are their low words
+	uint64 TotalCycles() const;
+	uint64 TotalInstructions() const;
 	void ZeroStats();
+	// advance cycle counter without executing any instructions (time spent waiting in a STOP state);
+	// 'instructions' is a count of instructions simulator decided not to execute (skipped idle loop)
+	void SkipCycles(uint32 cycles, uint32 instructions= 0);
+	// set cycle counter (cores of a multi-core board share time base of core 0)
+	void SetTotalCycles(uint64 cycles);
+
+	// count of memory writes and I/O accesses with side effects; if it doesn't change while
+	// CPU spins in a loop, then the loop only observes the state of the system
+	uint32 SideEffects() const;
+	void NoteSideEffect();
 
 	//temporarily:
 	//std::vector<uint8>& GetRAMRawPointer() { return memory_banks_.at(0).mem_; }
@@ -430,13 +555,43 @@ private:
 	PeripheralCallback peripheral_io_;
 	PeripheralCallback simulator_io_;
 	bool halted_;
+	bool stopped_;
 	ExceptionCallback exception_callback_;
+	TrapHandler trap_handlers_[16];
+	InterruptObserver* irq_observer_;
+	StackObserver* stack_observer_;
+	MemoryObserver* mem_observer_;
+	CacheModel* cache_;
+	mutable uint32 stall_cycles_;	// cache cycles not yet added to the cycle counter
+	uint32 observed_sp_;
+	void CheckStack(uint32 pc)
+	{
+		if (cpu_.a_reg[7] != observed_sp_)
+		{
+			observed_sp_ = cpu_.a_reg[7];
+			stack_observer_->StackMoved(observed_sp_, cpu_.Supervisor(), pc);
+		}
+	}
+	struct Watch
+	{
+		const void* owner;
+		uint32 base;
+		uint32 size;
+		WriteWatch fn;
+	};
+	std::vector<Watch> write_watches_;
+	uint32 watch_base_;		// range covering all watches, for quick rejection
+	uint32 watch_span_;
+	void WatchedWrite(uint32 address, int size);
+	void WatchedBlockWrite(uint32 address, uint32 length);
 	uint32 current_opcode_addr_;
 	std::vector<InterruptController*> icms_;	// interrupt controller module, if any (non-owning pointers)
+	std::mutex* bus_lock_;
 	uint32 simulator_peripherals_;				// simulator i/o area, not part of any real MCU
 	bool exception_notify_[EX_SIZE];			// which notifications are reported to the simulator
-	uint32 cycles_;
-	uint32 instructions_;
+	uint64 cycles_;
+	uint64 instructions_;
+	mutable uint32 side_effects_;
 	bool continue_on_exceptions_;
 	struct Memory
 	{
@@ -445,7 +600,7 @@ private:
 
 		uint32 base_;							// base address
 		uint32 end_;							// last valid byte
-		std::vector<uint8> mem_;				// memory buffer (could be empty)
+		std::shared_ptr<std::vector<uint8>> mem_;	// memory buffer (could be empty); shared by cores
 		cf::MemoryAccess access_;				// access type
 		std::string name_;						// name
 	};
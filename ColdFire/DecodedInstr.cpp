@@ -609,6 +609,18 @@ const char* GetSpecialRegisterName(SpecialRegister reg)
 	case REG_ACC3:		return "ACC3";
 	case REG_ACCext01:	return "ACCext01";
 	case REG_ACCext02:	return "ACCext02";
+	// FPU
+	case REG_FP0:		return "FP0";
+	case REG_FP1:		return "FP1";
+	case REG_FP2:		return "FP2";
+	case REG_FP3:		return "FP3";
+	case REG_FP4:		return "FP4";
+	case REG_FP5:		return "FP5";
+	case REG_FP6:		return "FP6";
+	case REG_FP7:		return "FP7";
+	case REG_FPCR:		return "FPCR";
+	case REG_FPSR:		return "FPSR";
+	case REG_FPIAR:	return "FPIAR";
 
 	default:
 		throw LogicError("missing spec reg name " __FUNCTION__);
@@ -62,6 +62,18 @@ enum SpecialRegister	// special and control registers
 	REG_ACC3,
 	REG_ACCext01,
 	REG_ACCext02,
+	// FPU
+	REG_FP0,
+	REG_FP1,
+	REG_FP2,
+	REG_FP3,
+	REG_FP4,
+	REG_FP5,
+	REG_FP6,
+	REG_FP7,
+	REG_FPCR,
+	REG_FPSR,
+	REG_FPIAR,
 };
 
 
@@ -272,6 +284,8 @@ struct CF_DECL DecodedInstruction	// decoded instruction info
 		case S_BYTE:	return ".B";
 		case S_WORD:	return ".W";
 		case S_LONG:	return ".L";
+		case S_SINGLE:	return ".S";
+		case S_DOUBLE:	return ".D";
 		}
 		throw LogicError("missing size name handler in " __FUNCTION__);
 	}
@@ -0,0 +1,744 @@
+/*-----------------------------------------------------------------------------
+	ColdFire Macro Assembler and Simulator
+
+	Copyright (C) 2007-2012 Mike Kowalski
+
+	See License.txt for more details
+-----------------------------------------------------------------------------*/
+
+#include "pch.h"
+#include "GdbServer.h"
+#include "Simulator.h"
+#include "Exceptions.h"
+#include <boost/asio.hpp>
+
+using boost::asio::ip::tcp;
+typedef boost::system::error_code ErrorCode;
+
+
+namespace {
+	// register numbers of GDB's org.gnu.gdb.coldfire.core feature
+	enum { GDB_SR= 16, GDB_PC= 17, GDB_REGISTERS= 18 };
+
+	const char target_xml[]=
+		"<?xml version=\"1.0\"?>"
+		"<!DOCTYPE target SYSTEM \"gdb-target.dtd\">"
+		"<target version=\"1.0\">"
+		"<architecture>m68k</architecture>"
+		"<feature name=\"org.gnu.gdb.coldfire.core\">"
+		"<reg name=\"d0\" bitsize=\"32\"/><reg name=\"d1\" bitsize=\"32\"/><reg name=\"d2\" bitsize=\"32\"/><reg name=\"d3\" bitsize=\"32\"/>"
+		"<reg name=\"d4\" bitsize=\"32\"/><reg name=\"d5\" bitsize=\"32\"/><reg name=\"d6\" bitsize=\"32\"/><reg name=\"d7\" bitsize=\"32\"/>"
+		"<reg name=\"a0\" bitsize=\"32\" type=\"data_ptr\"/><reg name=\"a1\" bitsize=\"32\" type=\"data_ptr\"/>"
+		"<reg name=\"a2\" bitsize=\"32\" type=\"data_ptr\"/><reg name=\"a3\" bitsize=\"32\" type=\"data_ptr\"/>"
+		"<reg name=\"a4\" bitsize=\"32\" type=\"data_ptr\"/><reg name=\"a5\" bitsize=\"32\" type=\"data_ptr\"/>"
+		"<reg name=\"fp\" bitsize=\"32\" type=\"data_ptr\"/><reg name=\"sp\" bitsize=\"32\" type=\"data_ptr\"/>"
+		"<reg name=\"ps\" bitsize=\"32\"/><reg name=\"pc\" bitsize=\"32\" type=\"code_ptr\"/>"
+		"</feature>"
+		"</target>";
+
+	cf::Register GdbToRegister(unsigned int reg)
+	{
+		switch (reg)
+		{
+		case GDB_SR:	return cf::R_SR;
+		case GDB_PC:	return cf::R_PC;
+		default:		return static_cast<cf::Register>(cf::R_D0 + reg);	// d0-d7, a0-a7
+		}
+	}
+
+	int HexDigit(char c)
+	{
+		if (c >= '0' && c <= '9')
+			return c - '0';
+		if (c >= 'a' && c <= 'f')
+			return c - 'a' + 10;
+		if (c >= 'A' && c <= 'F')
+			return c - 'A' + 10;
+		return -1;
+	}
+
+	// parse hex number at 'pos', stop at first non-hex character; false if there are no digits
+	bool ParseHex(const std::string& text, size_t& pos, uint32& value)
+	{
+		value = 0;
+		size_t start= pos;
+		for (int digit; pos < text.size() && (digit = HexDigit(text[pos])) >= 0; ++pos)
+			value = value << 4 | digit;
+		return pos > start;
+	}
+
+	bool Expect(const std::string& text, size_t& pos, char c)
+	{
+		if (pos >= text.size() || text[pos] != c)
+			return false;
+		++pos;
+		return true;
+	}
+
+	void AppendHex(std::string& out, const uint8* data, size_t length)
+	{
+		static const char hex[]= "0123456789abcdef";
+		for (size_t i= 0; i < length; ++i)
+		{
+			out += hex[data[i] >> 4];
+			out += hex[data[i] & 0xf];
+		}
+	}
+
+	void AppendHex(std::string& out, uint32 value)
+	{
+		uint8 bytes[]= { uint8(value >> 24), uint8(value >> 16), uint8(value >> 8), uint8(value) };
+		AppendHex(out, bytes, sizeof bytes);
+	}
+
+	// decode hex bytes; false if there's an odd or invalid digit
+	bool DecodeHex(const std::string& text, size_t pos, std::vector<uint8>& out)
+	{
+		out.clear();
+		if ((text.size() - pos) & 1)
+			return false;
+
+		out.reserve((text.size() - pos) / 2);
+		for ( ; pos < text.size(); pos += 2)
+		{
+			int hi= HexDigit(text[pos]), lo= HexDigit(text[pos + 1]);
+			if (hi < 0 || lo < 0)
+				return false;
+			out.push_back(static_cast<uint8>(hi << 4 | lo));
+		}
+		return true;
+	}
+}
+
+
+struct GdbServer::Impl
+{
+	Impl(Simulator& sim, uint16 port)
+		: sim_(sim), acceptor_(io_, tcp::endpoint(boost::asio::ip::address_v4::loopback(), port)), socket_(io_), poll_(io_)
+	{
+		connected_ = false;
+		Reset();
+
+		Accept();
+		thread_ = std::thread([this] { io_.run(); });
+	}
+
+	~Impl()
+	{
+		io_.stop();
+		if (thread_.joinable())
+			thread_.join();
+	}
+
+	Simulator& sim_;
+	std::atomic<bool> connected_;
+
+	// everything below is only touched by the service thread
+	boost::asio::io_service io_;
+	tcp::acceptor acceptor_;
+	tcp::socket socket_;
+	boost::asio::deadline_timer poll_;
+	std::thread thread_;
+	std::array<char, 4096> rx_buf_;
+	std::deque<std::string> tx_;		// first one is being sent
+	std::string last_reply_;			// for retransmission
+
+	// packet parser
+	enum class State { Idle, Data, Checksum1, Checksum2 } state_;
+	std::string packet_;
+	uint8 sum_;
+	uint8 checksum_;
+
+	bool no_ack_;
+	bool closing_;			// disconnect once pending replies are sent
+	bool running_;			// simulator runs on debugger's request; stop reply is pending
+	int spins_;				// quick polls of simulator status before falling back to timer
+
+	void Reset()
+	{
+		state_ = State::Idle;
+		no_ack_ = false;
+		closing_ = false;
+		running_ = false;
+		spins_ = 0;
+		tx_.clear();
+		last_reply_.clear();
+	}
+
+	void Accept()
+	{
+		acceptor_.async_accept(socket_, [this](const ErrorCode& err)
+		{
+			if (err == boost::asio::error::operation_aborted)
+				return;
+
+			if (err)
+			{
+				Accept();
+				return;
+			}
+
+			socket_.set_option(tcp::no_delay(true));
+			Reset();
+			connected_ = true;
+			ReadMore();
+		});
+	}
+
+	void Disconnect()
+	{
+		if (!socket_.is_open())
+			return;
+
+		// leave simulator stopped; debugger can reconnect later
+		if (running_)
+			sim_.BreakExecution();
+
+		ErrorCode ignore;
+		socket_.close(ignore);
+		poll_.cancel(ignore);
+		connected_ = false;
+		running_ = false;
+		// buffers may still be used by aborted operations; they are cleared when the next debugger connects
+		Accept();
+	}
+
+	void ReadMore()
+	{
+		if (!socket_.is_open())
+			return;
+
+		socket_.async_read_some(boost::asio::buffer(rx_buf_), [this](const ErrorCode& err, size_t len)
+		{
+			if (err)
+			{
+				if (err != boost::asio::error::operation_aborted)
+					Disconnect();
+				return;
+			}
+
+			for (size_t i= 0; i < len && socket_.is_open(); ++i)
+				Receive(rx_buf_[i]);
+
+			ReadMore();
+		});
+	}
+
+	void Receive(char c)
+	{
+		switch (state_)
+		{
+		case State::Idle:
+			if (c == '$')
+			{
+				packet_.clear();
+				sum_ = 0;
+				state_ = State::Data;
+			}
+			else if (c == '\x03')
+			{
+				if (running_)
+					sim_.BreakExecution();
+			}
+			else if (c == '-' && !no_ack_ && !last_reply_.empty())
+				Send(last_reply_);
+			break;	// '+' and noise
+
+		case State::Data:
+			if (c == '#')
+				state_ = State::Checksum1;
+			else
+			{
+				packet_ += c;
+				sum_ += static_cast<uint8>(c);
+			}
+			break;
+
+		case State::Checksum1:
+			checksum_ = static_cast<uint8>(std::max(HexDigit(c), 0) << 4);
+			state_ = State::Checksum2;
+			break;
+
+		case State::Checksum2:
+			checksum_ |= static_cast<uint8>(std::max(HexDigit(c), 0));
+			state_ = State::Idle;
+
+			if (!no_ack_)
+			{
+				if (checksum_ != sum_)
+				{
+					Send("-");
+					break;
+				}
+				Send("+");
+			}
+
+			// in all-stop mode debugger doesn't send packets while target runs
+			if (!running_)
+				Handle(packet_);
+			break;
+		}
+	}
+
+	void Reply(const std::string& data)
+	{
+		std::string frame= "$";
+		uint8 sum= 0;
+		for (auto c : data)
+		{
+			// binary data has to be escaped
+			if (c == '$' || c == '#' || c == '}' || c == '*')
+			{
+				frame += '}';
+				sum += '}';
+				c ^= 0x20;
+			}
+			frame += c;
+			sum += static_cast<uint8>(c);
+		}
+		frame += '#';
+		AppendHex(frame, &sum, 1);
+
+		last_reply_ = frame;
+		Send(frame);
+	}
+
+	void Send(const std::string& data)
+	{
+		tx_.push_back(data);
+		if (tx_.size() == 1)
+			Write();
+	}
+
+	void Write()
+	{
+		if (tx_.empty() || !socket_.is_open())
+			return;
+
+		boost::asio::async_write(socket_, boost::asio::buffer(tx_.front()), [this](const ErrorCode& err, size_t)
+		{
+			if (err)
+			{
+				if (err != boost::asio::error::operation_aborted)
+					Disconnect();
+				return;
+			}
+
+			tx_.pop_front();
+			if (tx_.empty() && closing_)
+				Disconnect();
+			else
+				Write();
+		});
+	}
+
+	void Handle(const std::string& packet);
+	void ReadRegisters();
+	void WriteRegisters(const std::string& packet);
+	void ReadMemory(const std::string& packet);
+	void WriteMemory(const std::string& packet, bool binary);
+	void Breakpoint(const std::string& packet, bool set);
+	void Resume(const std::string& packet, size_t pos, bool step);
+	void Query(const std::string& packet);
+	void Poll();
+	std::string StopReply();
+};
+
+
+void GdbServer::Impl::Handle(const std::string& packet)
+{
+	if (packet.empty())
+	{
+		Reply("");
+		return;
+	}
+
+	try
+	{
+		switch (packet[0])
+		{
+		case '?':
+			Reply(StopReply());
+			break;
+
+		case 'g':
+			ReadRegisters();
+			break;
+
+		case 'G':
+			WriteRegisters(packet);
+			break;
+
+		case 'p':
+			{
+				size_t pos= 1;
+				uint32 reg= 0;
+				if (!ParseHex(packet, pos, reg) || reg >= GDB_REGISTERS)
+				{
+					Reply("E01");
+					break;
+				}
+				std::string out;
+				AppendHex(out, sim_.GetRegister(GdbToRegister(reg)));
+				Reply(out);
+			}
+			break;
+
+		case 'P':
+			{
+				size_t pos= 1;
+				uint32 reg= 0, value= 0;
+				if (!ParseHex(packet, pos, reg) || !Expect(packet, pos, '=') || !ParseHex(packet, pos, value) || reg >= GDB_REGISTERS)
+				{
+					Reply("E01");
+					break;
+				}
+				sim_.SetRegister(GdbToRegister(reg), value);
+				Reply("OK");
+			}
+			break;
+
+		case 'm':
+			ReadMemory(packet);
+			break;
+
+		case 'M':
+			WriteMemory(packet, false);
+			break;
+
+		case 'X':
+			WriteMemory(packet, true);
+			break;
+
+		case 'Z':
+			Breakpoint(packet, true);
+			break;
+
+		case 'z':
+			Breakpoint(packet, false);
+			break;
+
+		case 'c':
+			Resume(packet, 1, false);
+			break;
+
+		case 's':
+			Resume(packet, 1, true);
+			break;
+
+		case 'v':
+			if (packet == "vCont?")
+				Reply("vCont;c;C;s;S");
+			else if (packet.compare(0, 6, "vCont;") == 0 && packet.size() > 6)
+			{
+				// single thread: first action decides; signals are ignored
+				auto action= packet[6];
+				if (action == 'c' || action == 'C')
+					Resume(packet, packet.size(), false);
+				else if (action == 's' || action == 'S')
+					Resume(packet, packet.size(), true);
+				else
+					Reply("");
+			}
+			else
+				Reply("");
+			break;
+
+		case 'q':
+		case 'Q':
+			Query(packet);
+			break;
+
+		case 'H':
+		case 'T':
+			Reply("OK");	// single thread
+			break;
+
+		case 'D':
+			Reply("OK");
+			closing_ = true;
+			break;
+
+		case 'k':
+			Disconnect();	// simulated program stays; there's no process to kill
+			break;
+
+		default:
+			Reply("");		// not supported
+			break;
+		}
+	}
+	catch (std::exception&)
+	{
+		Reply("E02");
+	}
+}
+
+
+void GdbServer::Impl::ReadRegisters()
+{
+	std::string out;
+	out.reserve(GDB_REGISTERS * 8);
+	for (unsigned int reg= 0; reg < GDB_REGISTERS; ++reg)
+		AppendHex(out, sim_.GetRegister(GdbToRegister(reg)));
+	Reply(out);
+}
+
+
+void GdbServer::Impl::WriteRegisters(const std::string& packet)
+{
+	std::vector<uint8> data;
+	if (!DecodeHex(packet, 1, data) || data.size() < GDB_REGISTERS * 4)
+	{
+		Reply("E01");
+		return;
+	}
+
+	for (unsigned int reg= 0; reg < GDB_REGISTERS; ++reg)
+	{
+		auto p= &data[reg * 4];
+		sim_.SetRegister(GdbToRegister(reg), uint32(p[0]) << 24 | uint32(p[1]) << 16 | uint32(p[2]) << 8 | p[3]);
+	}
+	Reply("OK");
+}
+
+
+void GdbServer::Impl::ReadMemory(const std::string& packet)
+{
+	size_t pos= 1;
+	uint32 address= 0, length= 0;
+	if (!ParseHex(packet, pos, address) || !Expect(packet, pos, ',') || !ParseHex(packet, pos, length))
+	{
+		Reply("E01");
+		return;
+	}
+
+	// reply cannot exceed packet size advertised in qSupported
+	length = std::min<uint32>(length, 0x1ff0);
+
+	std::vector<uint8> buffer(length);
+	auto read= length ? sim_.ReadMemory(buffer.data(), address, length) : 0;
+	if (read == 0 && length != 0)
+	{
+		Reply("E03");
+		return;
+	}
+
+	std::string out;
+	out.reserve(read * 2);
+	AppendHex(out, buffer.data(), read);
+	Reply(out);
+}
+
+
+void GdbServer::Impl::WriteMemory(const std::string& packet, bool binary)
+{
+	size_t pos= 1;
+	uint32 address= 0, length= 0;
+	if (!ParseHex(packet, pos, address) || !Expect(packet, pos, ',') || !ParseHex(packet, pos, length) || !Expect(packet, pos, ':'))
+	{
+		Reply("E01");
+		return;
+	}
+
+	std::vector<uint8> data;
+	if (binary)
+	{
+		data.reserve(length);
+		for ( ; pos < packet.size(); ++pos)
+			if (packet[pos] == '}' && pos + 1 < packet.size())
+				data.push_back(static_cast<uint8>(packet[++pos] ^ 0x20));
+			else
+				data.push_back(static_cast<uint8>(packet[pos]));
+	}
+	else if (!DecodeHex(packet, pos, data))
+	{
+		Reply("E01");
+		return;
+	}
+
+	if (data.size() != length)
+	{
+		Reply("E01");
+		return;
+	}
+
+	// zero length X packet only probes for binary download support
+	if (length != 0)
+		sim_.SetMemory(address, data.data(), data.data() + data.size());
+
+	Reply("OK");
+}
+
+
+void GdbServer::Impl::Breakpoint(const std::string& packet, bool set)
+{
+	size_t pos= 1;
+	uint32 type= 0, address= 0, kind= 0;
+	if (!ParseHex(packet, pos, type) || !Expect(packet, pos, ',') || !ParseHex(packet, pos, address) || !Expect(packet, pos, ',') || !ParseHex(packet, pos, kind))
+	{
+		Reply("E01");
+		return;
+	}
+
+	switch (type)
+	{
+	case 0:		// software breakpoint
+	case 1:		// hardware breakpoint; simulator doesn't patch code, so there's no difference
+		sim_.SetBreakpoint(address, set);
+		Reply("OK");
+		break;
+
+	case 2:		// write watchpoint; 'kind' is its length
+		sim_.SetWatchpoint(address, kind, set);
+		Reply("OK");
+		break;
+
+	default:	// read and access watchpoints are not supported
+		Reply("");
+		break;
+	}
+}
+
+
+void GdbServer::Impl::Resume(const std::string& packet, size_t pos, bool step)
+{
+	// optional resume address
+	uint32 address= 0;
+	if (ParseHex(packet, pos, address))
+		sim_.SetRegister(cf::R_PC, address);
+
+	auto status= step ? sim_.Step() : sim_.Run();
+	if (status != SIM_IS_RUNNING)
+	{
+		// simulator refused to run (program finished)
+		Reply(StopReply());
+		return;
+	}
+
+	running_ = true;
+	spins_ = 0;
+	Poll();
+}
+
+
+// wait for the simulator to stop, then send stop reply; steps end quickly, so don't wait for timer at first
+void GdbServer::Impl::Poll()
+{
+	if (!running_)
+		return;
+
+	if (sim_.GetStatus() != SIM_IS_RUNNING)
+	{
+		running_ = false;
+		Reply(StopReply());
+		return;
+	}
+
+	if (++spins_ < 1000)
+		io_.post([this] { Poll(); });
+	else
+	{
+		poll_.expires_from_now(boost::posix_time::milliseconds(1));
+		poll_.async_wait([this](const ErrorCode& err)
+		{
+			if (!err)
+				Poll();
+		});
+	}
+}
+
+
+std::string GdbServer::Impl::StopReply()
+{
+	switch (sim_.GetStatus())
+	{
+	case SIM_FINISHED:
+		return "W00";
+
+	case SIM_EXCEPTION:
+		return "S0a";	// SIGBUS
+
+	case SIM_BREAKPOINT_HIT:
+		{
+			uint32 address= 0;
+			if (sim_.GetWatchpointHit(address))
+			{
+				std::string reply= "T05watch:";
+				AppendHex(reply, address);
+				return reply + ";";
+			}
+		}
+		return "S05";
+
+	default:
+		return "S05";	// SIGTRAP
+	}
+}
+
+
+void GdbServer::Impl::Query(const std::string& packet)
+{
+	if (packet.compare(0, 10, "qSupported") == 0)
+		Reply("PacketSize=4000;QStartNoAckMode+;qXfer:features:read+");
+	else if (packet == "QStartNoAckMode")
+	{
+		Reply("OK");
+		no_ack_ = true;
+	}
+	else if (packet == "qAttached")
+		Reply("1");
+	else if (packet == "qC")
+		Reply("QC1");
+	else if (packet == "qfThreadInfo")
+		Reply("m1");
+	else if (packet == "qsThreadInfo")
+		Reply("l");
+	else if (packet.compare(0, 31, "qXfer:features:read:target.xml:") == 0)
+	{
+		size_t pos= 31;
+		uint32 offset= 0, length= 0;
+		if (!ParseHex(packet, pos, offset) || !Expect(packet, pos, ',') || !ParseHex(packet, pos, length))
+		{
+			Reply("E01");
+			return;
+		}
+
+		std::string xml= target_xml;
+		if (offset >= xml.size())
+			Reply("l");
+		else
+		{
+			auto part= xml.substr(offset, length);
+			Reply((offset + part.size() < xml.size() ? "m" : "l") + part);
+		}
+	}
+	else
+		Reply("");
+}
+
+//=============================================================================
+
+GdbServer::GdbServer(Simulator& sim, cf::uint16 port) : impl_(nullptr)
+{
+	try
+	{
+		impl_ = new Impl(sim, port);
+	}
+	catch (boost::system::system_error& ex)
+	{
+		throw RunTimeError("Cannot open GDB server port " + std::to_string(port) + ": " + ex.what());
+	}
+}
+
+
+GdbServer::~GdbServer()
+{
+	delete impl_;
+}
+
+
+bool GdbServer::Connected() const
+{
+	return impl_->connected_;
+}
@@ -0,0 +1,40 @@
+/*-----------------------------------------------------------------------------
+	ColdFire Macro Assembler and Simulator
+
+	Copyright (C) 2007-2012 Mike Kowalski
+
+	See License.txt for more details
+-----------------------------------------------------------------------------*/
+
+#pragma once
+#include "Import.h"
+#include "Types.h"
+
+class Simulator;
+
+
+// GDB remote serial protocol stub: GDB (or any tool speaking its protocol) connects to a local TCP port
+// and debugs the program loaded in the simulator. One debugger is served at a time; while it's connected,
+// it drives the simulator, so no other client should run or step it.
+//
+// Supported packets: registers (g, G, p, P; d0-d7, a0-a7, sr, pc), memory (m, M and binary X), software
+// and hardware breakpoints (Z0, Z1), write watchpoints (Z2), continue and step (c, s, vCont), Ctrl-C,
+// target description and no-ack mode. All socket I/O is done by a private service thread.
+
+class CF_DECL GdbServer
+{
+public:
+	// listens on the loopback interface; throws RunTimeError if port cannot be opened
+	GdbServer(Simulator& sim, cf::uint16 port);
+	~GdbServer();
+
+	// true if debugger is connected
+	bool Connected() const;
+
+private:
+	GdbServer(const GdbServer&);
+	GdbServer& operator = (const GdbServer&);
+
+	struct Impl;
+	Impl* impl_;
+};
@@ -30,7 +30,9 @@ public:
 
 	virtual void Execute(Context& ctx) const
 	{
-		//
+		// (Ax) selects cache set and way
+		auto o= OpCode(ctx);
+		ctx.PushCacheLine(ctx.GetRegister(8 + o.reg_index), o.code);
 	}
 };
 
@@ -0,0 +1,886 @@
+/*-----------------------------------------------------------------------------
+	ColdFire Macro Assembler and Simulator
+
+	Copyright (C) 2007-2012 Mike Kowalski
+
+	See License.txt for more details
+-----------------------------------------------------------------------------*/
+
+#include "pch.h"
+#include "Register.h"
+#include "../EmitCode.h"
+#include <cmath>
+#include <limits>
+
+// FPU ISA -------------
+
+// Eight 64-bit data registers FP0-FP7, FPCR, FPSR and FPIAR. Arithmetic uses host's IEEE doubles;
+// rounding precision (FPCR or FSxxx/FDxxx opcodes) is honored, while rounding mode is used only
+// by conversions to integers (FINT, FMOVE to B/W/L). Exceptions are recorded in FPSR, but never taken.
+
+// General FPU instructions share one opcode: F200 | <ea>; extension word tells them apart:
+//	0 R/M 0 src dst opmode	arithmetic; R/M=0: src is FPx, R/M=1: src is <ea> in 'src' format
+//	0 1 1 fmt src 0000000	FMOVE FPy, <ea>
+//	1 0 dr reg 0000000000	FMOVE <ea>, FPcr (dr=0), FMOVE FPcr, <ea> (dr=1)
+//	1 1 dr m 1 000 list		FMOVEM (dr=1: registers to memory; m=1: list in Dn)
+
+namespace {
+
+	enum Format	// operand format in memory or data register
+	{
+		FMT_LONG= 0,
+		FMT_SINGLE= 1,
+		FMT_WORD= 4,
+		FMT_DOUBLE= 5,
+		FMT_BYTE= 6
+	};
+
+	enum : uint32
+	{
+		FPSR_N= 1u << 27,			// condition codes: negative
+		FPSR_Z= 1u << 26,			// zero
+		FPSR_I= 1u << 25,			// infinity
+		FPSR_NAN= 1u << 24,			// not a number
+		FPSR_CC= 0x0f000000,
+
+		FPSR_BSUN= 1u << 15,		// exception status: branch/set on unordered
+		FPSR_OPERR= 1u << 13,		// operand error
+		FPSR_OVFL= 1u << 12,		// overflow
+		FPSR_UNFL= 1u << 11,		// underflow
+		FPSR_DZ= 1u << 10,			// divide by zero
+		FPSR_EXC= 0x0000ff00,
+
+		FPSR_AIOP= 1u << 7,			// accrued exceptions: invalid operation
+		FPSR_AOVFL= 1u << 6,		// overflow
+		FPSR_AUNFL= 1u << 5,		// underflow
+		FPSR_ADZ= 1u << 4,			// divide by zero
+
+		FPCR_SINGLE= 1u << 6,		// round results to single precision
+		FPCR_MODE_POS= 4			// rounding mode (2 bits): nearest, zero, minus, plus infinity
+	};
+
+	enum Operation { OP_MOVE, OP_INT, OP_INTRZ, OP_SQRT, OP_ABS, OP_NEG, OP_DIV, OP_ADD, OP_MUL, OP_SUB, OP_CMP, OP_TST };
+
+	enum Rounding : uint8 { ROUND_FPCR, ROUND_SINGLE, ROUND_DOUBLE };
+
+	struct OpMode
+	{
+		uint16 opmode;
+		const char* name;
+		Operation op;
+		Rounding rounding;
+		uint8 cycles;		// V4e FPU execution time (register operands)
+	};
+
+	const OpMode opmodes[]=
+	{
+		{ 0x00, "FMOVE",	OP_MOVE,	ROUND_FPCR,		1 },
+		{ 0x40, "FSMOVE",	OP_MOVE,	ROUND_SINGLE,	1 },
+		{ 0x44, "FDMOVE",	OP_MOVE,	ROUND_DOUBLE,	1 },
+		{ 0x01, "FINT",		OP_INT,		ROUND_FPCR,		4 },
+		{ 0x03, "FINTRZ",	OP_INTRZ,	ROUND_FPCR,		4 },
+		{ 0x04, "FSQRT",	OP_SQRT,	ROUND_FPCR,		56 },
+		{ 0x41, "FSSQRT",	OP_SQRT,	ROUND_SINGLE,	56 },
+		{ 0x45, "FDSQRT",	OP_SQRT,	ROUND_DOUBLE,	56 },
+		{ 0x18, "FABS",		OP_ABS,		ROUND_FPCR,		1 },
+		{ 0x58, "FSABS",	OP_ABS,		ROUND_SINGLE,	1 },
+		{ 0x5c, "FDABS",	OP_ABS,		ROUND_DOUBLE,	1 },
+		{ 0x1a, "FNEG",		OP_NEG,		ROUND_FPCR,		1 },
+		{ 0x5a, "FSNEG",	OP_NEG,		ROUND_SINGLE,	1 },
+		{ 0x5e, "FDNEG",	OP_NEG,		ROUND_DOUBLE,	1 },
+		{ 0x20, "FDIV",		OP_DIV,		ROUND_FPCR,		23 },
+		{ 0x60, "FSDIV",	OP_DIV,		ROUND_SINGLE,	23 },
+		{ 0x64, "FDDIV",	OP_DIV,		ROUND_DOUBLE,	23 },
+		{ 0x22, "FADD",		OP_ADD,		ROUND_FPCR,		4 },
+		{ 0x62, "FSADD",	OP_ADD,		ROUND_SINGLE,	4 },
+		{ 0x66, "FDADD",	OP_ADD,		ROUND_DOUBLE,	4 },
+		{ 0x23, "FMUL",		OP_MUL,		ROUND_FPCR,		4 },
+		{ 0x63, "FSMUL",	OP_MUL,		ROUND_SINGLE,	4 },
+		{ 0x67, "FDMUL",	OP_MUL,		ROUND_DOUBLE,	4 },
+		{ 0x28, "FSUB",		OP_SUB,		ROUND_FPCR,		4 },
+		{ 0x68, "FSSUB",	OP_SUB,		ROUND_SINGLE,	4 },
+		{ 0x6c, "FDSUB",	OP_SUB,		ROUND_DOUBLE,	4 },
+		{ 0x38, "FCMP",		OP_CMP,		ROUND_FPCR,		4 },
+		{ 0x3a, "FTST",		OP_TST,		ROUND_FPCR,		1 },
+	};
+
+	const OpMode* FindOpMode(uint16 opmode)
+	{
+		for (auto& mode : opmodes)
+			if (mode.opmode == opmode)
+				return &mode;
+		return nullptr;
+	}
+
+	// FBcc conditions; 0x10-0x1f test the same predicates as 0x00-0x0f, but signal BSUN on NaN
+	const char* const conditions[]=
+	{
+		"FBF", "FBEQ", "FBOGT", "FBOGE", "FBOLT", "FBOLE", "FBOGL", "FBOR",
+		"FBUN", "FBUEQ", "FBUGT", "FBUGE", "FBULT", "FBULE", "FBNE", "FBT",
+		"FBSF", "FBSEQ", "FBGT", "FBGE", "FBLT", "FBLE", "FBGL", "FBGLE",
+		"FBNGLE", "FBNGL", "FBNLE", "FBNLT", "FBNGE", "FBNGT", "FBSNE", "FBST"
+	};
+
+	bool Condition(uint32 fpsr, int cond)
+	{
+		bool n= !!(fpsr & FPSR_N);
+		bool z= !!(fpsr & FPSR_Z);
+		bool nan= !!(fpsr & FPSR_NAN);
+
+		switch (cond & 0xf)
+		{
+		case 0x0:	return false;
+		case 0x1:	return z;
+		case 0x2:	return !(nan || z || n);
+		case 0x3:	return z || !(nan || n);
+		case 0x4:	return n && !(nan || z);
+		case 0x5:	return z || (n && !nan);
+		case 0x6:	return !(nan || z);
+		case 0x7:	return !nan;
+		case 0x8:	return nan;
+		case 0x9:	return nan || z;
+		case 0xa:	return nan || !(n || z);
+		case 0xb:	return nan || z || !n;
+		case 0xc:	return nan || (n && !z);
+		case 0xd:	return nan || z || n;
+		case 0xe:	return !z;
+		default:	return true;
+		}
+	}
+
+	uint32 ConditionCodes(double value)
+	{
+		if (std::isnan(value))
+			return FPSR_NAN;
+
+		uint32 cc= 0;
+		if (std::signbit(value))
+			cc |= FPSR_N;
+		if (value == 0.0)
+			cc |= FPSR_Z;
+		if (std::isinf(value))
+			cc |= FPSR_I;
+		return cc;
+	}
+
+	// update exception status and accrued exception bytes
+	void SetExceptions(uint32& fpsr, uint32 exc)
+	{
+		fpsr = (fpsr & ~FPSR_EXC) | exc;
+		if (exc & (FPSR_BSUN | FPSR_OPERR))
+			fpsr |= FPSR_AIOP;
+		if (exc & FPSR_OVFL)
+			fpsr |= FPSR_AOVFL;
+		if (exc & FPSR_UNFL)
+			fpsr |= FPSR_AUNFL;
+		if (exc & FPSR_DZ)
+			fpsr |= FPSR_ADZ;
+	}
+
+	double RoundToInteger(double value, uint32 fpcr)
+	{
+		switch ((fpcr >> FPCR_MODE_POS) & 3)
+		{
+		case 1:		return std::trunc(value);
+		case 2:		return std::floor(value);
+		case 3:		return std::ceil(value);
+		default:	return std::nearbyint(value);	// host default: to nearest even
+		}
+	}
+
+	int32 ToInteger(double value, int32 min, int32 max, uint32 fpcr, uint32& exc)
+	{
+		if (std::isnan(value))
+		{
+			exc |= FPSR_OPERR;
+			return max;
+		}
+
+		value = RoundToInteger(value, fpcr);
+		if (value < min || value > max)
+		{
+			exc |= FPSR_OPERR;
+			return value < min ? min : max;
+		}
+
+		return static_cast<int32>(value);
+	}
+
+	double SingleToDouble(uint32 bits)
+	{
+		float f;
+		memcpy(&f, &bits, sizeof f);
+		return f;
+	}
+
+	uint32 DoubleToSingle(double value)
+	{
+		float f= static_cast<float>(value);
+		uint32 bits;
+		memcpy(&bits, &f, sizeof bits);
+		return bits;
+	}
+
+	// memory address of double precision operand; (An)+ and -(An) step by 8 bytes
+	DecodedAddress DoubleAddress(Context& ctx, uint16 ea, int& ext_words)
+	{
+		int mode= (ea >> 3) & 7;
+		if (mode == 0 || mode == 1)
+			throw AddressingModeException(ea);
+
+		auto& an= ctx.Cpu().a_reg[ea & 7];
+		if (mode == 4)
+			an -= 4;
+
+		InstrSize size= S_LONG;
+		auto da= ctx.DecodeMemoryAddress(ea, size, ext_words);
+
+		if (mode == 3)
+			an += 4;
+		else if (ea == EAF_Immediate)
+			ext_words += 2;
+
+		return da;
+	}
+
+	// read operand in given format and convert it to double; returns false if format is not supported
+	bool ReadOperand(Context& ctx, uint16 ea, int format, int& ext_words, double& value)
+	{
+		switch (format)
+		{
+		case FMT_BYTE:
+			value = static_cast<int8>(ctx.DecodeSrcByteValue(ea, S_BYTE, ext_words));
+			return true;
+
+		case FMT_WORD:
+			value = static_cast<int16>(ctx.DecodeSrcWordValue(ea, S_WORD, ext_words));
+			return true;
+
+		case FMT_LONG:
+			value = static_cast<int32>(ctx.DecodeSrcLongWordValue(ea, S_LONG, ext_words));
+			return true;
+
+		case FMT_SINGLE:
+			value = SingleToDouble(ctx.DecodeSrcLongWordValue(ea, S_LONG, ext_words));
+			return true;
+
+		case FMT_DOUBLE:
+			{
+				auto da= DoubleAddress(ctx, ea, ext_words);
+				uint64 bits= uint64(ctx.ReadFromAddress(da, S_LONG)) << 32;
+				bits |= ctx.ReadFromAddress(ctx.GetMemoryAddress(da.cf_addr + 4, S_LONG), S_LONG);
+				memcpy(&value, &bits, sizeof value);
+			}
+			return true;
+
+		default:	// extended and packed formats are not available in ColdFire
+			return false;
+		}
+	}
+
+	bool WriteOperand(Context& ctx, uint16 ea, int format, double value, uint32 fpcr, int& ext_words, uint32& exc)
+	{
+		switch (format)
+		{
+		case FMT_BYTE:
+			ctx.DecodeAndSetDestByte(ea, S_BYTE, ext_words, static_cast<uint8>(ToInteger(value, -0x80, 0x7f, fpcr, exc)));
+			return true;
+
+		case FMT_WORD:
+			ctx.DecodeAndSetDestWord(ea, S_WORD, ext_words, static_cast<uint16>(ToInteger(value, -0x8000, 0x7fff, fpcr, exc)));
+			return true;
+
+		case FMT_LONG:
+			ctx.DecodeAndSetDestLongWord(ea, S_LONG, ext_words, static_cast<uint32>(ToInteger(value, std::numeric_limits<int32>::min(), std::numeric_limits<int32>::max(), fpcr, exc)));
+			return true;
+
+		case FMT_SINGLE:
+			if (std::isfinite(value) && std::isinf(static_cast<float>(value)))
+				exc |= FPSR_OVFL;
+			ctx.DecodeAndSetDestLongWord(ea, S_LONG, ext_words, DoubleToSingle(value));
+			return true;
+
+		case FMT_DOUBLE:
+			{
+				auto da= DoubleAddress(ctx, ea, ext_words);
+				uint64 bits;
+				memcpy(&bits, &value, sizeof bits);
+				ctx.WriteToAddress(da, static_cast<uint32>(bits >> 32), S_LONG);
+				ctx.WriteToAddress(ctx.GetMemoryAddress(da.cf_addr + 4, S_LONG), static_cast<uint32>(bits), S_LONG);
+			}
+			return true;
+
+		default:
+			return false;
+		}
+	}
+
+	InstrSize FormatToSize(int format)
+	{
+		switch (format)
+		{
+		case FMT_BYTE:		return S_BYTE;
+		case FMT_WORD:		return S_WORD;
+		case FMT_LONG:		return S_LONG;
+		case FMT_SINGLE:	return S_SINGLE;
+		case FMT_DOUBLE:	return S_DOUBLE;
+		default:			return S_NA;
+		}
+	}
+
+	// operand format requested by size attribute; without one data registers hold long words, memory doubles
+	uint16 SizeToFormat(InstructionSize size, const EffectiveAddress& ea)
+	{
+		switch (size)
+		{
+		case IS_BYTE:	return FMT_BYTE;
+		case IS_WORD:	return FMT_WORD;
+		case IS_LONG:	return FMT_LONG;
+		case IS_FLOAT:	return FMT_SINGLE;
+		case IS_NONE:	return ea.mode_ == AM_Dx ? FMT_LONG : FMT_DOUBLE;
+		case IS_DOUBLE:
+			if (ea.mode_ == AM_Dx)
+				throw RunTimeError("Double precision operand doesn't fit in a data register");
+			return FMT_DOUBLE;
+		default:
+			throw LogicError("unsupported FPU operand size in " __FUNCTION__);
+		}
+	}
+
+	uint16 FpRegisterToNumber(CpuRegister reg)
+	{
+		if (reg < R_FP0 || reg > R_FP7)
+			throw LogicError("FPU data reg expected " __FUNCTION__);
+		return static_cast<uint16>(reg - R_FP0);
+	}
+
+	uint16 FpControlRegisterToCode(CpuRegister reg)
+	{
+		switch (reg)
+		{
+		case R_FPCR:	return 4;
+		case R_FPSR:	return 2;
+		case R_FPIAR:	return 1;
+		default:		throw LogicError("FPU control reg expected " __FUNCTION__);
+		}
+	}
+
+	IParam FpRegisters(IParam params)
+	{
+		for (int reg= R_FP0; reg <= R_FP7; ++reg)
+			params.SpecReg(static_cast<CpuRegister>(reg));
+		return params;
+	}
+
+	// <ea> following the extension word; PC relative displacement is counted from extension word
+	void EmitFpu(uint16 opcode, uint16 ext, EffectiveAddress ea, OutputPointer& ctx)
+	{
+		if (ea.mode_ == AM_DISP_PC && ea.val_.IsNumber())
+			ea.val_ = Expr(Expr::EX_LONG, ea.val_.Value() - 2);
+
+		uint16 words[3];
+		int count= Encode_EA(opcode, ea, 3, 0, words);
+		if (count == 0)
+			throw LogicError("Illegal addressing mode, cannot emit code in " __FUNCTION__);
+
+		ctx << words[0];
+		ctx << ext;
+		for (int i= 1; i < count; ++i)
+			ctx << words[i];
+	}
+
+	const AddressingMode FP_SRC_MODES= AM_Dx | AM_INDIRECT_Ax | AM_Ax_INC | AM_DEC_Ax | AM_DISP_Ax | AM_DISP_PC;
+	const AddressingMode FP_DST_MODES= AM_Dx | AM_INDIRECT_Ax | AM_Ax_INC | AM_DEC_Ax | AM_DISP_Ax;
+	const InstructionSize FP_SIZES= IS_BYTE | IS_WORD | IS_LONG | IS_FLOAT | IS_DOUBLE;
+}
+
+
+// all general FPU instructions; only one of them is placed in the instruction map, and it decodes and executes
+// all others; they only define assembler syntax and encoding
+
+class Fpu : public InstructionImpl<Stencil_EA>
+{
+protected:
+	Fpu(const char* name, const IParam& params) : InstructionImpl(name, params)
+	{}
+
+public:
+	virtual DecodedInstruction Decode(InstrPointer& ctx) const
+	{
+		uint16 ea= OpCode(ctx).ea_mode;
+		uint16 ext= ctx.GetNextWord();
+
+		DecodedInstruction out(Mnemonic(), ctx.OpCode());
+
+		switch (ext >> 13)
+		{
+		case 0:		// FPx, FPy
+		case 2:		// <ea>, FPy
+			if (auto mode= FindOpMode(ext & 0x7f))
+			{
+				out.name_ = mode->name;
+				int src= (ext >> 10) & 7;
+				if (ext & 0x4000)
+				{
+					if (!DecodeEA(out, ea, FormatToSize(src), ctx, out.src_))
+						break;
+				}
+				else
+					out.src_ = EffectiveAddress_SpecReg(static_cast<SpecialRegister>(REG_FP0 + src));
+
+				if (mode->op != OP_TST)
+					out.dest_ = EffectiveAddress_SpecReg(static_cast<SpecialRegister>(REG_FP0 + ((ext >> 7) & 7)));
+				return out;
+			}
+			break;
+
+		case 3:		// FPx, <ea>
+			out.name_ = "FMOVE";
+			out.src_ = EffectiveAddress_SpecReg(static_cast<SpecialRegister>(REG_FP0 + ((ext >> 7) & 7)));
+			if (DecodeEA(out, ea, FormatToSize((ext >> 10) & 7), ctx, out.dest_))
+				return out;
+			break;
+
+		case 4:		// <ea>, FPcr
+		case 5:		// FPcr, <ea>
+			{
+				SpecialRegister reg= REG_INVALID;
+				switch ((ext >> 10) & 7)
+				{
+				case 4:	reg = REG_FPCR; break;
+				case 2:	reg = REG_FPSR; break;
+				case 1:	reg = REG_FPIAR; break;
+				}
+				if (reg == REG_INVALID || (ext & 0x3ff))
+					break;
+
+				out.name_ = "FMOVE";
+				auto& operand= ext & 0x2000 ? out.dest_ : out.src_;
+				(ext & 0x2000 ? out.src_ : out.dest_) = EffectiveAddress_SpecReg(reg);
+				if (DecodeEA(out, ea, S_LONG, ctx, operand))
+					return out;
+			}
+			break;
+
+		case 6:		// FMOVEM <ea>, list
+		case 7:		// FMOVEM list, <ea>
+			{
+				out.name_ = "FMOVEM";
+				auto list= ext & 0x0800 ? EffectiveAddress_DReg((ext >> 4) & 7) : EffectiveAddress_Imm(ext & 0xff, false);
+				auto& operand= ext & 0x2000 ? out.dest_ : out.src_;
+				(ext & 0x2000 ? out.src_ : out.dest_) = list;
+				if (DecodeEA(out, ea, S_DOUBLE, ctx, operand))
+					return out;
+			}
+			break;
+		}
+
+		out.unknown_instr_ = true;
+		return out;
+	}
+
+	virtual void Execute(Context& ctx) const
+	{
+		auto& cpu= ctx.Cpu();
+		uint32 opcode_addr= cpu.pc - 2;
+		uint16 ea= OpCode(ctx).ea_mode;
+		uint16 ext= ctx.GetNextPCWord();
+
+		int ext_words= 0;
+		bool ok= false;
+
+		switch (ext >> 13)
+		{
+		case 0:
+		case 2:
+			ok = Arithmetic(ctx, ea, ext, ext_words);
+			cpu.fpiar = opcode_addr;
+			break;
+
+		case 3:
+			{
+				uint32 exc= 0;
+				ok = WriteOperand(ctx, ea, (ext >> 10) & 7, cpu.fp[(ext >> 7) & 7], cpu.fpcr, ext_words, exc);
+				SetExceptions(cpu.fpsr, exc);
+				cpu.fpiar = opcode_addr;
+			}
+			break;
+
+		case 4:
+		case 5:
+			ok = MoveControl(ctx, ea, ext, ext_words);
+			break;
+
+		case 6:
+		case 7:
+			ok = MoveMultiple(ctx, ea, ext, ext_words);
+			break;
+		}
+
+		if (!ok)
+		{
+			ctx.EnterException(EX_UnimplementedLineFOpcode, opcode_addr);
+			return;
+		}
+
+		ctx.StepPC(ext_words);
+	}
+
+	virtual bool CalcSize(InstructionSize size, const EffectiveAddress& ea_src, const EffectiveAddress& ea_dst, uint32& len) const
+	{
+		// extension word follows opcode
+		if (!Instruction::CalcSize(size, ea_src, ea_dst, len))
+			return false;
+		len += 2;
+		return true;
+	}
+
+private:
+	// decode <ea> of FPU operand of given size; false if it's not valid
+	static bool DecodeEA(DecodedInstruction& out, uint16 ea, InstrSize size, InstrPointer& ctx, DasmEffectiveAddress& operand)
+	{
+		if (size == S_NA || (ea == EAF_Immediate && size == S_DOUBLE))
+			return false;
+
+		// immediate single precision number is shown as a long word
+		out.size_ = size == S_SINGLE || size == S_DOUBLE ? S_LONG : size;
+		operand = out.DoDecodeEA((ea >> 3) & 7, ea & 7, ctx, out.size_);
+		out.size_ = size;
+
+		// displacement is relative to the extension word, not the opcode
+		if (operand.mode_ == AM_DISP_PC)
+			operand.arg_ += 2;
+
+		return operand.mode_ != AM_BOGUS;
+	}
+
+	static bool Arithmetic(Context& ctx, uint16 ea, uint16 ext, int& ext_words)
+	{
+		auto mode= FindOpMode(ext & 0x7f);
+		if (mode == nullptr)
+			return false;
+
+		auto& cpu= ctx.Cpu();
+		double src= 0.0;
+		if (ext & 0x4000)
+		{
+			if (!ReadOperand(ctx, ea, (ext >> 10) & 7, ext_words, src))
+				return false;
+		}
+		else
+			src = cpu.fp[(ext >> 10) & 7];
+
+		double& dst= cpu.fp[(ext >> 7) & 7];
+		double result= 0.0;
+		bool dyadic= false;
+		uint32 exc= 0;
+
+		switch (mode->op)
+		{
+		case OP_MOVE:	result = src; break;
+		case OP_INT:	result = RoundToInteger(src, cpu.fpcr); break;
+		case OP_INTRZ:	result = std::trunc(src); break;
+		case OP_SQRT:	result = std::sqrt(src); break;
+		case OP_ABS:	result = std::fabs(src); break;
+		case OP_NEG:	result = -src; break;
+		case OP_ADD:	result = dst + src; dyadic = true; break;
+		case OP_SUB:	result = dst - src; dyadic = true; break;
+		case OP_MUL:	result = dst * src; dyadic = true; break;
+
+		case OP_DIV:
+			if (src == 0.0 && std::isfinite(dst) && dst != 0.0)
+				exc |= FPSR_DZ;
+			result = dst / src;
+			dyadic = true;
+			break;
+
+		case OP_CMP:
+			// condition codes of dst - src, except for equal infinities
+			if (std::isnan(src) || std::isnan(dst))
+				result = std::numeric_limits<double>::quiet_NaN();
+			else if (dst == src)
+				result = std::signbit(dst) ? -0.0 : 0.0;
+			else
+				result = dst < src ? -1.0 : 1.0;
+			cpu.fpsr = (cpu.fpsr & ~FPSR_CC) | ConditionCodes(result);
+			SetExceptions(cpu.fpsr, 0);
+			ctx.SkipCycles(mode->cycles - 1);
+			return true;
+
+		case OP_TST:
+			cpu.fpsr = (cpu.fpsr & ~FPSR_CC) | ConditionCodes(src);
+			SetExceptions(cpu.fpsr, 0);
+			ctx.SkipCycles(mode->cycles - 1);
+			return true;
+		}
+
+		bool nan_input= std::isnan(src) || (dyadic && std::isnan(dst));
+		bool finite_input= std::isfinite(src) && (!dyadic || std::isfinite(dst));
+
+		if (std::isnan(result) && !nan_input)
+			exc |= FPSR_OPERR;
+
+		if (mode->rounding == ROUND_SINGLE || (mode->rounding == ROUND_FPCR && (cpu.fpcr & FPCR_SINGLE)))
+		{
+			float single= static_cast<float>(result);
+			if (result != 0.0 && std::fabs(single) < std::numeric_limits<float>::min())
+				exc |= FPSR_UNFL;
+			result = single;
+		}
+		else if (result != 0.0 && std::fabs(result) < std::numeric_limits<double>::min())
+			exc |= FPSR_UNFL;
+
+		if (std::isinf(result) && finite_input && !(exc & FPSR_DZ))
+			exc |= FPSR_OVFL;
+
+		dst = result;
+		cpu.fpsr = (cpu.fpsr & ~FPSR_CC) | ConditionCodes(result);
+		SetExceptions(cpu.fpsr, exc);
+		ctx.SkipCycles(mode->cycles - 1);
+
+		return true;
+	}
+
+	static bool MoveControl(Context& ctx, uint16 ea, uint16 ext, int& ext_words)
+	{
+		auto& cpu= ctx.Cpu();
+		uint32* reg= nullptr;
+		switch ((ext >> 10) & 7)
+		{
+		case 4:	reg = &cpu.fpcr; break;
+		case 2:	reg = &cpu.fpsr; break;
+		case 1:	reg = &cpu.fpiar; break;
+		default: return false;
+		}
+
+		// only FPIAR can be moved to/from address register
+		if ((ea >> 3) == EAF_Ax && reg != &cpu.fpiar)
+			return false;
+
+		if (ext & 0x2000)
+			ctx.DecodeAndSetDestLongWord(ea, S_LONG, ext_words, *reg);
+		else
+			*reg = ctx.DecodeSrcLongWordValue(ea, S_LONG, ext_words);
+
+		return true;
+	}
+
+	static bool MoveMultiple(Context& ctx, uint16 ea, uint16 ext, int& ext_words)
+	{
+		// ColdFire supports (An) and (d16, An) only
+		int mode= (ea >> 3) & 7;
+		if (mode != EAF_Ax_Ind && mode != EAF_Disp_Ax)
+			return false;
+
+		auto& cpu= ctx.Cpu();
+		uint32 list= ext & 0x0800 ? cpu.d_reg[(ext >> 4) & 7] & 0xff : ext & 0xff;
+
+		InstrSize size= S_LONG;
+		uint32 address= ctx.DecodeMemoryAddress(ea, size, ext_words).cf_addr;
+
+		// FP0 is in bit 7
+		uint32 count= 0;
+		for (int reg= 0; reg < 8; ++reg)
+			if (list & (0x80 >> reg))
+			{
+				auto da= ctx.GetMemoryAddress(address, S_LONG);
+				auto da2= ctx.GetMemoryAddress(address + 4, S_LONG);
+				uint64 bits;
+				if (ext & 0x2000)
+				{
+					memcpy(&bits, &cpu.fp[reg], sizeof bits);
+					ctx.WriteToAddress(da, static_cast<uint32>(bits >> 32), S_LONG);
+					ctx.WriteToAddress(da2, static_cast<uint32>(bits), S_LONG);
+				}
+				else
+				{
+					bits = uint64(ctx.ReadFromAddress(da, S_LONG)) << 32 | ctx.ReadFromAddress(da2, S_LONG);
+					memcpy(&cpu.fp[reg], &bits, sizeof bits);
+				}
+				address += 8;
+				++count;
+			}
+
+		if (count > 1)
+			ctx.SkipCycles(count - 1);
+
+		return true;
+	}
+};
+
+
+// arithmetic: <ea>y, FPx or FPy, FPx; FTST takes single operand
+class FpuArith : public Fpu
+{
+public:
+	FpuArith(const OpMode& mode, bool in_map)
+		: Fpu(mode.name, FpRegisters(IParam().Opcode(0xf200).Mask(Stencil::MASK).Sizes(FP_SIZES).DefaultSize(IS_DOUBLE).SrcModes(AM_SPEC_REG | FP_SRC_MODES).DestModes(mode.op == OP_TST ? AM_NONE : AM_SPEC_REG).Isa(ISA::FPU).ExcludeCodes(in_map ? IExcludeCodes() : IExcludeCodes(0xffff, 0xffff)))), opmode_(mode.opmode)
+	{}
+
+	virtual void Encode(InstructionSize size, const EffectiveAddress& ea_src, const EffectiveAddress& ea_dst, OutputPointer& ctx) const
+	{
+		uint16 ext= opmode_;
+		if (ea_dst.mode_ == AM_SPEC_REG)
+			ext |= FpRegisterToNumber(ea_dst.first_reg_) << 7;
+
+		if (ea_src.mode_ == AM_SPEC_REG)
+		{
+			ext |= FpRegisterToNumber(ea_src.first_reg_) << 10;
+			ctx << StencilCode();
+			ctx << ext;
+		}
+		else
+			EmitFpu(StencilCode(), ext | 0x4000 | SizeToFormat(size, ea_src) << 10, ea_src, ctx);
+	}
+
+private:
+	uint16 opmode_;
+};
+
+
+// FMOVE FPy, <ea>x
+class FpuStore : public Fpu
+{
+public:
+	FpuStore() : Fpu("FMOVE", FpRegisters(IParam().Opcode(0xf200).Mask(Stencil::MASK).Sizes(FP_SIZES).DefaultSize(IS_DOUBLE).SrcModes(AM_SPEC_REG).DestModes(FP_DST_MODES).Isa(ISA::FPU).ExcludeCodes(0xffff, 0xffff)))
+	{}
+
+	virtual void Encode(InstructionSize size, const EffectiveAddress& ea_src, const EffectiveAddress& ea_dst, OutputPointer& ctx) const
+	{
+		uint16 ext= 0x6000 | SizeToFormat(size, ea_dst) << 10 | FpRegisterToNumber(ea_src.first_reg_) << 7;
+		EmitFpu(StencilCode(), ext, ea_dst, ctx);
+	}
+};
+
+
+// FMOVE <ea>y, FPcr and FMOVE FPcr, <ea>x
+class FpuMoveControl : public Fpu
+{
+public:
+	FpuMoveControl(bool to_control)
+		: Fpu("FMOVE", IParam().Opcode(0xf200).Mask(Stencil::MASK).Sizes(IS_LONG).SrcModes(to_control ? AM_Dx | AM_Ax | FP_SRC_MODES | AM_IMMEDIATE : AM_SPEC_REG).DestModes(to_control ? AM_SPEC_REG : AM_Dx | AM_Ax | FP_DST_MODES).SpecReg(R_FPCR).SpecReg(R_FPSR).SpecReg(R_FPIAR).Isa(ISA::FPU).ExcludeCodes(0xffff, 0xffff)), to_control_(to_control)
+	{}
+
+	virtual void Encode(InstructionSize size, const EffectiveAddress& ea_src, const EffectiveAddress& ea_dst, OutputPointer& ctx) const
+	{
+		if (to_control_)
+			EmitFpu(StencilCode(), 0x8000 | FpControlRegisterToCode(ea_dst.first_reg_) << 10, ea_src, ctx);
+		else
+			EmitFpu(StencilCode(), 0xa000 | FpControlRegisterToCode(ea_src.first_reg_) << 10, ea_dst, ctx);
+	}
+
+private:
+	bool to_control_;
+};
+
+
+// FBcc: F280 | cc with 16-bit displacement, F2C0 | cc with 32-bit displacement
+class FpuBranch : public InstructionImpl<Stencil_UNIQUE>
+{
+public:
+	FpuBranch(int condition) : InstructionImpl(conditions[condition], IParam().Sizes(IS_WORD | IS_LONG).DefaultSize(IS_WORD).SrcModes(AM_RELATIVE).Opcode(0xf280 | condition).Mask(0x0040).Isa(ISA::FPU).ControlFlow(IControlFlow::BRANCH))
+	{}
+
+	virtual DecodedInstruction Decode(InstrPointer& ctx) const
+	{
+		uint16 opcode= ctx.OpCode();
+		bool long_disp= !!(opcode & 0x40);
+		uint32 displacement= long_disp ? ctx.GetNextLongWord() : ctx.GetNextSWord();
+
+		// FBF with zero displacement is FNOP
+		if ((opcode & 0x7f) == 0 && displacement == 0)
+			return DecodedInstruction("FNOP", opcode);
+
+		DecodedInstruction out(Mnemonic(), long_disp ? S_LONG : S_WORD, opcode);
+		out.src_ = DasmEffectiveAddress(AM_RELATIVE, displacement);
+		return out;
+	}
+
+	virtual void Execute(Context& ctx) const
+	{
+		auto& cpu= ctx.Cpu();
+		int condition= ctx.OpCode() & 0x3f;
+		uint32 pc= cpu.pc;
+		uint32 displacement= ctx.OpCode() & 0x40 ? ctx.GetNextPCLongWord() : SignExtendWord(ctx.GetNextPCWord());
+
+		// signaling conditions report unordered operands
+		if ((condition & 0x10) && (cpu.fpsr & FPSR_NAN))
+			SetExceptions(cpu.fpsr, FPSR_BSUN);
+
+		if (Condition(cpu.fpsr, condition))
+			cpu.pc = pc + displacement;
+	}
+
+	virtual void Encode(InstructionSize size, const EffectiveAddress& ea_src, const EffectiveAddress& ea_dst, OutputPointer& ctx) const
+	{
+		switch (size)
+		{
+		case IS_NONE:	// word offset by default
+		case IS_WORD:
+			ctx << StencilCode();
+			ctx << uint16(ea_src.val_.Value() & 0xffff);
+			break;
+
+		case IS_LONG:
+			ctx << uint16(StencilCode() | 0x40);
+			ctx << uint16((ea_src.val_.Value() >> 16) & 0xffff);	// high word
+			ctx << uint16(ea_src.val_.Value() & 0xffff);			// low word
+			break;
+
+		default:
+			throw LogicError("missing size specification in " __FUNCTION__);
+		}
+	}
+};
+
+
+class FpuNop : public InstructionImpl<Stencil_UNIQUE>
+{
+public:
+	// assembler only; this is FBF with zero displacement
+	FpuNop() : InstructionImpl("FNOP", IParam().Opcode(0xf280).Isa(ISA::FPU).ExcludeCodes(0xffff, 0xffff))
+	{}
+
+	virtual DecodedInstruction Decode(InstrPointer& ctx) const
+	{
+		return DecodedInstruction(Mnemonic(), ctx.OpCode());
+	}
+
+	virtual void Execute(Context& ctx) const
+	{
+		ctx.StepPC();
+	}
+
+	virtual void Encode(InstructionSize size, const EffectiveAddress& ea_src, const EffectiveAddress& ea_dst, OutputPointer& ctx) const
+	{
+		ctx << StencilCode();
+		ctx << uint16(0);
+	}
+
+	virtual bool CalcSize(InstructionSize size, const EffectiveAddress& ea_src, const EffectiveAddress& ea_dst, uint32& len) const
+	{
+		len = 2 + 2;
+		return true;
+	}
+};
+
+
+static bool RegisterFpu()
+{
+	// FMOVE <ea>y, FPx is the one executing all general FPU opcodes
+	for (auto& mode : opmodes)
+		GetInstructions().Register(new FpuArith(mode, mode.opmode == 0x00));
+
+	GetInstructions().Register(new FpuStore());
+	GetInstructions().Register(new FpuMoveControl(true));
+	GetInstructions().Register(new FpuMoveControl(false));
+
+	for (int condition= 0; condition < array_count(conditions); ++condition)
+		GetInstructions().Register(new FpuBranch(condition));
+
+	GetInstructions().Register(new FpuNop());
+
+	return true;
+}
+
+static bool registered= RegisterFpu();
@@ -41,6 +41,7 @@ public:
 		case REG_CACR:
 			// TODO
 			// emulate bit for disabling user stack pointer
+			ctx.SetCACR(data);
 			break;
 
 		case REG_VBR:
@@ -53,8 +54,11 @@ public:
 
 		case REG_ACR0:	// access control registers
 		case REG_ACR1:
+		case REG_ACR2:
+		case REG_ACR3:
 			//TODO:
-			// memory access control, cache mode, write protect, ...
+			// write protect, ...
+			ctx.Cpu().acr[DecodeControlRegisterField(ext.ctrl_reg) - REG_ACR0] = data;	// cache mode
 			break;
 
 		default:
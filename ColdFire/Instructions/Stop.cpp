@@ -27,9 +27,12 @@ public:
 		uint16 stat= ctx.GetNextPCWord();
 
 		if ((stat & cf::SR_SUPERVISOR) == 0)
+		{
 			ctx.EnterException(EX_PrivilegeViolation, ctx.Cpu().pc - 2);
-		else
-			ctx.Cpu().SetSR(stat);
+			return;
+		}
+
+		ctx.Cpu().SetSR(stat);
 
 		// STOP can also cause illegal instruction exception if low power modules are not enabled;
 		// this is currently not simulated
@@ -37,7 +40,7 @@ public:
 		//TODO: execute trace exception if trace is enabled
 		//
 
-		//TODO: stop execution and wait for interrupt
+		// stop execution and wait for interrupt; simulator skips idle time till the next device event
 		ctx.EnterStopState();
 	}
 
@@ -93,7 +93,18 @@ public:
 
 	virtual void Execute(Context& ctx) const
 	{
-		assert(false);	// TODO
+		// read-modify-write cycle is indivisible, other cores cannot sneak in
+		auto lock= ctx.LockBus();
+
+		int ext_words= 0;
+		InstrSize size= S_BYTE;
+		DecodedAddress da= ctx.DecodeMemoryAddress(ctx.OpCode() & 0x3f, size, ext_words);
+
+		uint8 value= static_cast<uint8>(ctx.ReadFromAddress(da, S_BYTE));
+		ctx.SetNZ_ClrCV(value);
+		ctx.WriteToAddress(da, value | 0x80, S_BYTE);
+
+		ctx.StepPC(ext_words);
 	}
 
 	virtual bool CalcSize(InstructionSize size, const EffectiveAddress& ea_src, const EffectiveAddress& ea_dst, uint32& len) const
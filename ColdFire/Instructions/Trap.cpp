@@ -30,6 +30,10 @@ public:
 	{
 		Stencil o= OpCode(ctx);
 
+		// service provided by the simulator itself?
+		if (ctx.NativeTrap(o.data))
+			return;
+
 		ctx.EnterException(static_cast<CpuExceptions>(EX_Trap_0 + o.data), ctx.Cpu().pc - 2);
 	}
 
@@ -25,4 +25,7 @@ public:
 	virtual void InterruptAssert(uint16 interrupt_source, CpuExceptions vector) = 0;
 
 	virtual void InterruptClear(uint16 interrupt_source) = 0;
+
+	// interrupt level configured for given source; 0 if unknown
+	virtual int InterruptLevel(uint16 interrupt_source) const	{ return 0; }
 };
@@ -26,6 +26,8 @@ ISA StringToISA(const std::wstring& isa)
 		return ISA::EMAC;
 	else if (isa == L"EMAC_B")
 		return ISA::EMAC_B;
+	else if (isa == L"FPU")
+		return ISA::FPU;
 	else if (isa == L"None")
 		return ISA::None;
 	else
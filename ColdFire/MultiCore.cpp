@@ -0,0 +1,382 @@
+/*-----------------------------------------------------------------------------
+	ColdFire Macro Assembler and Simulator
+
+	Copyright (C) 2007-2012 Mike Kowalski
+
+	See License.txt for more details
+-----------------------------------------------------------------------------*/
+
+#include "pch.h"
+#include "MultiCore.h"
+#include "Context.h"
+#include "Exceptions.h"
+
+
+MultiCore::MultiCore()
+{
+	quantum_ = 1000;
+	interrupt_level_ = 6;
+	next_barrier_ = 0;
+	attached_ = false;
+	primary_ = nullptr;
+	generation_ = 0;
+	running_ = 0;
+	quit_ = false;
+}
+
+
+MultiCore::~MultiCore()
+{
+	Detach();
+	Configure(1, quantum_, interrupt_level_);
+}
+
+
+void MultiCore::Configure(int cores, uint32 quantum, int interrupt_level)
+{
+	if (attached_)
+		throw LogicError("Cores cannot be configured while they are running in " __FUNCTION__);
+
+	if (cores < 1 || cores > MAX_CORES)
+		throw RunTimeError("Up to 16 cores supported " __FUNCTION__);
+
+	if (quantum == 0)
+		throw RunTimeError("Quantum has to be at least one cycle " __FUNCTION__);
+
+	if (interrupt_level < 1 || interrupt_level > 7)
+		throw RunTimeError("Cross-core interrupt level has to be in 1..7 range " __FUNCTION__);
+
+	quantum_ = quantum;
+	interrupt_level_ = interrupt_level;
+
+	if (cores == Cores())
+		return;
+
+	// stop existing worker threads
+	{
+		std::lock_guard<std::mutex> lock(lock_);
+		quit_ = true;
+	}
+	start_.notify_all();
+	for (auto& t : threads_)
+		t.join();
+	threads_.clear();
+	quit_ = false;
+
+	cores_.resize(cores - 1);
+	for (auto& core : cores_)
+		if (!core)
+		{
+			core.reset(new CoreState());
+			core->ctx.reset(new Context(ISA::A));
+			core->started = false;
+			core->until = 0;
+		}
+
+	for (int i= 0; i < cores - 1; ++i)
+		threads_.push_back(std::thread(&MultiCore::Worker, this, i, generation_));
+}
+
+
+Context& MultiCore::Core(int index)
+{
+	return *cores_.at(index - 1)->ctx;
+}
+
+
+const Context& MultiCore::Core(int index) const
+{
+	return *cores_.at(index - 1)->ctx;
+}
+
+
+void MultiCore::Reset(const Context& primary)
+{
+	for (auto& core : cores_)
+	{
+		auto& ctx= *core->ctx;
+		if (ctx.GetIsa() != primary.GetIsa())
+			ctx.SetIsa(primary.GetIsa());
+
+		ctx.Cpu().SetDefaults(cf::R_VBR, primary.Cpu().vbr);
+		ctx.Cpu().SetDefaults(cf::R_MBAR, primary.Cpu().mbar);
+		ctx.Cpu().ResetRegs();
+		ctx.HaltExecution(false);
+		ctx.ExitStopState();
+
+		core->started = false;
+		core->interrupts.clear();
+	}
+
+	std::lock_guard<std::mutex> lock(lock_);
+	requests_.clear();
+	primary_interrupts_.clear();
+}
+
+
+void MultiCore::Attach(Context& primary, const IOHandler& peripherals_io, const IOHandler& simulator_io)
+{
+	if (!Active() || attached_)
+		return;
+
+	for (int i= 0; i < static_cast<int>(cores_.size()); ++i)
+	{
+		auto& core= *cores_[i];
+		auto& ctx= *core.ctx;
+		int index= i + 1;
+
+		if (ctx.GetIsa() != primary.GetIsa())
+			ctx.SetIsa(primary.GetIsa());
+
+		// memory banks may have been redefined since the last run
+		ctx.ShareMemory(primary);
+		ctx.SetSimulatorIOArea(primary.GetSimulatorIOArea());
+		ctx.SetPeripheralCallback([&ctx, peripherals_io](uint32 addr, int access_size, uint32& val, bool read)
+		{
+			return peripherals_io(ctx, addr, access_size, val, read);
+		});
+		ctx.SetSimulatorCallback([this, index, &ctx, simulator_io](uint32 addr, int access_size, uint32& val, bool read)
+		{
+			auto port= static_cast<cf::SimPort>(addr - ctx.GetSimulatorIOArea());
+			return SimulatorIO(index, ctx, port, access_size, val, read) || simulator_io(ctx, addr, access_size, val, read);
+		});
+		ctx.SetBusLock(&bus_lock_);
+		// devices accessed by this core raise their interrupt requests in core 0's interrupt controllers
+		// (only core 0 takes them), and they time their events in cycles of the accessing core
+		ctx.SetICM(primary.GetICM());
+		ctx.SetTotalCycles(primary.TotalCycles());
+
+		core.until = ctx.TotalCycles();
+	}
+
+	primary.SetBusLock(&bus_lock_);
+	primary_ = &primary;
+	next_barrier_ = primary.TotalCycles() + quantum_;
+	attached_ = true;
+
+	// secondary cores run their quantum along with core 0
+	std::lock_guard<std::mutex> lock(lock_);
+	Release(quantum_);
+}
+
+
+void MultiCore::Detach()
+{
+	if (!attached_)
+		return;
+
+	{
+		std::unique_lock<std::mutex> lock(lock_);
+		WaitForCores(lock);
+	}
+
+	for (auto& core : cores_)
+		core->ctx->SetBusLock(nullptr);
+	primary_->SetBusLock(nullptr);
+	primary_ = nullptr;
+
+	attached_ = false;
+}
+
+
+void MultiCore::Barrier(Context& primary)
+{
+	{
+		std::unique_lock<std::mutex> lock(lock_);
+		WaitForCores(lock);
+
+		// other cores are parked now, their state can be changed
+		for (auto& r : requests_)
+		{
+			if (r.core == 0)
+			{
+				if (r.kind == Request::INTERRUPT)
+					primary_interrupts_.push_back(static_cast<uint8>(r.pc));
+				continue;
+			}
+
+			auto& core= *cores_[r.core - 1];
+			switch (r.kind)
+			{
+			case Request::START:
+				{
+					auto& cpu= core.ctx->Cpu();
+					cpu.ResetRegs();
+					cpu.a_reg[7] = r.sp;
+					cpu.pc = r.pc;
+					core.ctx->HaltExecution(false);
+					core.ctx->ExitStopState();
+					core.interrupts.clear();
+					core.started = true;
+				}
+				break;
+
+			case Request::INTERRUPT:
+				core.interrupts.push_back(static_cast<uint8>(r.pc));
+				break;
+			}
+		}
+		requests_.clear();
+
+		for (auto& core : cores_)
+			if (core->started)
+				Deliver(*core->ctx, core->interrupts);
+
+		// barriers are spaced by a quantum; if core 0 jumped past the next one, the next quantum starts where it is
+		auto now= primary.TotalCycles();
+		auto next= next_barrier_ + quantum_;
+		if (next <= now)
+			next = now + quantum_;
+
+		Release(next - next_barrier_);
+		next_barrier_ = next;
+	}
+
+	// this may throw ExceptionReported, so it's done when other cores are already running
+	Deliver(primary, primary_interrupts_);
+}
+
+
+std::unique_lock<std::recursive_mutex> MultiCore::LockIO()
+{
+	return attached_ ? std::unique_lock<std::recursive_mutex>(io_lock_) : std::unique_lock<std::recursive_mutex>();
+}
+
+
+bool MultiCore::SimulatorIO(int core, Context& ctx, cf::SimPort port, int access_size, uint32& value, bool read)
+{
+	switch (port)
+	{
+	case cf::SimPort::CORE_ID:
+	case cf::SimPort::CORE_COUNT:
+	case cf::SimPort::CORE_START:
+	case cf::SimPort::CORE_INTERRUPT:
+		if (access_size != 4)
+			return false;
+		break;
+
+	default:
+		return false;
+	}
+
+	if (read)
+	{
+		switch (port)
+		{
+		case cf::SimPort::CORE_ID:		value = core; break;
+		case cf::SimPort::CORE_COUNT:	value = Cores(); break;
+		default:						value = 0; break;	// write-only ports
+		}
+		return true;
+	}
+
+	Request r= { Request::START, 0, 0, 0 };
+	switch (port)
+	{
+	case cf::SimPort::CORE_START:
+		r.core = static_cast<int>(ctx.GetLongWord(value));
+		r.pc = ctx.GetLongWord(value + 4);
+		r.sp = ctx.GetLongWord(value + 8);
+		if (r.core < 1 || r.core >= Cores())
+			return true;	// core 0 is started by reset; missing cores are ignored
+		break;
+
+	case cf::SimPort::CORE_INTERRUPT:
+		r.kind = Request::INTERRUPT;
+		r.core = (value >> 8) & 0xff;
+		r.pc = value & 0xff;
+		if (r.core >= Cores())
+			return true;
+		break;
+
+	default:
+		return true;	// read-only ports
+	}
+
+	std::lock_guard<std::mutex> lock(lock_);
+	requests_.push_back(r);
+
+	return true;
+}
+
+
+void MultiCore::Worker(int index, uint64 generation)
+{
+	auto& core= *cores_[index];
+
+	std::unique_lock<std::mutex> lock(lock_);
+	for (;;)
+	{
+		start_.wait(lock, [&] { return quit_ || generation_ != generation; });
+		if (quit_)
+			return;
+		generation = generation_;
+
+		lock.unlock();
+		Run(core);
+		lock.lock();
+
+		if (--running_ == 0)
+			done_.notify_all();
+	}
+}
+
+
+void MultiCore::Run(CoreState& core)
+{
+	auto& ctx= *core.ctx;
+
+	try
+	{
+		while (ctx.TotalCycles() < core.until)
+		{
+			if (!core.started || ctx.IsExecutionHalted() || ctx.IsInStopState())
+			{
+				// nothing to execute; let time pass till the barrier, where requests can wake core up
+				ctx.SkipCycles(static_cast<uint32>(core.until - ctx.TotalCycles()));
+				break;
+			}
+
+			// secondary cores have no debugger attached; all exceptions go to their handlers
+			ctx.ExecuteInstruction(true);
+		}
+	}
+	catch (...)
+	{
+		// fault-on-fault halts the core
+		ctx.HaltExecution(true);
+	}
+}
+
+
+// called with lock_ held
+void MultiCore::Release(uint64 span)
+{
+	for (auto& core : cores_)
+		core->until += span;
+
+	running_ = static_cast<int>(cores_.size());
+	++generation_;
+	start_.notify_all();
+}
+
+
+void MultiCore::WaitForCores(std::unique_lock<std::mutex>& lock)
+{
+	done_.wait(lock, [&] { return running_ == 0; });
+}
+
+
+void MultiCore::Deliver(Context& ctx, std::vector<uint8>& interrupts)
+{
+	// one request at a time; the next one waits till handler lowers interrupt priority mask
+	if (interrupts.empty() || ctx.IsExecutionHalted())
+		return;
+
+	if (interrupt_level_ == 7 || interrupt_level_ > ctx.Cpu().InterruptLevel())
+	{
+		auto vector= static_cast<CpuExceptions>(interrupts.front());
+		interrupts.erase(interrupts.begin());
+		ctx.EnterInterrupt(INTERRUPT_SOURCE, vector, interrupt_level_);
+	}
+}
@@ -0,0 +1,113 @@
+/*-----------------------------------------------------------------------------
+	ColdFire Macro Assembler and Simulator
+
+	Copyright (C) 2007-2012 Mike Kowalski
+
+	See License.txt for more details
+-----------------------------------------------------------------------------*/
+
+#pragma once
+#include "BasicTypes.h"
+#include "Types.h"
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+
+class Context;
+
+
+// Additional cores of a multi-processor board. Core 0 is the primary one: it is driven by the simulator's
+// execution thread, owns breakpoints, statistics and devices, and it is the one peripherals see.
+// Other cores run on their own host threads; they share memory banks and peripherals with core 0.
+//
+// Cores advance in quanta: all of them run till the next cycle barrier and wait for each other there.
+// Requests that change state of other cores (start, interrupt) are queued and carried out at barriers,
+// when no core is running. Secondary cores have no caches, breakpoints, write watches or statistics.
+
+class MultiCore
+{
+public:
+	MultiCore();
+	~MultiCore();
+
+	enum { MAX_CORES= 16 };
+	enum { INTERRUPT_SOURCE= 64 };	// source reported to interrupt observers for cross-core interrupts
+
+	// total number of cores (including core 0); throws RunTimeError if parameters are not valid;
+	// it cannot be called while cores are running
+	void Configure(int cores, uint32 quantum, int interrupt_level);
+
+	int Cores() const					{ return static_cast<int>(cores_.size()) + 1; }
+	bool Active() const					{ return !cores_.empty(); }
+	uint32 Quantum() const				{ return quantum_; }
+
+	// secondary core (1 .. Cores()-1)
+	Context& Core(int index);
+	const Context& Core(int index) const;
+
+	// reset secondary cores; they are held in reset till core started by CORE_START request
+	void Reset(const Context& primary);
+
+	// start running secondary cores along with 'primary', or park them after their current quantum ends;
+	// I/O handlers are shared by all cores: they receive context of the core making an access, and they
+	// are expected to call LockIO
+	typedef std::function<bool (Context& ctx, uint32 addr, int access_size, uint32& val, bool read)> IOHandler;
+	void Attach(Context& primary, const IOHandler& peripherals_io, const IOHandler& simulator_io);
+	void Detach();
+
+	// cycle count of core 0 at which it should call Barrier()
+	uint64 NextBarrier() const			{ return next_barrier_; }
+
+	// wait for other cores to finish their quantum, carry out queued requests and start the next quantum
+	void Barrier(Context& primary);
+
+	// guards peripherals and simulator I/O when cores are running; unlocked if there's only one core;
+	// it is recursive, as devices access memory (and other devices) while serving an access
+	std::unique_lock<std::recursive_mutex> LockIO();
+
+	// service CORE_xxx ports accessed by 'core'; false for other ports
+	bool SimulatorIO(int core, Context& ctx, cf::SimPort port, int access_size, uint32& value, bool read);
+
+private:
+	struct Request
+	{
+		enum Kind { START, INTERRUPT } kind;
+		int core;
+		uint32 pc;		// START: initial PC and SSP; INTERRUPT: vector in 'pc'
+		uint32 sp;
+	};
+
+	struct CoreState
+	{
+		std::unique_ptr<Context> ctx;
+		bool started;			// released from reset
+		uint64 until;			// end of current quantum in core's own cycles
+		std::vector<uint8> interrupts;	// pending cross-core interrupt vectors
+	};
+
+	void Worker(int index, uint64 generation);
+	void Run(CoreState& core);
+	void Release(uint64 span);
+	void WaitForCores(std::unique_lock<std::mutex>& lock);
+	void Deliver(Context& ctx, std::vector<uint8>& interrupts);
+
+	std::vector<std::unique_ptr<CoreState>> cores_;	// secondary cores; core 1 at index 0
+	std::vector<std::thread> threads_;
+	std::vector<Request> requests_;				// guarded by lock_
+	std::vector<uint8> primary_interrupts_;		// pending interrupts of core 0
+	uint32 quantum_;
+	int interrupt_level_;
+	uint64 next_barrier_;
+	bool attached_;
+	Context* primary_;
+
+	std::mutex lock_;
+	std::condition_variable start_;		// new quantum or quit
+	std::condition_variable done_;		// core finished its quantum
+	uint64 generation_;					// quantum counter
+	int running_;						// cores still running current quantum
+	bool quit_;
+
+	std::recursive_mutex io_lock_;		// devices are not thread-safe
+	std::mutex bus_lock_;				// indivisible read-modify-write cycles (TAS)
+};
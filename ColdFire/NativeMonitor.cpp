@@ -0,0 +1,193 @@
+/*-----------------------------------------------------------------------------
+	ColdFire Macro Assembler and Simulator
+
+	Copyright (C) 2007-2012 Mike Kowalski
+
+	See License.txt for more details
+-----------------------------------------------------------------------------*/
+
+#include "pch.h"
+#include "NativeMonitor.h"
+#include "Context.h"
+
+namespace {
+
+// monitor routines, in the order of its jump table
+enum MonitorFn : uint16
+{
+	Terminate, Clear, PutC, GetC, PutS, GetS, PutInt, PutUInt, PutHex,
+	GetCursorX, GetCursorY, SetCursorX, SetCursorY,
+	GetTerminalWidth, GetTerminalHeight, SetTerminalWidth, SetTerminalHeight,
+	GetRTTimer, GetDateTime, GetRandomNumber, RunAsSuper, Sleep,
+	FunctionCount
+};
+
+
+void SetLowWord(uint32& reg, uint32 value)
+{
+	reg = (reg & 0xffff0000) | (value & 0xffff);
+}
+
+
+// output NUL-terminated string; returns false if it cannot be read from memory (then monitor will fault on it)
+bool OutputString(Context& ctx, uint32& addr)
+{
+	std::string str;
+	for (uint32 a= addr; ; ++a)
+	{
+		DecodedAddress da= ctx.GetMemoryAddress(a, 1, true);
+		if (da.type != DecodedAddress::RAM && da.type != DecodedAddress::FLASH)
+			return false;
+
+		auto c= *static_cast<const uint8*>(da.address);
+		if (c == 0)
+			break;
+		str += static_cast<char>(c);
+	}
+
+	for (auto c : str)
+		ctx.SimWrite(cf::SimPort::IN_OUT, static_cast<uint8>(c));
+
+	addr += static_cast<uint32>(str.size()) + 1;	// past NUL
+	return true;
+}
+
+
+void OutputUInt(Context& ctx, uint32 value)
+{
+	char digits[12];
+	int len= 0;
+	do
+	{
+		digits[len++] = static_cast<char>('0' + value % 10);
+		value /= 10;
+	} while (value != 0);
+
+	while (len > 0)
+		ctx.SimWrite(cf::SimPort::IN_OUT, static_cast<uint8>(digits[--len]));
+}
+
+} // namespace
+
+
+bool NativeMonitorCall(Context& ctx)
+{
+	auto& cpu= ctx.Cpu();
+
+	// number of routine to run is at the top of caller's stack
+	DecodedAddress da= ctx.GetMemoryAddress(cpu.a_reg[7], 2, true);
+	if (da.type != DecodedAddress::RAM && da.type != DecodedAddress::FLASH)
+		return false;
+
+	auto fn= ctx.ReadMemoryWord(cpu.a_reg[7]);
+
+	uint32& d0= cpu.d_reg[0];
+	uint32& d1= cpu.d_reg[1];
+	uint32& d2= cpu.d_reg[2];
+
+	switch (fn)
+	{
+	case Terminate:
+		ctx.HaltExecution(true);
+		break;
+
+	case Clear:
+		ctx.SimWrite(cf::SimPort::CLEAR, 0);
+		break;
+
+	case PutC:
+		ctx.SimWrite(cf::SimPort::IN_OUT, d0 & 0xffff);
+		break;
+
+	case GetC:
+		SetLowWord(d0, ctx.SimRead(cf::SimPort::IN_OUT));
+		break;
+
+	case PutS:
+		if (!OutputString(ctx, cpu.a_reg[0]))
+			return false;
+		d0 = 0;
+		break;
+
+	case PutInt:
+	case PutUInt:
+		if (fn == PutInt && static_cast<int32>(d0) < 0)
+		{
+			ctx.SimWrite(cf::SimPort::IN_OUT, '-');
+			d0 = 0 - d0;
+		}
+		OutputUInt(ctx, d0);
+		// registers as left by monitor's digit loop
+		d0 = d0 == 0 ? '0' : 0;
+		d1 = 0;
+		d2 = ~0u;
+		break;
+
+	case PutHex:
+		{
+			// length in bytes is ignored by the monitor as long as it's in 1..4 range; it prints all 8 digits
+			int8 len= static_cast<int8>(d1);
+			d1 = static_cast<uint32>(static_cast<int32>(len));
+			if (d1 == 0 || d1 > 4)
+				break;
+
+			static const char hex[]= "0123456789ABCDEF";
+			for (int shift= 28; shift >= 0; shift -= 4)
+				ctx.SimWrite(cf::SimPort::IN_OUT, static_cast<uint8>(hex[(d0 >> shift) & 0xf]));
+			d2 = d0 >> 28;
+			d0 = 0;
+			d1 = 0;
+		}
+		break;
+
+	case GetCursorX:
+		SetLowWord(d0, ctx.SimRead(cf::SimPort::X_POS));
+		break;
+	case GetCursorY:
+		SetLowWord(d0, ctx.SimRead(cf::SimPort::Y_POS));
+		break;
+	case SetCursorX:
+		ctx.SimWrite(cf::SimPort::X_POS, d0 & 0xffff);
+		break;
+	case SetCursorY:
+		ctx.SimWrite(cf::SimPort::Y_POS, d0 & 0xffff);
+		break;
+
+	case GetTerminalWidth:
+		SetLowWord(d0, ctx.SimRead(cf::SimPort::WIDTH));
+		break;
+	case GetTerminalHeight:
+		SetLowWord(d0, ctx.SimRead(cf::SimPort::HEIGHT));
+		break;
+	case SetTerminalWidth:
+		ctx.SimWrite(cf::SimPort::WIDTH, d0 & 0xffff);
+		break;
+	case SetTerminalHeight:
+		ctx.SimWrite(cf::SimPort::HEIGHT, d0 & 0xffff);
+		break;
+
+	case GetRTTimer:
+		d0 = ctx.SimRead(cf::SimPort::TICK_COUNT);
+		break;
+	case GetDateTime:
+		d0 = ctx.SimRead(cf::SimPort::DATE_TIME);
+		break;
+	case GetRandomNumber:
+		d0 = ctx.SimRead(cf::SimPort::RND_NUM) & 0xffff;
+		break;
+
+	case GetS:
+	case RunAsSuper:
+	case Sleep:
+		return false;
+
+	default:
+		// unknown routines are ignored by the monitor
+		break;
+	}
+
+	// all monitor routines are output/input operations
+	ctx.NoteSideEffect();
+
+	return true;
+}
@@ -0,0 +1,17 @@
+/*-----------------------------------------------------------------------------
+	ColdFire Macro Assembler and Simulator
+
+	Copyright (C) 2007-2012 Mike Kowalski
+
+	See License.txt for more details
+-----------------------------------------------------------------------------*/
+
+#pragma once
+class Context;
+
+// High-level emulation of monitor (Monitor/CFMonitor.cfs) services invoked with TRAP #15.
+// Requested service is performed directly by the simulator leaving D0-D2 and CCR exactly like the monitor
+// would; monitor code is not executed. Services that wait for input or time (GetS, Sleep) or run
+// user code (RunAsSuper) are left to the monitor: handler returns false for them.
+
+bool NativeMonitorCall(Context& ctx);
@@ -12,7 +12,7 @@
 #include "Exceptions.h"
 
 
-Peripheral::Peripheral(const PParam& params) : params_(params)
+Peripheral::Peripheral(const PParam& params) : params_(params), refresh_(false)
 {}
 
 
@@ -88,9 +88,21 @@ private:
 };
 
 
-void Peripheral::DoUpdate(Context& ctx)
+bool Peripheral::DoUpdate(Context& ctx)
 {
 	Update(ctx);
+
+	if (!refresh_)
+		return false;
+
+	refresh_ = false;
+	return true;
+}
+
+
+void Peripheral::RequestRefresh()
+{
+	refresh_ = true;
 }
 
 
@@ -126,6 +138,31 @@ void Peripheral::DoWrite(Context& ctx, uint32 offset, int access_size, uint32 va
 }
 
 
+bool Peripheral::DoNextEvent(const Context& ctx, EventScope scope, uint32& at_cycle) const
+{
+	return NextEvent(ctx, scope, at_cycle);
+}
+
+
+bool Peripheral::NextEvent(const Context& ctx, EventScope scope, uint32& at_cycle) const
+{
+	return false;
+}
+
+
+bool Peripheral::DoReadHasSideEffects(uint32 offset) const
+{
+	// tracing outputs every access
+	return params_.trace_ || ReadHasSideEffects(offset);
+}
+
+
+bool Peripheral::ReadHasSideEffects(uint32 offset) const
+{
+	return true;
+}
+
+
 cf::uint8 Peripheral::ReadBufferByte(cf::uint32 index)
 {
 	throw RunTimeError("ReadBufferByte is not supported by this device");
@@ -138,6 +175,12 @@ cf::uint32 Peripheral::ReadBufferLongWord(cf::uint32 index)
 }
 
 
+void Peripheral::ReadBuffer(cf::uint32 offset, cf::uint8* dest, cf::uint32 length)
+{
+	throw RunTimeError("ReadBuffer is not supported by this device");
+}
+
+
 const std::string& Peripheral::Category() const
 {
 	return params_.category_;
@@ -53,6 +53,14 @@ struct PParam	// peripheral parameters
 typedef boost::property_tree::ptree PeripheralConfigData;
 
 
+// kinds of device events simulator may be waiting for
+enum class EventScope
+{
+	Any,		// any change of device state that CPU can observe (register values, interrupt requests)
+	Interrupt	// only changes that can result in interrupt request
+};
+
+
 class Peripheral : public PeripheralDevice, boost::noncopyable
 {
 public:
@@ -60,10 +68,16 @@ public:
 	virtual ~Peripheral();
 
 	// interface exposed to simulator
-	void DoUpdate(Context& ctx);
+	// update returns true if device asked for client's view to be refreshed (RequestRefresh)
+	bool DoUpdate(Context& ctx);
 	void DoReset(Context& ctx);
 	uint32 DoRead(Context& ctx, uint32 offset, int access_size);
 	void DoWrite(Context& ctx, uint32 offset, int access_size, uint32 value);
+	// report cycle count at which device is going to change its state on its own (like timer tick);
+	// returns false if device has no such event pending; used by simulator to skip idle time
+	bool DoNextEvent(const Context& ctx, EventScope scope, uint32& at_cycle) const;
+	// true if reading register at 'offset' changes device state (like popping receiver FIFO)
+	bool DoReadHasSideEffects(uint32 offset) const;
 
 	// report where device registers are mapped in a 1 KB peripherals space
 	// offsets from 0 are expected, from first to the last valid entry;
@@ -85,6 +99,9 @@ public:
 protected:
 	void SetIOAreaSize(cf::uint32 size);
 
+	// ask simulator to notify client that device's view needs refreshing; simulation thread only
+	void RequestRefresh();
+
 	// implementation details
 private:
 	// called during simulator run after executing single opcode
@@ -99,11 +116,21 @@ private:
 	// write to device; access_size is 1, 2, or 4
 	virtual void Write(Context& ctx, uint32 offset, int access_size, uint32 value) = 0;
 
+	// devices changing their state in time (without CPU access) should report when it happens next;
+	// default implementation: no events
+	virtual bool NextEvent(const Context& ctx, EventScope scope, uint32& at_cycle) const;
+
+	// devices with status registers that can be polled without consequences should say so;
+	// this lets simulator recognize polling loops; default implementation: every read has side effects
+	virtual bool ReadHasSideEffects(uint32 offset) const;
+
 	// up to the device to implement if needed; simulator may use it to query state of the device
 	virtual cf::uint8 ReadBufferByte(cf::uint32 index);
 	virtual cf::uint32 ReadBufferLongWord(cf::uint32 index);
+	virtual void ReadBuffer(cf::uint32 offset, cf::uint8* dest, cf::uint32 length);
 
 	// location of device IO area comes from configuration, and its size is typically device specific;
 	// each device has to provide size of this window
 	PParam params_;
+	bool refresh_;
 };
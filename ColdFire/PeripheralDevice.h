@@ -19,6 +19,8 @@ public:
 
 	virtual cf::uint8 ReadBufferByte(cf::uint32 index) = 0;
 	virtual cf::uint32 ReadBufferLongWord(cf::uint32 index) = 0;
+	// consistent copy of device buffer range; it can be called while simulation is running
+	virtual void ReadBuffer(cf::uint32 offset, cf::uint8* dest, cf::uint32 length) = 0;
 
 	virtual cf::uint32 IOAreaStart() const = 0;
 	virtual cf::uint32 IOAreaSize() const = 0;
@@ -46,4 +48,8 @@ public:
 		Polling			// display needs periodic polling to refresh
 	};
 	virtual NotifyType ChangeNotification() const = 0;
+
+	// range of rows changed since last call (inclusive); it resets the range; returns false if nothing
+	// changed; displays that don't track changes report all rows
+	virtual bool TakeDirtyRows(cf::uint32& first, cf::uint32& last) = 0;
 };
@@ -8,22 +8,81 @@
 
 #include "pch.h"
 #include <assert.h>
-#include <mutex>
+#include <atomic>
+#include <thread>
 #include "BlockDevice.h"
 #include "../Context.h"
 #include "../PeripheralRepository.h"
+#include "../Exceptions.h"
 
 // do NOT register block device; it is a building block only
 
 
+// Memory block is written by simulator's thread only; it never waits. Other threads read it under
+// a sequence lock: they retry if they overlap with a write, so they always get a consistent copy.
+
 struct BlockDevice::_dev_data
 {
-	_dev_data(uint32 size) : enabled(true), mem_block_(size / sizeof(mem_block_.front()), 0)
-	{}
+	_dev_data(uint32 size) : enabled(true), size_(0), sequence_(0)
+	{
+		Resize(size);
+	}
+
+	void Resize(uint32 size)
+	{
+		std::unique_ptr<std::atomic<uint8>[]> block(new std::atomic<uint8>[size]);
+		for (uint32 i= 0; i < size; ++i)
+			block[i].store(i < size_ ? Get(i) : 0, std::memory_order_relaxed);
+		mem_block_ = std::move(block);
+		size_ = size;
+	}
+
+	// simulator's thread
+	uint8 Get(uint32 index) const
+	{
+		return mem_block_[index].load(std::memory_order_relaxed);
+	}
+
+	void Set(uint32 index, uint8 value)
+	{
+		mem_block_[index].store(value, std::memory_order_relaxed);
+	}
+
+	template<class Fn>
+	void Modify(Fn fn)
+	{
+		auto seq= sequence_.load(std::memory_order_relaxed);
+		sequence_.store(seq + 1, std::memory_order_relaxed);	// odd: write in progress
+		std::atomic_thread_fence(std::memory_order_release);
+		fn();
+		sequence_.store(seq + 2, std::memory_order_release);
+	}
+
+	// other threads
+	template<class Fn>
+	void Copy(Fn fn) const
+	{
+		for (;;)
+		{
+			auto seq= sequence_.load(std::memory_order_acquire);
+			if (seq & 1)
+			{
+				std::this_thread::yield();
+				continue;
+			}
+
+			fn();
+
+			std::atomic_thread_fence(std::memory_order_acquire);
+			if (sequence_.load(std::memory_order_relaxed) == seq)
+				return;
+		}
+	}
 
 	bool enabled;
-	std::vector<cf::uint8> mem_block_;
-	mutable std::mutex lock_;
+	std::unique_ptr<std::atomic<uint8>[]> mem_block_;
+	uint32 size_;
+	std::atomic<uint32> sequence_;
 };
 
 
@@ -49,7 +108,11 @@ void BlockDevice::Update(Context& ctx)
 void BlockDevice::Reset()
 {
 	// clear memory block
-	std::fill(data->mem_block_.begin(), data->mem_block_.end(), 0);
+	data->Modify([this]
+	{
+		for (uint32 i= 0; i < data->size_; ++i)
+			data->Set(i, 0);
+	});
 }
 
 
@@ -58,25 +121,25 @@ uint32 BlockDevice::Read(uint32 offset, int access_size)
 {
 	uint32 result= 0;
 
-	if (data->enabled && offset + access_size <= data->mem_block_.size() && access_size > 0)
+	if (data->enabled && offset + access_size <= data->size_ && access_size > 0)
 	{
 		// reading by simulator's thread; no locking
 
 		switch (access_size)
 		{
 		case 1:
-			result = data->mem_block_[offset];
+			result = data->Get(offset);
 			break;
 
 		case 2:
-			result = (static_cast<uint32>(data->mem_block_[offset]) << 8) | data->mem_block_[offset + 1];
+			result = (static_cast<uint32>(data->Get(offset)) << 8) | data->Get(offset + 1);
 			break;
 
 		case 4:
-			result = (static_cast<uint32>(data->mem_block_[offset + 0]) << 24) |
-					 (static_cast<uint32>(data->mem_block_[offset + 1]) << 16) |
-					 (static_cast<uint32>(data->mem_block_[offset + 2]) << 8) |
-					 data->mem_block_[offset + 3];
+			result = (static_cast<uint32>(data->Get(offset + 0)) << 24) |
+					 (static_cast<uint32>(data->Get(offset + 1)) << 16) |
+					 (static_cast<uint32>(data->Get(offset + 2)) << 8) |
+					 data->Get(offset + 3);
 			break;
 		}
 	}
@@ -85,44 +148,48 @@ uint32 BlockDevice::Read(uint32 offset, int access_size)
 }
 
 
+bool BlockDevice::ReadHasSideEffects(uint32 offset) const
+{
+	return false;
+}
+
+
 // write to block device; access_size is 1, 2, or 4
 void BlockDevice::Write(Context& ctx, uint32 offset, int access_size, uint32 value)
 {
-	if (data->enabled && offset + access_size <= data->mem_block_.size() && access_size > 0)
+	if (data->enabled && offset + access_size <= data->size_ && access_size > 0)
 	{
-		// writing by simulator's thread
-		std::lock_guard<std::mutex> l(data->lock_);
-
-		switch (access_size)
+		// writing by simulator's thread; readers will notice and retry
+		data->Modify([&]
 		{
-		case 1:
-			data->mem_block_[offset] = uint8(value);
-			break;
-
-		case 2:
-			data->mem_block_[offset + 0] = static_cast<uint8>(value >> 8);
-			data->mem_block_[offset + 1] = static_cast<uint8>(value);
-			break;
-
-		case 4:
-			data->mem_block_[offset + 0] = static_cast<uint8>(value >> 24);
-			data->mem_block_[offset + 1] = static_cast<uint8>(value >> 16);
-			data->mem_block_[offset + 2] = static_cast<uint8>(value >> 8);
-			data->mem_block_[offset + 3] = static_cast<uint8>(value);
-			break;
-		}
+			switch (access_size)
+			{
+			case 1:
+				data->Set(offset, uint8(value));
+				break;
+
+			case 2:
+				data->Set(offset + 0, static_cast<uint8>(value >> 8));
+				data->Set(offset + 1, static_cast<uint8>(value));
+				break;
+
+			case 4:
+				data->Set(offset + 0, static_cast<uint8>(value >> 24));
+				data->Set(offset + 1, static_cast<uint8>(value >> 16));
+				data->Set(offset + 2, static_cast<uint8>(value >> 8));
+				data->Set(offset + 3, static_cast<uint8>(value));
+				break;
+			}
+		});
 	}
 }
 
 
 uint8 BlockDevice::ReadBufferByte(uint32 index)
 {
-	if (index < data->mem_block_.size())
-	{
-		// reading from the main thread
-		std::lock_guard<std::mutex> l(data->lock_);
-		return data->mem_block_[index];
-	}
+	// reading from the main thread; single byte is always consistent
+	if (index < data->size_)
+		return data->Get(index);
 
 	return 0;
 }
@@ -133,20 +200,38 @@ uint32 BlockDevice::ReadBufferLongWord(uint32 index)
 	const auto size= sizeof(uint32);
 	index *= size;
 
-	if (index < data->mem_block_.size())
+	uint32 result= 0;
+
+	if (index + size <= data->size_)
 	{
 		// reading from the main thread
-		std::lock_guard<std::mutex> l(data->lock_);
-		return Read(index, size);
+		data->Copy([&]
+		{
+			result = Read(index, size);
+		});
 	}
 
-	return 0;
+	return result;
+}
+
+
+void BlockDevice::ReadBuffer(cf::uint32 offset, cf::uint8* dest, cf::uint32 length)
+{
+	if (offset > data->size_ || length > data->size_ - offset)
+		throw RunTimeError("Block device buffer read out of range in " __FUNCTION__);
+
+	// reading from the main thread; entire range comes from the same moment
+	data->Copy([&]
+	{
+		for (uint32 i= 0; i < length; ++i)
+			dest[i] = data->Get(offset + i);
+	});
 }
 
 
 void BlockDevice::Resize(cf::uint32 size)
 {
-	data->mem_block_.resize(size, 0);
+	data->Resize(size);
 
 	SetIOAreaSize(size);
 }
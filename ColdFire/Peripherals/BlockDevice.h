@@ -28,8 +28,12 @@ public:
 	// write to device; access_size is 1, 2, or 4
 	virtual void Write(Context& ctx, uint32 offset, int access_size, uint32 value);
 
+	// reading registers doesn't change device state
+	virtual bool ReadHasSideEffects(uint32 offset) const;
+
 	virtual cf::uint8 ReadBufferByte(cf::uint32 index);
 	virtual cf::uint32 ReadBufferLongWord(cf::uint32 index);
+	virtual void ReadBuffer(cf::uint32 offset, cf::uint8* dest, cf::uint32 length);
 
 protected:
 	void Resize(cf::uint32 size);
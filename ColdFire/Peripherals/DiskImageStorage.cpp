@@ -0,0 +1,351 @@
+/*-----------------------------------------------------------------------------
+	ColdFire Macro Assembler and Simulator
+
+	Copyright (C) 2007-2012 Mike Kowalski
+
+	See License.txt for more details
+-----------------------------------------------------------------------------*/
+
+#include "pch.h"
+#include "DiskImageStorage.h"
+#include "../Context.h"
+#include "../PeripheralRepository.h"
+#include "../Exceptions.h"
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+
+namespace bi= boost::interprocess;
+
+// register disk image storage
+static auto reg_storage= GetPeripherals().Register("storage", "disk_image", &CreateDevice2<DiskImageStorage>);
+
+
+enum Offset : uint32	// offsets from device base
+{
+	LBA= 0x00,			// first sector
+	ADDRESS= 0x04,		// guest memory buffer
+	COUNT= 0x08,		// number of sectors
+	COMMAND= 0x0c,		// command (byte, write only)
+	CONTROL= 0x0d,		// control (byte)
+	STATUS= 0x0e,		// status (byte)
+	IVR= 0x0f,			// interrupt vector (byte)
+	CAPACITY= 0x10,		// image size in sectors (read only)
+	SECTOR_SIZE= 0x14,	// bytes per sector (read only)
+	END= 0x18
+};
+
+enum : uint8
+{
+	CMD_READ= 1,		// image to memory
+	CMD_WRITE= 2,		// memory to image
+	CMD_FLUSH= 3,		// write modified sectors back to the host file
+
+	CTRL_IE= 0x01,		// interrupt on completion
+
+	ST_BUSY= 0x80,
+	ST_ERROR= 0x02,		// invalid command, sector range or memory buffer; bad image access
+	ST_DONE= 0x01		// writing 1 clears DONE and ERROR
+};
+
+// image is mapped in windows of this size (multiple of allocation granularity)
+const uint64 WINDOW= 64 << 20;
+
+
+struct DiskImageStorage::_dev_data
+{
+	_dev_data() : LBA(0), ADDRESS(0), COUNT(0), CONTROL(0), STATUS(0), IVR(0), irq(-1),
+		busy(false), start(0), duration(0), end_status(0), read_only(false), sector_size(512),
+		image_size(0), latency_cycles(0), sector_cycles(0), window_base(0)
+	{}
+
+	uint32 LBA;
+	uint32 ADDRESS;
+	uint32 COUNT;
+	uint8 CONTROL;
+	uint8 STATUS;
+	uint8 IVR;
+	char irq;				// interrupt request state as reported to ICM; -1 if not known
+
+	// command in progress
+	bool busy;
+	uint32 start;			// cycle count when command was issued
+	uint32 duration;		// its length in cycles
+	uint8 end_status;
+
+	// configuration
+	bool read_only;
+	uint32 sector_size;
+	uint64 image_size;
+	uint32 latency_cycles;	// fixed cost of a command
+	uint32 sector_cycles;	// cost of transferring one sector
+
+	bi::file_mapping file;
+	std::unique_ptr<bi::mapped_region> window;
+	uint64 window_base;
+
+	uint32 Capacity() const
+	{
+		return static_cast<uint32>(std::min<uint64>(image_size / sector_size, 0xffffffff));
+	}
+
+	// map part of the image containing 'offset'; returns pointer to it and number of bytes available
+	uint8* Map(uint64 offset, uint64& available)
+	{
+		if (!window || offset < window_base || offset >= window_base + window->get_size())
+		{
+			window.reset();
+			window_base = offset & ~(WINDOW - 1);
+			auto size= static_cast<size_t>(std::min(WINDOW, image_size - window_base));
+			window.reset(new bi::mapped_region(file, read_only ? bi::read_only : bi::read_write, window_base, size));
+		}
+
+		available = window_base + window->get_size() - offset;
+		return static_cast<uint8*>(window->get_address()) + (offset - window_base);
+	}
+
+	// move sectors between the image and guest memory; returns false if request is invalid
+	bool Transfer(Context& ctx, bool write)
+	{
+		if (COUNT == 0 || uint64(LBA) + COUNT > Capacity() || (write && read_only))
+			return false;
+
+		auto bytes= uint64(COUNT) * sector_size;
+		if (bytes > 0xffffffff)
+			return false;
+
+		// entire buffer has to be in a single memory bank
+		auto length= static_cast<uint32>(bytes);
+		auto buffer= ctx.GetMemoryAddress(ADDRESS, length, true);
+		if (buffer.type != DecodedAddress::RAM && !(write && buffer.type == DecodedAddress::FLASH))
+			return false;
+
+		auto offset= uint64(LBA) * sector_size;
+		auto address= ADDRESS;
+		while (length > 0)
+		{
+			uint64 available= 0;
+			auto disk= Map(offset, available);
+			auto size= static_cast<uint32>(std::min<uint64>(available, length));
+
+			if (write)
+				memcpy(disk, static_cast<uint8*>(buffer.address) + (address - ADDRESS), size);
+			else
+				ctx.WriteMemory(address, disk, size);
+
+			offset += size;
+			address += size;
+			length -= size;
+		}
+
+		return true;
+	}
+
+	void Execute(Context& ctx, uint8 command)
+	{
+		start = ctx.CyclesTaken();
+		duration = latency_cycles;
+		end_status = 0;
+
+		try
+		{
+			switch (command)
+			{
+			case CMD_READ:
+			case CMD_WRITE:
+				if (Transfer(ctx, command == CMD_WRITE))
+					duration += COUNT * sector_cycles;
+				else
+					end_status = ST_ERROR;
+				break;
+
+			case CMD_FLUSH:
+				if (window)
+					window->flush();
+				break;
+
+			default:
+				end_status = ST_ERROR;
+				break;
+			}
+		}
+		catch (bi::interprocess_exception&)
+		{
+			end_status = ST_ERROR;
+		}
+
+		busy = true;
+		STATUS = (STATUS & ~(ST_DONE | ST_ERROR)) | ST_BUSY;
+	}
+
+	// interrupt request follows DONE flag
+	void Signal(Context& ctx, int source)
+	{
+		char irq_on= (STATUS & ST_DONE) && (CONTROL & CTRL_IE) ? 1 : 0;
+		if (irq_on == irq)
+			return;
+
+		irq = irq_on;
+		if (irq_on)
+			ctx.InterruptAssert(source, static_cast<CpuExceptions>(IVR));
+		else
+			ctx.InterruptClear(source);
+	}
+};
+
+
+DiskImageStorage::DiskImageStorage(PParam params, PeripheralConfigData& config) : Peripheral(params.IOAreaSize(Offset::END))
+{
+	std::unique_ptr<_dev_data> data(new _dev_data());
+
+	auto image= config.get<std::string>("image", "");
+	if (image.empty())
+		throw RunTimeError("DiskImageStorage: missing disk image file name");
+
+	data->read_only = config.get<bool>("read_only", false);
+	data->sector_size = config.get<uint32>("sector_size", 512);
+	if (data->sector_size == 0 || (data->sector_size & (data->sector_size - 1)) != 0)
+		throw RunTimeError("DiskImageStorage: sector size has to be a power of 2");
+	data->latency_cycles = config.get<uint32>("latency_cycles", 1000);
+	data->sector_cycles = config.get<uint32>("sector_cycles", 100);
+
+	try
+	{
+		data->image_size = boost::filesystem::file_size(image);
+		bi::file_mapping(image.c_str(), data->read_only ? bi::read_only : bi::read_write).swap(data->file);
+	}
+	catch (std::exception&)
+	{
+		throw RunTimeError("DiskImageStorage: cannot open disk image file " + image);
+	}
+
+	this->data = data.release();
+}
+
+
+DiskImageStorage::~DiskImageStorage()
+{
+	delete data;
+}
+
+
+// called during simulator run after executing single opcode
+void DiskImageStorage::Update(Context& ctx)
+{
+	if (!data->busy || ctx.CyclesTaken() - data->start < data->duration)
+		return;
+
+	data->busy = false;
+	data->STATUS = (data->STATUS & ~ST_BUSY) | ST_DONE | data->end_status;
+	data->Signal(ctx, InterruptSource());
+}
+
+
+bool DiskImageStorage::NextEvent(const Context& ctx, EventScope scope, uint32& at_cycle) const
+{
+	if (!data->busy || (scope == EventScope::Interrupt && !(data->CONTROL & CTRL_IE)))
+		return false;
+
+	at_cycle = data->start + data->duration;
+	return true;
+}
+
+
+// resetting device
+void DiskImageStorage::Reset()
+{
+	data->LBA = 0;
+	data->ADDRESS = 0;
+	data->COUNT = 0;
+	data->CONTROL = 0;
+	data->STATUS = 0;
+	data->IVR = EX_UninitializedInterrupt;
+	data->irq = -1;
+	data->busy = false;
+}
+
+
+// read from device; access_size is 1, 2, or 4
+uint32 DiskImageStorage::Read(uint32 offset, int access_size)
+{
+	switch (offset)
+	{
+	case Offset::LBA:
+		return data->LBA;
+
+	case Offset::ADDRESS:
+		return data->ADDRESS;
+
+	case Offset::COUNT:
+		return data->COUNT;
+
+	case Offset::CONTROL:
+		return data->CONTROL;
+
+	case Offset::STATUS:
+		return data->STATUS;
+
+	case Offset::IVR:
+		return data->IVR;
+
+	case Offset::CAPACITY:
+		return data->Capacity();
+
+	case Offset::SECTOR_SIZE:
+		return data->sector_size;
+
+	default:
+		break;
+	}
+
+	return 0;
+}
+
+
+bool DiskImageStorage::ReadHasSideEffects(uint32 offset) const
+{
+	return false;
+}
+
+
+// write to device; access_size is 1, 2, or 4
+void DiskImageStorage::Write(Context& ctx, uint32 offset, int access_size, uint32 value)
+{
+	switch (offset)
+	{
+	case Offset::LBA:
+		data->LBA = value;
+		break;
+
+	case Offset::ADDRESS:
+		data->ADDRESS = value;
+		break;
+
+	case Offset::COUNT:
+		data->COUNT = value;
+		break;
+
+	case Offset::COMMAND:
+		// commands are ignored while device is busy
+		if (!data->busy)
+			data->Execute(ctx, static_cast<uint8>(value));
+		break;
+
+	case Offset::CONTROL:
+		data->CONTROL = static_cast<uint8>(value);
+		break;
+
+	case Offset::STATUS:
+		if (value & ST_DONE)
+			data->STATUS &= ~(ST_DONE | ST_ERROR);
+		break;
+
+	case Offset::IVR:
+		data->IVR = static_cast<uint8>(value);
+		break;
+
+	default:
+		break;
+	}
+
+	data->Signal(ctx, InterruptSource());
+}
@@ -0,0 +1,43 @@
+/*-----------------------------------------------------------------------------
+	ColdFire Macro Assembler and Simulator
+
+	Copyright (C) 2007-2012 Mike Kowalski
+
+	See License.txt for more details
+-----------------------------------------------------------------------------*/
+
+#pragma once
+#include "..\Peripheral.h"
+
+
+// Sector based storage backed by a host disk image file; image is mapped into memory
+// window by window, so its size is not limited by address space of the simulator
+
+class DiskImageStorage : public Peripheral
+{
+public:
+	DiskImageStorage(PParam params, PeripheralConfigData& config);
+	virtual ~DiskImageStorage();
+
+	// called during simulator run after executing single opcode
+	virtual void Update(Context& ctx);
+
+	// resetting device
+	virtual void Reset();
+
+	// read from device; access_size is 1, 2, or 4
+	virtual uint32 Read(uint32 offset, int access_size);
+
+	// write to device; access_size is 1, 2, or 4
+	virtual void Write(Context& ctx, uint32 offset, int access_size, uint32 value);
+
+	// completion of a command in progress
+	virtual bool NextEvent(const Context& ctx, EventScope scope, uint32& at_cycle) const;
+
+	// reading registers doesn't change device state
+	virtual bool ReadHasSideEffects(uint32 offset) const;
+
+private:
+	struct _dev_data;
+	_dev_data* data;
+};
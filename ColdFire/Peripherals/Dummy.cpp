@@ -42,6 +42,12 @@ uint32 Dummy::Read(uint32 offset, int access_size)
 }
 
 
+bool Dummy::ReadHasSideEffects(uint32 offset) const
+{
+	return false;
+}
+
+
 // write to device; access_size is 1, 2, or 4
 void Dummy::Write(Context& ctx, uint32 offset, int access_size, uint32 value)
 {}
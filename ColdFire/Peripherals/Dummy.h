@@ -27,4 +27,7 @@ public:
 
 	// write to device; access_size is 1, 2, or 4
 	virtual void Write(Context& ctx, uint32 offset, int access_size, uint32 value);
+
+	// reading registers doesn't change device state
+	virtual bool ReadHasSideEffects(uint32 offset) const;
 };
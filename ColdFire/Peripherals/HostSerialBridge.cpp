@@ -0,0 +1,205 @@
+/*-----------------------------------------------------------------------------
+	ColdFire Macro Assembler and Simulator
+
+	Copyright (C) 2007-2012 Mike Kowalski
+
+	See License.txt for more details
+-----------------------------------------------------------------------------*/
+
+#include "pch.h"
+#include "HostSerialBridge.h"
+#include "../SpscQueue.h"
+#include "../Exceptions.h"
+#include <boost/asio.hpp>
+
+using boost::asio::ip::tcp;
+typedef boost::system::error_code ErrorCode;
+
+
+struct HostSerialBridge::Impl
+{
+	Impl(uint16 port)
+		: acceptor_(io_, tcp::endpoint(boost::asio::ip::address_v4::loopback(), port)), socket_(io_), retry_(io_)
+	{
+		connected_ = false;
+		tx_kick_ = false;
+		writing_ = false;
+		rx_pos_ = rx_len_ = 0;
+
+		Accept();
+		thread_ = std::thread([this] { io_.run(); });
+	}
+
+	~Impl()
+	{
+		io_.stop();
+		if (thread_.joinable())
+			thread_.join();
+	}
+
+	// buffers between simulation thread and service thread
+	enum { BUFFER_SIZE= 4096 };
+	SpscQueue<uint8, BUFFER_SIZE> rx_;	// host -> guest
+	SpscQueue<uint8, BUFFER_SIZE> tx_;	// guest -> host
+	std::atomic<bool> connected_;
+	std::atomic<bool> tx_kick_;			// service thread has been asked to send pending bytes
+
+	// everything below is only touched by the service thread
+	boost::asio::io_service io_;
+	tcp::acceptor acceptor_;
+	tcp::socket socket_;
+	boost::asio::deadline_timer retry_;
+	std::thread thread_;
+	std::array<uint8, 1024> rx_buf_;
+	std::array<uint8, 1024> tx_buf_;
+	size_t rx_pos_;
+	size_t rx_len_;
+	bool writing_;
+
+	void Accept()
+	{
+		acceptor_.async_accept(socket_, [this](const ErrorCode& err)
+		{
+			if (err == boost::asio::error::operation_aborted)
+				return;
+
+			if (err)
+			{
+				Accept();
+				return;
+			}
+
+			socket_.set_option(tcp::no_delay(true));
+			connected_ = true;
+			ReadMore();
+			FlushTx();
+		});
+	}
+
+	void Disconnect()
+	{
+		if (!socket_.is_open())
+			return;
+
+		ErrorCode ignore;
+		socket_.close(ignore);
+		connected_ = false;
+		writing_ = false;
+		Accept();
+	}
+
+	void ReadMore()
+	{
+		if (!socket_.is_open())
+			return;
+
+		socket_.async_read_some(boost::asio::buffer(rx_buf_), [this](const ErrorCode& err, size_t len)
+		{
+			if (err)
+			{
+				if (err != boost::asio::error::operation_aborted)
+					Disconnect();
+				return;
+			}
+
+			rx_pos_ = 0;
+			rx_len_ = len;
+			QueueRx();
+		});
+	}
+
+	// move received bytes into the receive buffer; if guest isn't reading fast enough, wait for room
+	void QueueRx()
+	{
+		while (rx_pos_ < rx_len_ && rx_.Push(rx_buf_[rx_pos_]))
+			++rx_pos_;
+
+		if (rx_pos_ < rx_len_)
+		{
+			retry_.expires_from_now(boost::posix_time::milliseconds(1));
+			retry_.async_wait([this](const ErrorCode& err)
+			{
+				if (!err)
+					QueueRx();
+			});
+		}
+		else
+			ReadMore();
+	}
+
+	void FlushTx()
+	{
+		if (writing_ || !socket_.is_open() || !connected_)
+			return;
+
+		size_t len= 0;
+		uint8 byte= 0;
+		while (len < tx_buf_.size() && tx_.Pop(byte))
+			tx_buf_[len++] = byte;
+
+		if (len == 0)
+			return;
+
+		writing_ = true;
+		boost::asio::async_write(socket_, boost::asio::buffer(tx_buf_, len), [this](const ErrorCode& err, size_t)
+		{
+			writing_ = false;
+			if (err)
+			{
+				if (err != boost::asio::error::operation_aborted)
+					Disconnect();
+			}
+			else
+				FlushTx();
+		});
+	}
+};
+
+
+HostSerialBridge::HostSerialBridge(uint16 port)
+{
+	try
+	{
+		impl_.reset(new Impl(port));
+	}
+	catch (boost::system::system_error& ex)
+	{
+		throw RunTimeError("Cannot open serial bridge port " + std::to_string(port) + ": " + ex.what());
+	}
+}
+
+
+HostSerialBridge::~HostSerialBridge()
+{}
+
+
+bool HostSerialBridge::Receive(uint8& byte)
+{
+	return impl_->rx_.Pop(byte);
+}
+
+
+bool HostSerialBridge::Send(uint8 byte)
+{
+	if (!impl_->tx_.Push(byte))
+		return false;
+
+	// wake up service thread once per burst of bytes
+	if (!impl_->tx_kick_.exchange(true))
+	{
+		auto impl= impl_.get();
+		impl_->io_.post([impl]
+		{
+			impl->tx_kick_ = false;
+			impl->FlushTx();
+		});
+	}
+
+	return true;
+}
+
+
+bool HostSerialBridge::Connected() const
+{
+	return impl_->connected_;
+}
@@ -0,0 +1,37 @@
+/*-----------------------------------------------------------------------------
+	ColdFire Macro Assembler and Simulator
+
+	Copyright (C) 2007-2012 Mike Kowalski
+
+	See License.txt for more details
+-----------------------------------------------------------------------------*/
+
+#pragma once
+#include "..\BasicTypes.h"
+
+// Connects a simulated serial port to a local TCP port, so host tools can talk to the firmware.
+// One client at a time can be connected. All socket I/O is done by a private service thread;
+// simulation thread only exchanges bytes with it through lock-free buffers and never blocks.
+
+class HostSerialBridge
+{
+public:
+	explicit HostSerialBridge(uint16 port);
+	~HostSerialBridge();
+
+	// simulation thread: next byte from the host, false if there's none
+	bool Receive(uint8& byte);
+
+	// simulation thread: queue byte for the host; false if transmit buffer is full and byte is lost
+	bool Send(uint8 byte);
+
+	// true if host client is connected
+	bool Connected() const;
+
+private:
+	HostSerialBridge(const HostSerialBridge&);
+	HostSerialBridge& operator = (const HostSerialBridge&);
+
+	struct Impl;
+	std::unique_ptr<Impl> impl_;
+};
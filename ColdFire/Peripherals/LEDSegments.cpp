@@ -55,3 +55,11 @@ cf::uint32 LEDSegments::GetScreenBaseAddress() const
 
 DisplayDevice::NotifyType LEDSegments::ChangeNotification() const
 { return DisplayDevice::NotifyType::EventBased; } // this display sends notifications when its memory changes
+
+bool LEDSegments::TakeDirtyRows(cf::uint32& first, cf::uint32& last)
+{
+	// changes are not tracked
+	first = 0;
+	last = height_ - 1;
+	return true;
+}
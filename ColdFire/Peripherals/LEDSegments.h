@@ -21,6 +21,7 @@ public:
 	virtual cf::uint32 GetBitsPerPixel() const;
 	virtual cf::uint32 GetScreenBaseAddress() const;
 	virtual NotifyType ChangeNotification() const;
+	virtual bool TakeDirtyRows(cf::uint32& first, cf::uint32& last);
 
 private:
 	cf::uint32 width_;
@@ -0,0 +1,376 @@
+/*-----------------------------------------------------------------------------
+	ColdFire Macro Assembler and Simulator
+
+	Copyright (C) 2007-2012 Mike Kowalski
+
+	See License.txt for more details
+-----------------------------------------------------------------------------*/
+
+// Single DMA channel as found in 5206e/5307; memory is moved when transfer starts (as a bulk copy
+// if possible), while registers and status follow the timing of real transfer
+
+#include "pch.h"
+#include "SimpleDMA.h"
+#include "../Context.h"
+#include "../PeripheralRepository.h"
+
+// register DMA channel
+static auto reg_dma= GetPeripherals().Register("dma", "5206", &CreateDevice2<SimpleDMA>);
+
+
+enum Offset : uint32	// offsets from channel base
+{
+	SAR= 0x00,		// source address
+	DAR= 0x04,		// destination address
+	DCR= 0x08,		// control (word)
+	BCR= 0x0c,		// byte count (word; long access gives 24 bits)
+	DSR= 0x10,		// status (byte)
+	DIVR= 0x14,		// interrupt vector (byte)
+	END= 0x15
+};
+
+/* DCR (DMA control register) :
+ *  15  14  13  12  11  10   9   8   7   6   5   4   3   2   1   0
+ * +---+---+---+---+-----------+-------+---+-------+---+-------+---+
+ * |INT|EEX|CS |AA |  BWC 2-0  |  --   |SIN| SSIZE |DIN| DSIZE |STR|
+ * +---+---+---+---+-----------+-------+---+-------+---+-------+---+
+ * */
+enum : uint16
+{
+	DCR_INT= 0x8000,
+	DCR_SINC= 0x0040,
+	DCR_SSIZE_POS= 4,
+	DCR_DINC= 0x0008,
+	DCR_DSIZE_POS= 1,
+	DCR_SIZE_MASK= 0x3,
+	DCR_START= 0x0001
+};
+
+// DSR (DMA status register)
+enum : uint8
+{
+	DSR_CE= 0x40,	// configuration error
+	DSR_BES= 0x20,	// bus error on source
+	DSR_BED= 0x10,	// bus error on destination
+	DSR_BSY= 0x02,
+	DSR_DONE= 0x01
+};
+
+
+namespace {
+	// transfer size encoding: long, byte, word, line
+	uint32 SizeInBytes(uint16 size_code)
+	{
+		static const uint32 sizes[]= { 4, 1, 2, 16 };
+		return sizes[size_code & DCR_SIZE_MASK];
+	}
+
+	// single bus access; line is moved as 4 long words
+	void Load(Context& ctx, uint32 address, uint32 size, uint8* dest)
+	{
+		auto size_code= size == 1 ? S_BYTE : size == 2 ? S_WORD : S_LONG;
+		auto step= size == 16 ? 4u : size;
+
+		for (uint32 i= 0; i < size; i += step)
+		{
+			auto value= ctx.ReadFromAddress(ctx.GetMemoryAddress(address + i, size_code), size_code);
+			for (uint32 n= 0; n < step; ++n)
+				dest[i + n] = static_cast<uint8>(value >> 8 * (step - 1 - n));
+		}
+	}
+
+	void Store(Context& ctx, uint32 address, uint32 size, const uint8* src)
+	{
+		auto size_code= size == 1 ? S_BYTE : size == 2 ? S_WORD : S_LONG;
+		auto step= size == 16 ? 4u : size;
+
+		for (uint32 i= 0; i < size; i += step)
+		{
+			uint32 value= 0;
+			for (uint32 n= 0; n < step; ++n)
+				value = value << 8 | src[i + n];
+			ctx.WriteToAddress(ctx.GetMemoryAddress(address + i, size_code), value, size_code);
+		}
+	}
+}
+
+
+struct SimpleDMA::_dma_data
+{
+	_dma_data()
+	{
+		memset(this, 0, sizeof(*this));
+	}
+
+	uint32 SAR;
+	uint32 DAR;
+	uint16 DCR;
+	uint32 BCR;
+	uint8 DSR;
+	uint8 DIVR;
+	char irq;				// interrupt request state as reported to ICM; -1 if not known
+	uint32 bus_cycles;		// cycles per single bus access
+
+	// transfer in progress
+	bool busy;
+	uint32 start;			// cycle count when transfer started
+	uint32 chunk;			// bytes per read/write sequence (bigger of source and destination size)
+	uint32 chunk_cycles;
+	uint32 moved;			// chunks transferred
+	uint8 end_status;		// bus error reported when transfer ends
+	uint32 src, dst, count;	// registers at the start of transfer
+	uint32 now;				// cycle count seen last time
+
+	uint32 Duration() const
+	{
+		return moved * chunk_cycles;
+	}
+
+	// chunks done by 'cycles' as far as registers are concerned
+	uint32 Progress(uint32 cycles) const
+	{
+		return std::min(moved, (cycles - start) / chunk_cycles);
+	}
+
+	void SyncRegisters(uint32 done)
+	{
+		SAR = src + (DCR & DCR_SINC ? done * chunk : 0);
+		DAR = dst + (DCR & DCR_DINC ? done * chunk : 0);
+		BCR = count - done * chunk;
+	}
+
+	// interrupt request follows DONE flag
+	void Signal(Context& ctx, int source)
+	{
+		char irq_on= (DSR & DSR_DONE) && (DCR & DCR_INT) ? 1 : 0;
+		if (irq_on == irq)
+			return;
+
+		irq = irq_on;
+		if (irq_on)
+			ctx.InterruptAssert(source, static_cast<CpuExceptions>(DIVR));
+		else
+			ctx.InterruptClear(source);
+	}
+
+	void Start(Context& ctx)
+	{
+		auto ssize= SizeInBytes(DCR >> DCR_SSIZE_POS);
+		auto dsize= SizeInBytes(DCR >> DCR_DSIZE_POS);
+		chunk = std::max(ssize, dsize);
+
+		if (BCR == 0 || BCR % chunk || SAR % ssize || DAR % dsize)
+		{
+			DSR |= DSR_CE | DSR_DONE;
+			return;
+		}
+
+		auto chunks= BCR / chunk;
+		chunk_cycles = (chunk / ssize + chunk / dsize) * bus_cycles;
+		start = ctx.CyclesTaken();
+		src = SAR;
+		dst = DAR;
+		count = BCR;
+		end_status = 0;
+		busy = true;
+		DSR |= DSR_BSY;
+
+		// memory to memory in RAM: one host copy
+		if ((DCR & DCR_SINC) && (DCR & DCR_DINC) && ctx.CopyMemory(DAR, SAR, BCR))
+		{
+			moved = chunks;
+			return;
+		}
+
+		// anything else (peripherals, fixed addresses) goes through regular bus accesses
+		uint8 buf[16];
+		uint32 s= SAR, d= DAR;
+		for (moved= 0; moved < chunks; ++moved)
+		{
+			try
+			{
+				end_status = DSR_BES;
+				for (uint32 i= 0; i < chunk; i += ssize, s += DCR & DCR_SINC ? ssize : 0)
+					Load(ctx, s, ssize, buf + i);
+
+				end_status = DSR_BED;
+				for (uint32 i= 0; i < chunk; i += dsize, d += DCR & DCR_DINC ? dsize : 0)
+					Store(ctx, d, dsize, buf + i);
+
+				end_status = 0;
+			}
+			catch (MemoryAccessException&)
+			{
+				break;
+			}
+		}
+	}
+
+	void Finish()
+	{
+		SyncRegisters(moved);
+		busy = false;
+		DSR = (DSR & ~DSR_BSY) | DSR_DONE | end_status;
+	}
+};
+
+
+SimpleDMA::SimpleDMA(PParam params, PeripheralConfigData& config) : Peripheral(params.IOAreaSize(Offset::END))
+{
+	dma = new _dma_data();
+
+	dma->bus_cycles = config.get<uint32>("bus_cycles", 1);
+	if (dma->bus_cycles == 0)
+		dma->bus_cycles = 1;
+}
+
+
+SimpleDMA::~SimpleDMA()
+{
+	delete dma;
+}
+
+
+// called during simulator run after executing single opcode
+void SimpleDMA::Update(Context& ctx)
+{
+	if (!dma->busy)
+		return;
+
+	dma->now = ctx.CyclesTaken();
+
+	if (dma->now - dma->start < dma->Duration())
+		return;
+
+	dma->Finish();
+	dma->Signal(ctx, InterruptSource());
+}
+
+
+// registers change with every chunk transferred, but only the end of transfer can interrupt
+bool SimpleDMA::NextEvent(const Context& ctx, EventScope scope, uint32& at_cycle) const
+{
+	if (!dma->busy)
+		return false;
+
+	if (scope == EventScope::Any)
+		at_cycle = dma->start + std::min(dma->moved, dma->Progress(ctx.CyclesTaken()) + 1) * dma->chunk_cycles;
+	else if (dma->DCR & DCR_INT)
+		at_cycle = dma->start + dma->Duration();
+	else
+		return false;
+
+	return true;
+}
+
+
+// resetting device
+void SimpleDMA::Reset()
+{
+	dma->SAR = 0;
+	dma->DAR = 0;
+	dma->DCR = 0;
+	dma->BCR = 0;
+	dma->DSR = 0;
+	dma->DIVR = EX_UninitializedInterrupt;
+	dma->irq = -1;
+	dma->busy = false;
+	dma->moved = 0;
+}
+
+
+// read from device; access_size is 1, 2, or 4
+uint32 SimpleDMA::Read(uint32 offset, int access_size)
+{
+	if (dma->busy)
+		dma->SyncRegisters(dma->Progress(dma->now));
+
+	switch (offset)
+	{
+	case Offset::SAR:
+		return dma->SAR;
+
+	case Offset::DAR:
+		return dma->DAR;
+
+	case Offset::DCR:
+		return dma->DCR;
+
+	case Offset::BCR:
+		return access_size == 4 ? dma->BCR & 0xffffff : dma->BCR & 0xffff;
+
+	case Offset::DSR:
+		return dma->DSR;
+
+	case Offset::DIVR:
+		return dma->DIVR;
+
+	default:
+		break;
+	}
+
+	return 0;
+}
+
+
+// all DMA registers can be polled freely
+bool SimpleDMA::ReadHasSideEffects(uint32 offset) const
+{
+	return false;
+}
+
+
+// write to device; access_size is 1, 2, or 4
+void SimpleDMA::Write(Context& ctx, uint32 offset, int access_size, uint32 value)
+{
+	switch (offset)
+	{
+	case Offset::SAR:
+		dma->SAR = value;
+		break;
+
+	case Offset::DAR:
+		dma->DAR = value;
+		break;
+
+	case Offset::DCR:
+		if (value & DCR_START)
+		{
+			// START is write-only; restarting busy channel is a configuration error
+			dma->DCR = static_cast<uint16>(value & ~DCR_START);
+			if (dma->busy)
+				dma->DSR |= DSR_CE;
+			else
+				dma->Start(ctx);
+		}
+		else
+			dma->DCR = static_cast<uint16>(value);
+		break;
+
+	case Offset::BCR:
+		dma->BCR = access_size == 4 ? value & 0xffffff : value & 0xffff;
+		break;
+
+	case Offset::DSR:
+		// writing DONE clears status; it also aborts transfer in progress
+		if (value & DSR_DONE)
+		{
+			if (dma->busy)
+			{
+				dma->SyncRegisters(dma->Progress(ctx.CyclesTaken()));
+				dma->busy = false;
+			}
+			dma->DSR = 0;
+		}
+		break;
+
+	case Offset::DIVR:
+		dma->DIVR = static_cast<uint8>(value);
+		break;
+
+	default:
+		break;
+	}
+
+	dma->Signal(ctx, InterruptSource());
+}
@@ -13,6 +13,7 @@
 #include "../Context.h"
 #include "../PeripheralRepository.h"
 #include <array>
+#include <intrin.h>
 #include "../Exceptions.h"
 
 // register ICM
@@ -34,6 +35,8 @@ enum Offset : uint16	// offsets from MBAR
 	ICR11,
 	ICR12,
 	ICR13,
+	ICR14,		// 5206e DMA channels
+	ICR15,
 	IMR= 0x22,
 	IPR= 0x26,
 	END= 0x2a
@@ -44,10 +47,29 @@ enum : uint8
 	AUTO_VECTOR= 0x80,
 	INTERRUPT_LEVEL_POS= 2,
 	INTERRUPT_MASK= 0x7,
-	PRIORITY_MASK= 0x3
+	PRIORITY_MASK= 0x3,
+	SLOT_MASK= 0x1f		// interrupt level and priority combined: level * 4 + priority
 };
 
 
+namespace {
+	// index of the most/least significant bit set; 'bits' cannot be zero
+	int HighestBit(uint32 bits)
+	{
+		unsigned long index= 0;
+		_BitScanReverse(&index, bits);
+		return static_cast<int>(index);
+	}
+
+	int LowestBit(uint32 bits)
+	{
+		unsigned long index= 0;
+		_BitScanForward(&index, bits);
+		return static_cast<int>(index);
+	}
+}
+
+
 struct SimpleInterruptController::icm
 {
 	icm() : interrupt_pending(0), interrupt_mask(0)
@@ -63,6 +85,8 @@ struct SimpleInterruptController::icm
 		icrs[9] = 0x80;
 		icrs[10] = 0x80;
 		icrs[11] = 0x80;
+
+		assign_slots();
 	}
 
 	//uint16 pending_exceptions_mask;
@@ -73,6 +97,50 @@ struct SimpleInterruptController::icm
 	std::array<int, 8> interrupt_counters;
 	std::array<uint8, MAX> icrs;		// interrupt control registers
 
+	// arbitration: sources grouped by their level/priority slot; slots with pending, unmasked
+	// requests are marked in active_slots, so the winner is the highest active slot
+	const static size_t SLOTS= 32;
+	std::array<uint32, SLOTS> slot_sources;	// sources configured at given level and priority
+	uint32 active_slots;
+
+	// regroup sources after ICR change
+	void assign_slots()
+	{
+		slot_sources.fill(0);
+		for (size_t i= 0; i < MAX; ++i)
+			slot_sources[icrs[i] & SLOT_MASK] |= uint32(1) << i;
+
+		update_slots();
+	}
+
+	// refresh active slots after change of pending interrupts or mask
+	void update_slots()
+	{
+		active_slots = 0;
+		auto active= interrupt_pending & ~interrupt_mask;
+		if (active == 0)
+			return;
+
+		for (size_t slot= 0; slot < SLOTS; ++slot)
+			if (slot_sources[slot] & active)
+				active_slots |= uint32(1) << slot;
+	}
+
+	void update_slot(uint16 interrupt_source)
+	{
+		auto slot= icrs[interrupt_source] & SLOT_MASK;
+		if (slot_sources[slot] & interrupt_pending & ~interrupt_mask)
+			active_slots |= uint32(1) << slot;
+		else
+			active_slots &= ~(uint32(1) << slot);
+	}
+
+	// highest interrupt level requested (and not masked); 0 if none
+	int top_level() const
+	{
+		return active_slots ? HighestBit(active_slots) >> INTERRUPT_LEVEL_POS : 0;
+	}
+
 	int get_interrupt_level(uint16 interrupt_source) const
 	{
 		if (interrupt_source < icrs.size())
@@ -105,67 +173,36 @@ SimpleInterruptController::~SimpleInterruptController()
 // called during simulator run after executing single opcode
 void SimpleInterruptController::Update(Context& ctx)
 {
-	//if (!icm_->pending_exceptions_mask)
-//		return;
-
-	if (!icm_->interrupt_pending)
+	// level 0 requests never get through
+	auto level= icm_->top_level();
+	if (level == 0)
 		return;
 
-	if ((icm_->interrupt_pending & ~icm_->interrupt_mask) == 0)
-		return;
-
-	TRACE("Interrupt scheduled\n");
- 
 	auto il_mask= ctx.Cpu().InterruptLevel();
 	if (il_mask == 7)
 		return;	// how to handle priority 7 non-maskable interrupts?
 
-	// find interrupt source with highest interrupt level and priority
-
-	CpuExceptions vector= EX_SpuriousInterrupt;
-	int level= 0;
-	int priority= 0;
-	int source= -1;
-
-	for (int i= 0; i < icm::MAX; ++i)
-	{
-		uint64 mask= 1;
-		mask <<= i;
-		if ((icm_->interrupt_pending & mask) != 0 && (icm_->interrupt_mask & mask) == 0)
-		{
-			auto il= (icm_->icrs[i] >> INTERRUPT_LEVEL_POS) & INTERRUPT_MASK;
-			auto pr= icm_->icrs[i] & PRIORITY_MASK;
-
-			if (il > level || (il == level && pr > priority))
-			{
-				level = il;
-				priority = pr;
-				source = i;
-
-				if (icm_->icrs[i] & AUTO_VECTOR)
-					vector = static_cast<CpuExceptions>(EX_InterruptLevel_1 - 1 + il);
-				else
-					vector = icm_->vectors[i];
-			}
-		}
-	}
-
 	// enter interrupt if it's not masked
 
 	if (level > il_mask)
 	{
+		// interrupt source with highest interrupt level and priority; on a tie lowest source number wins
+		auto slot= HighestBit(icm_->active_slots);
+		auto source= LowestBit(icm_->slot_sources[slot] & icm_->interrupt_pending & ~icm_->interrupt_mask);
+
+		CpuExceptions vector= EX_SpuriousInterrupt;
+		if (icm_->icrs[source] & AUTO_VECTOR)
+			vector = static_cast<CpuExceptions>(EX_InterruptLevel_1 - 1 + level);
+		else
+			vector = icm_->vectors[source];
+
 		TRACE("Entering interrupt, vector %d\n", int(vector));
 
-		ctx.EnterException(vector, ctx.Cpu().pc);
-		ctx.Cpu().SetInterruptLevel(level);
+		ctx.EnterInterrupt(source, vector, level);
 
-		if (source >= 0)
-		{
-			// todo: not sure who's clearing this bit
-			uint64 mask= 1;
-			mask <<= source;
-			icm_->interrupt_pending &= ~mask;
-		}
+		// todo: not sure who's clearing this bit
+		icm_->interrupt_pending &= ~(uint32(1) << source);
+		icm_->update_slot(source);
 	}
 
 	/*
@@ -186,11 +223,27 @@ void SimpleInterruptController::Update(Context& ctx)
 }
 
 
+// pending interrupt that CPU is going to accept is an immediate event;
+// masked interrupts have to wait for a change of mask, so they are not reported
+bool SimpleInterruptController::NextEvent(const Context& ctx, EventScope scope, uint32& at_cycle) const
+{
+	auto level= icm_->top_level();
+	auto il_mask= ctx.Cpu().InterruptLevel();
+
+	if (level == 0 || il_mask == 7 || level <= il_mask)
+		return false;
+
+	at_cycle = ctx.CyclesTaken();
+	return true;
+}
+
+
 // resetting device
 void SimpleInterruptController::Reset()
 {
 	icm_->interrupt_mask = ~0;
 	icm_->interrupt_pending = 0;
+	icm_->update_slots();
 }
 
 
@@ -212,7 +265,7 @@ uint32 SimpleInterruptController::Read(uint32 offset, int access_size)
 		return icm_->interrupt_pending;
 
 	default:
-		if (offset >= Offset::ICR1 && offset <= Offset::ICR13)
+		if (offset >= Offset::ICR1 && offset <= Offset::ICR15)
 			return icm_->icrs[1 + offset];
 
 		// not a covered area...
@@ -224,6 +277,12 @@ uint32 SimpleInterruptController::Read(uint32 offset, int access_size)
 }
 
 
+bool SimpleInterruptController::ReadHasSideEffects(uint32 offset) const
+{
+	return false;
+}
+
+
 // write to device; access_size is 1, 2, or 4
 void SimpleInterruptController::Write(Context& ctx, uint32 offset, int access_size, uint32 value)
 {
@@ -237,14 +296,18 @@ void SimpleInterruptController::Write(Context& ctx, uint32 offset, int access_si
 	{
 	case Offset::IMR:
 		icm_->interrupt_mask = value;
+		icm_->update_slots();
 		break;
 
 	case Offset::IPR:
 		break;	// read-only
 
 	default:
-		if (offset >= Offset::ICR1 && offset <= Offset::ICR13)
+		if (offset >= Offset::ICR1 && offset <= Offset::ICR15)
+		{
 			icm_->icrs[1 + offset] = static_cast<uint8>(value);
+			icm_->assign_slots();
+		}
 		else
 		{
 			// not a covered area...
@@ -255,6 +318,12 @@ void SimpleInterruptController::Write(Context& ctx, uint32 offset, int access_si
 }
 
 
+int SimpleInterruptController::InterruptLevel(uint16 interrupt_source) const
+{
+	return interrupt_source < icm::MAX ? icm_->get_interrupt_level(interrupt_source) : 0;
+}
+
+
 void SimpleInterruptController::InterruptAssert(uint16 interrupt_source, CpuExceptions vector)
 {
 	if (static_cast<size_t>(interrupt_source) >= icm_->vectors.size())
@@ -281,6 +350,8 @@ void SimpleInterruptController::InterruptAssert(uint16 interrupt_source, CpuExce
 	if (icm_->interrupt_mask & mask)
 		return;	// interrupt is disabled by a mask
 
+	icm_->update_slot(interrupt_source);
+
 	// get level by reading control register
 	auto level= icm_->get_interrupt_level(interrupt_source);
 
@@ -314,6 +385,7 @@ void SimpleInterruptController::InterruptClear(uint16 interrupt_source)
 	if (icm_->interrupt_pending & mask)
 	{
 		icm_->interrupt_pending &= ~mask;
+		icm_->update_slot(interrupt_source);
 
 		icm_->vectors[interrupt_source] = EX_SpuriousInterrupt;
 
@@ -29,10 +29,17 @@ public:
 	// write to device; access_size is 1, 2, or 4
 	virtual void Write(Context& ctx, uint32 offset, int access_size, uint32 value);
 
+	// next point in time when device changes its state
+	virtual bool NextEvent(const Context& ctx, EventScope scope, uint32& at_cycle) const;
+
+	// reading registers doesn't change device state
+	virtual bool ReadHasSideEffects(uint32 offset) const;
+
 	// interrupt controller methods
 
 	virtual void InterruptAssert(uint16 interrupt_source, CpuExceptions vector);
 	virtual void InterruptClear(uint16 interrupt_source);
+	virtual int InterruptLevel(uint16 interrupt_source) const;
 
 private:
 	struct icm;
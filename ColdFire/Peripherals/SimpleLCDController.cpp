@@ -8,7 +8,8 @@
 
 #include "pch.h"
 #include <assert.h>
-//#include <mutex>
+#include <atomic>
+#include <algorithm>
 #include "SimpleLCDController.h"
 #include "../Context.h"
 #include "../PeripheralRepository.h"
@@ -26,12 +27,55 @@ struct SimpleLCDController::_dev_data
 		width_ = width;
 		height_ = height;
 		screen_base_addr_ = 0;
+		frame_cycles_ = 0;
+		last_refresh_ = 0;
+		pending_ = false;
+		watch_changed_ = true;
+		for (auto& w : dirty_rows_)
+			w = 0;
 	}
 
 	bool enabled;
 	cf::uint32 width_;
 	cf::uint32 height_;
 	cf::uint32 screen_base_addr_;
+
+	// change tracking; rows are marked by the simulation thread and taken by the client
+	enum { MAX_ROWS= 1024 };
+	std::atomic<cf::uint32> dirty_rows_[MAX_ROWS / 32];
+	cf::uint32 frame_cycles_;	// min interval between refresh notifications
+	cf::uint32 last_refresh_;	// cycle count of last notification
+	bool pending_;				// rows changed since last notification
+	bool watch_changed_;		// screen memory moved or resized
+
+	cf::uint32 ScreenBytes() const
+	{
+		return width_ * height_ / 8;	// 1 bpp
+	}
+
+	void MarkRows(cf::uint32 first, cf::uint32 last)
+	{
+		if (height_ == 0)
+			return;
+		last = std::min(last, height_ - 1);
+		for (auto row= first; row <= last; ++row)
+		{
+			auto& word= dirty_rows_[row / 32];
+			auto bit= 1u << (row % 32);
+			if ((word.load(std::memory_order_relaxed) & bit) == 0)
+				word.fetch_or(bit, std::memory_order_relaxed);
+		}
+		pending_ = true;
+	}
+
+	// guest wrote 'size' bytes to screen memory at 'address'
+	void Written(cf::uint32 address, int size)
+	{
+		if (width_ == 0)
+			return;
+		auto bit= (address - screen_base_addr_) * 8;
+		MarkRows(bit / width_, (bit + size * 8 - 1) / width_);
+	}
 };
 
 
@@ -48,6 +92,7 @@ SimpleLCDController::SimpleLCDController(PParam params, PeripheralConfigData& co
 	data = new _dev_data(width, height);
 
 	data->screen_base_addr_ = config.get<HexNumber<unsigned int>>("screen_base_address", 0) & ~cf::uint32(3);
+	data->frame_cycles_ = config.get<cf::uint32>("frame_cycles", 100000);
 }
 
 
@@ -60,14 +105,35 @@ SimpleLCDController::~SimpleLCDController()
 // called during simulator run after executing single opcode
 void SimpleLCDController::Update(Context& ctx)
 {
-	// no-op
+	if (data->watch_changed_)
+	{
+		// track CPU writes to screen memory
+		auto dev= data;
+		ctx.SetWriteWatch(this, data->screen_base_addr_, data->ScreenBytes(), [dev](cf::uint32 address, int size)
+		{
+			dev->Written(address, size);
+		});
+		data->watch_changed_ = false;
+	}
+
+	// single notification per frame, no matter how many writes there were
+	if (data->pending_)
+	{
+		auto now= ctx.CyclesTaken();
+		if (now - data->last_refresh_ >= data->frame_cycles_)
+		{
+			data->pending_ = false;
+			data->last_refresh_ = now;
+			RequestRefresh();
+		}
+	}
 }
 
 // resetting device
 void SimpleLCDController::Reset()
 {
-	// clear display?
-	//
+	// screen memory may have been loaded without CPU writing to it
+	data->MarkRows(0, data->height_ - 1);
 }
 
 
@@ -103,6 +169,12 @@ uint32 SimpleLCDController::Read(uint32 offset, int access_size)
 }
 
 
+bool SimpleLCDController::ReadHasSideEffects(uint32 offset) const
+{
+	return false;
+}
+
+
 // write to block device; access_size is 1, 2, or 4; only 4 is legal
 void SimpleLCDController::Write(Context& ctx, uint32 offset, int access_size, uint32 value)
 {
@@ -132,10 +204,14 @@ void SimpleLCDController::Write(Context& ctx, uint32 offset, int access_size, ui
 	case ScreenSize:
 		data->width_ = (value >> 16) & 0x3fc;
 		data->height_ = value & 0x3ff;
+		data->watch_changed_ = true;
+		data->MarkRows(0, data->height_ - 1);
 		break;
 
 	case ScreenBaseAddr:
 		data->screen_base_addr_ = value & ~3;
+		data->watch_changed_ = true;
+		data->MarkRows(0, data->height_ - 1);
 		break;
 
 	}
@@ -148,4 +224,29 @@ cf::uint32 SimpleLCDController::GetHeight() const				{ return data->height_; }
 cf::uint32 SimpleLCDController::GetBitsPerPixel() const			{ return 1; }
 cf::uint32 SimpleLCDController::GetScreenBaseAddress() const	{ return data->screen_base_addr_; }
 DisplayDevice::NotifyType SimpleLCDController::ChangeNotification() const
-{ return DisplayDevice::NotifyType::Polling; } // this display needs polling, there is no notification sent when screen memory changes
+{ return DisplayDevice::NotifyType::EventBased; } // writes to screen memory are tracked, and refresh is requested once per frame
+
+
+bool SimpleLCDController::TakeDirtyRows(cf::uint32& first, cf::uint32& last)
+{
+	bool dirty= false;
+
+	for (cf::uint32 i= 0; i < _dev_data::MAX_ROWS / 32; ++i)
+	{
+		auto bits= data->dirty_rows_[i].exchange(0, std::memory_order_relaxed);
+		if (bits == 0)
+			continue;
+
+		for (cf::uint32 b= 0; b < 32; ++b)
+			if (bits & (1u << b))
+			{
+				auto row= i * 32 + b;
+				if (!dirty)
+					first = row;
+				last = row;
+				dirty = true;
+			}
+	}
+
+	return dirty;
+}
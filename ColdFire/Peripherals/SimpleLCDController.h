@@ -28,12 +28,16 @@ public:
 	// write to block device; access_size is 1, 2, or 4; only 4 is legal
 	virtual void Write(Context& ctx, uint32 offset, int access_size, uint32 value);
 
+	// reading registers doesn't change device state
+	virtual bool ReadHasSideEffects(uint32 offset) const;
+
 	// display device parameters
 	virtual cf::uint32 GetWidth() const;
 	virtual cf::uint32 GetHeight() const;
 	virtual cf::uint32 GetBitsPerPixel() const;
 	virtual cf::uint32 GetScreenBaseAddress() const;
 	virtual NotifyType ChangeNotification() const;
+	virtual bool TakeDirtyRows(cf::uint32& first, cf::uint32& last);
 
 private:
 	struct _dev_data;
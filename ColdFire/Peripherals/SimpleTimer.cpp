@@ -67,8 +67,75 @@ struct SimpleTimer::_timer_data
 	uint16 TCN;
 	struct _TER TER;
 	char enable;
+	char irq;				// interrupt request state as reported to ICM; -1 if not known
 	uint32 cycles_per_tick;
-	uint32 next_tick;
+	uint32 next_tick;		// cycle count of the next tick not yet applied to TCN/TER
+	uint32 next_change;		// cycle count at which TER.REF changes next (reference match or its end)
+	uint32 now;				// cycle count seen last time
+
+	// ticks left till the one when TCN == TRR
+	uint32 TicksToMatch() const
+	{
+		return ((TRR - TCN) & 0xffff) + 1;
+	}
+
+	/* Apply 'ticks' timer ticks at once. From the docs, the reference isn't
+	 * matched until the TCN==TRR, AND the TCN is ready to increment again;
+	 * on match TCN restarts if FRR is set, and REF is only on for a tick */
+	void Advance(uint32 ticks)
+	{
+		auto to_match= TicksToMatch();
+		if (ticks < to_match)
+		{
+			TCN = static_cast<uint16>(TCN + ticks);
+			TER.REF = 0;
+			return;
+		}
+
+		ticks -= to_match;
+		TCN = TMR.FRR ? 1 : static_cast<uint16>(TRR + 1);
+		// from now on every period ends with a match and leaves TCN where it is
+		ticks %= TicksToMatch();
+		TCN = static_cast<uint16>(TCN + ticks);
+		TER.REF = ticks == 0;
+	}
+
+	// catch up with all the ticks elapsed till 'cycles'
+	void Sync(uint32 cycles)
+	{
+		now = cycles;
+
+		if (!enable || static_cast<int32>(cycles - next_tick) < 0)
+			return;
+
+		auto ticks= (cycles - next_tick) / cycles_per_tick + 1;
+		Advance(ticks);
+		next_tick += ticks * cycles_per_tick;
+	}
+
+	// first tick due after 'cycles'
+	uint32 TickAfter(uint32 cycles) const
+	{
+		if (static_cast<int32>(cycles - next_tick) < 0)
+			return next_tick;
+		return next_tick + ((cycles - next_tick) / cycles_per_tick + 1) * cycles_per_tick;
+	}
+
+	// recalc next point of interest and bring interrupt request in line with TER
+	void Refresh(Context& ctx, int source)
+	{
+		next_change = TER.REF ? next_tick : next_tick + (TicksToMatch() - 1) * cycles_per_tick;
+
+		/* If the timer is at its reference, and ORI is set, then interrupt; request is asserted
+		 * again as long as it holds, as ICM drops pending request when CPU takes the interrupt */
+		char irq_on= TER.REF && TMR.ORI ? 1 : 0;
+		if (irq_on)
+			ctx.InterruptAssert(source, EX_SpuriousInterrupt);
+		else if (irq != 0)
+			ctx.InterruptClear(source);
+
+		irq = irq_on;
+	}
 };
 
 
@@ -90,68 +157,33 @@ void SimpleTimer::Update(Context& ctx)
 	if (!timer->enable)
 		return;
 
-	bool check_interrupts= false;
-/*0	if(board_data.use_timer_hack) {		
-		/ * Hack to make things work right, ignore the prescalar and the
-		 * CLK setting and the elapsed cycles, just increment 
-		 * the TRR every update * /
-	} else*/ {
-		/* Proper timing for the timer */
-		/* If we're not ready to tick, we should at least
-		 *  check interrupts, because we may need to withdraw
-		 *  an interrupt */
-		if (ctx.CyclesTaken() < timer->next_tick) 
-			check_interrupts = true;
-		else
-			timer->next_tick += timer->cycles_per_tick;
-	}
+	timer->now = ctx.CyclesTaken();
 
-	if (!check_interrupts)
-	{
-		/* From the docs, the reference isn't matched until the TCN==TRR, 
-		 * AND the TCN is ready to increment again, so we'll hold off
-		 * incrementing the TCN until we compare it to the TRR */
+	// between reference matches nothing happens that would require attention, unless interrupt request
+	// is on and has to be kept asserted; TCN is calculated on demand, when it's read
+	if (static_cast<int32>(timer->now - timer->next_change) < 0 && timer->irq != 1)
+		return;
 
-		if (timer->TCN == timer->TRR)
-		{
-			/* timer reference hit */
-			//TRACE("         %s: TCN == TRR = %ld\n", s->name, timer->TRR);
-			timer->TER.REF=1;
-			if (timer->TMR.FRR) {
-				//TRACE("         %s: Restart flag is on, restarting the timer\n", s->name);
-				/* Restart the timer */
-				timer->TCN=0;
-			}
-		} else {
-			/* Ensure the interupt condition is off */
-			timer->TER.REF=0;
-		}
-	
-		/* Now increment the TCN
-		 * FIXME: maybe we shouldn't do this if we just reset the TCN? */
-		timer->TCN++;
-	}
-	auto interrupts_on= false;
+	timer->Sync(timer->now);
+	timer->Refresh(ctx, InterruptSource());
+}
 
-	/* If the timer is at its reference, and ORI is set, then interrupt */
-	if (timer->TER.REF && timer->TMR.ORI)
-	{
-		//TRACE("          %s: timer reference condition exists\n", s->name);
-		interrupts_on = true;
-	}
 
-	if (!interrupts_on)
-	{
-	/* If we get here, we couln't find a condition to turn/leave
-		the interrupts on, so turn 'em off */
-/*	TRACE("%s: No interrupt conditions, withdrawing any interrupt requests\n", s->name);*/
-		ctx.InterruptClear(InterruptSource());
-	}
+// every timer tick changes TCN, but only reference match can trigger an interrupt;
+// when CPU is idle simulator can skip straight to it
+bool SimpleTimer::NextEvent(const Context& ctx, EventScope scope, uint32& at_cycle) const
+{
+	if (!timer->enable)
+		return false;
+
+	if (scope == EventScope::Any)
+		at_cycle = timer->TickAfter(ctx.CyclesTaken() - 1);
+	else if (timer->TMR.ORI || timer->irq != 0)
+		at_cycle = timer->next_change;
 	else
-	{
-	//TRACE("%s: Posting interrupt request for %s\n", s->name);
-		ctx.InterruptAssert(InterruptSource(), EX_SpuriousInterrupt);
-	}
+		return false;
+
+	return true;
 }
 
 
@@ -164,8 +196,10 @@ void SimpleTimer::Reset()
 	timer->TCN = 0;
 	memset(&timer->TER, 0, sizeof(timer->TER));
 	timer->enable = 0;
+	timer->irq = -1;
 	timer->cycles_per_tick = 1;
 	timer->next_tick = 0;
+	timer->next_change = 0;
 }
 
 
@@ -180,6 +214,8 @@ uint32 SimpleTimer::Read(uint32 offset, int access_size)
 
 	uint32 result= 0;
 
+	timer->Sync(timer->now);
+
 	switch (offset)
 	{
 	case 0x0000: /* timer Mode Register (TMR) */
@@ -220,6 +256,13 @@ uint32 SimpleTimer::Read(uint32 offset, int access_size)
 }
 
 
+// all timer registers can be polled freely
+bool SimpleTimer::ReadHasSideEffects(uint32 offset) const
+{
+	return false;
+}
+
+
 // write to device; access_size is 1, 2, or 4
 void SimpleTimer::Write(Context& ctx, uint32 offset, int access_size, uint32 value)
 {
@@ -229,6 +272,9 @@ void SimpleTimer::Write(Context& ctx, uint32 offset, int access_size, uint32 val
 	//	return;
 	//}
 
+	// registers change at this point in time; account for ticks that happened so far
+	timer->Sync(ctx.CyclesTaken());
+
 	switch (offset)
 	{
 	case 0x0000: /* timer Mode Register (TMR) */
@@ -297,10 +343,12 @@ void SimpleTimer::Write(Context& ctx, uint32 offset, int access_size, uint32 val
 			timer->TER.CAP = 0;
 			//TRACE("      Clearing Capture Event\n");
 		}
-		/* INterrupts status will be updated on the next
-		 * Tick() call */
 		break;
 	default:
 		break;
 	}
+
+	// with new register values next reference match may be at a different time
+	if (timer->enable)
+		timer->Refresh(ctx, InterruptSource());
 }
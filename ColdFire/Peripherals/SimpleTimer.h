@@ -28,6 +28,12 @@ public:
 	// write to device; access_size is 1, 2, or 4
 	virtual void Write(Context& ctx, uint32 offset, int access_size, uint32 value);
 
+	// next point in time when device changes its state
+	virtual bool NextEvent(const Context& ctx, EventScope scope, uint32& at_cycle) const;
+
+	// reading registers doesn't change device state
+	virtual bool ReadHasSideEffects(uint32 offset) const;
+
 private:
 	struct _timer_data;
 	_timer_data* timer;
@@ -18,11 +18,12 @@
 
 #include "pch.h"
 #include "SimpleUART.h"
+#include "HostSerialBridge.h"
 #include "../Context.h"
 #include "../PeripheralRepository.h"
 
 // register UART
-static auto reg_uart= GetPeripherals().Register("uart", "5206", &CreateDevice<SimpleUART>);
+static auto reg_uart= GetPeripherals().Register("uart", "5206", &CreateDevice2<SimpleUART>);
 
 
 enum class Offset	// offsets from MBAR
@@ -200,13 +201,32 @@ struct SimpleUART::_uart_data
 //	pthread_mutex_t lock;
 	int port;
 
-	int read_delay_;
+	uint32 next_probe_;	// cycle count at which terminal is probed for input next
+	uint32 rx_probe_cycles_;
+	uint32 char_cycles_;	// optional pacing: cycles it takes to send/receive one character (0 - no pacing)
+	uint32 tx_start_;		// cycle count at which character has been written to UTB
+
+	void Receive(char c);	// store character received from terminal or host in the receiver FIFO
 };
 
+// terminal is probed in simulated time intervals, so polling loop sees characters arriving
+// at the same cycle whether it is executed or skipped by the simulator
+static const uint32 RX_PROBE_CYCLES= 1000;
+
 
-SimpleUART::SimpleUART(PParam params) : Peripheral(params.IOAreaSize(0x40))
+SimpleUART::SimpleUART(PParam params, PeripheralConfigData& config) : Peripheral(params.IOAreaSize(0x40))
 {
 	uart = new _uart_data();
+
+	uart->char_cycles_ = config.get<uint32>("char_cycles", 0);
+	// with pacing there's one character per character time to receive
+	uart->rx_probe_cycles_ = uart->char_cycles_ ? uart->char_cycles_ : config.get<uint32>("rx_probe_cycles", RX_PROBE_CYCLES);
+	if (uart->rx_probe_cycles_ == 0)
+		uart->rx_probe_cycles_ = 1;
+
+	// connect to the host instead of simulator's terminal
+	if (auto port= config.get<uint16>("host_port", 0))
+		bridge_.reset(new HostSerialBridge(port));
 }
 
 
@@ -216,6 +236,50 @@ SimpleUART::~SimpleUART()
 }
 
 
+void SimpleUART::_uart_data::Receive(char c)
+{
+	UIPCR.CTS = 0;
+	UIPCR.COS = 1;
+/*
+	/ * If status == 0, that's EOF * /
+	
+	if (status <= 0) break;
+//			if (status == -1 || c==0) goto interrupt_update;
+	if (c==0) continue; //goto interrupt_update;
+	if (c==0xff) {
+		/ * Escape sequence * /
+		status = recv(fd, &c, 1, 0);
+		status = recv(fd, &c, 1, 0);
+		continue;
+//				goto interrupt_update;
+	}
+
+	TRACE("%s: Got character %d[%c]\n", s->name, c, c);
+*/
+
+	/* If URB has room, store the character */
+	if (URB_count < 3)
+	{
+		URB[(int)URB_count] = static_cast<char>(c);
+		URB_count++;
+	}
+	else
+	{
+//				ERR("%s: URB_count just overflowed!\n", s->name);
+	}
+
+	/* There's something in the buffer now */
+	USR.RxRDY = 1;
+	if (URB_count == 3)
+		USR.FFULL=1;
+
+	if (UMR1.RxIRQ == 0)
+		UISR.RxRDY = USR.RxRDY;
+	else
+		UISR.RxRDY = USR.FFULL;
+}
+
+
 // called during simulator run after executing single opcode
 void SimpleUART::Update(Context& ctx)
 {
@@ -244,14 +308,17 @@ void SimpleUART::Update(Context& ctx)
 		/* If TransmitterReady (TxRDY bit of Status Reg USR)
 		 *  0 - Character waiting in UTB to send
 		 *  1 - Transmitter UTB is empty, and ready to be loaded */
-		if (uart->USR.TxRDY == 0)
+		if (uart->USR.TxRDY == 0 && ctx.CyclesTaken() - uart->tx_start_ >= uart->char_cycles_)
 		{
 			/* We use the fact that send() buffers characters
 			 * for us, so we don't need to shift anything
 			 * into transmit buffers */ 
 			//TRACE("%s: Sending character %c(%d)\n", s->name, uart->UTB,uart->UTB);
-			// output character into the simulator terminal
-			ctx.SimWrite(cf::SimPort::IN_OUT, uart->UTB);
+			// output character into the host connection or simulator terminal
+			if (bridge_)
+				bridge_->Send(static_cast<uint8>(uart->UTB));
+			else
+				ctx.SimWrite(cf::SimPort::IN_OUT, uart->UTB);
 			//if (uart->fd) send(uart->fd, &uart->UTB, 1, 0);
 			/* Signal that there is room in the buffer */
 			uart->USR.TxRDY = 1;
@@ -273,56 +340,25 @@ void SimpleUART::Update(Context& ctx)
 //		uart->UIPCR.COS = 1;
 
 		// slow down reading, probing is expensive
-		auto c= 0;
-		if (uart->read_delay_ > 0)
-			uart->read_delay_--;
-		else
-		{
-			c = ctx.SimRead(cf::SimPort::IN_OUT);
-			uart->read_delay_ = 10;
-		}
-
-		if (c != 0)
+		auto now= ctx.CyclesTaken();
+		auto left= uart->next_probe_ - now;
+		if (left == 0 || left > uart->rx_probe_cycles_)	// due, overdue, or cycle counter was zeroed
 		{
-			uart->UIPCR.CTS = 0;
-			uart->UIPCR.COS = 1;
-/*
-			/ * If status == 0, that's EOF * /
-			
-			if (status <= 0) break;
-//			if (status == -1 || c==0) goto interrupt_update;
-			if (c==0) continue; //goto interrupt_update;
-			if (c==0xff) {
-				/ * Escape sequence * /
-				status = recv(uart->fd, &c, 1, 0);
-				status = recv(uart->fd, &c, 1, 0);
-				continue;
-//				goto interrupt_update;
-			}
-
-			TRACE("%s: Got character %d[%c]\n", s->name, c, c);
-*/
+			uart->next_probe_ = now + uart->rx_probe_cycles_;
 
-			/* If URB has room, store the character */
-			if (uart->URB_count < 3)
+			if (bridge_)
 			{
-				uart->URB[(int)uart->URB_count] = static_cast<char>(c);
-				uart->URB_count++;
+				// bytes wait in the bridge while FIFO is full; without pacing take as much as FIFO can hold
+				uint8 byte= 0;
+				while (uart->URB_count < 3 && bridge_->Receive(byte))
+				{
+					uart->Receive(static_cast<char>(byte));
+					if (uart->char_cycles_ != 0)
+						break;
+				}
 			}
-			else
-			{
-//				ERR("%s: URB_count just overflowed!\n", s->name);
-			}
-
-			/* There's something in the buffer now */
-			uart->USR.RxRDY = 1;
-			if (uart->URB_count == 3)
-				uart->USR.FFULL=1;
-
-			if (uart->UMR1.RxIRQ == 0)
-				uart->UISR.RxRDY = uart->USR.RxRDY;
-			else
-				uart->UISR.RxRDY = uart->USR.FFULL;
+			else if (auto c= ctx.SimRead(cf::SimPort::IN_OUT))
+				uart->Receive(static_cast<char>(c));
 		}
 	}
 	
@@ -365,6 +401,30 @@ void SimpleUART::Update(Context& ctx)
 }
 
 
+// character waiting in a transmitter buffer is sent during next update (or when its time is up if pacing is on);
+// receiver probes terminal periodically, and what it finds may trigger an interrupt if it's enabled
+bool SimpleUART::NextEvent(const Context& ctx, EventScope scope, uint32& at_cycle) const
+{
+	auto now= ctx.CyclesTaken();
+
+	if (uart->transmitter_enabled && uart->USR.TxRDY == 0)
+	{
+		auto sent= now - uart->tx_start_ >= uart->char_cycles_;
+		at_cycle = sent ? now : uart->tx_start_ + uart->char_cycles_;
+		return true;
+	}
+
+	if (uart->receiver_enabled && (scope == EventScope::Any || uart->UIMR.FFULL))
+	{
+		auto left= uart->next_probe_ - now;
+		at_cycle = left > uart->rx_probe_cycles_ ? now : uart->next_probe_;
+		return true;
+	}
+
+	return false;
+}
+
+
 // resetting device
 void SimpleUART::Reset()
 {
@@ -472,7 +532,10 @@ uint32 SimpleUART::Read(uint32 offset, int access_size)
 	case 0x0034: /* Input Port Register (UIP) */
 		/* Set to 0 (meaning nCTS=0, meaning we're Clear to Send) 
 		 * if there is something connected */
-		result = (uart->fd != 0) ? 0 : 1;
+		if (bridge_)
+			result = bridge_->Connected() ? 0 : 1;
+		else
+			result = (uart->fd != 0) ? 0 : 1;
 		break;
 	case 0x0038: /* NO NOT ACCESS */
 	case 0x003C: /* NO NOT ACCESS */
@@ -487,6 +550,12 @@ uint32 SimpleUART::Read(uint32 offset, int access_size)
 }
 
 
+bool SimpleUART::ReadHasSideEffects(uint32 offset) const
+{
+	return offset == 0x000C;	// receiver buffer (URB) read shifts FIFO
+}
+
+
 // write to device; access_size is 1, 2, or 4
 void SimpleUART::Write(Context& ctx, uint32 offset, int access_size, uint32 value)
 {
@@ -638,6 +707,7 @@ void SimpleUART::Write(Context& ctx, uint32 offset, int access_size, uint32 valu
 	case 0x000C: /* Transmitter Buffer (UTB) */
 		//TRACE("   Transmitting character 0x%02x\n", value);
 		uart->UTB = (char)value;
+		uart->tx_start_ = ctx.CyclesTaken();
 
 		/* A write to the UTB Clears the TxRDY bit */
 		uart->USR.TxRDY=0;
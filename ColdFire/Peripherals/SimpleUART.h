@@ -8,12 +8,13 @@
 
 #pragma once
 #include "..\Peripheral.h"
+class HostSerialBridge;
 
 
 class SimpleUART : public Peripheral
 {
 public:
-	SimpleUART(PParam params);
+	SimpleUART(PParam params, PeripheralConfigData& config);
 	virtual ~SimpleUART();
 
 	// called during simulator run after executing single opcode
@@ -28,7 +29,14 @@ public:
 	// write to device; access_size is 1, 2, or 4
 	virtual void Write(Context& ctx, uint32 offset, int access_size, uint32 value);
 
+	// next point in time when device changes its state
+	virtual bool NextEvent(const Context& ctx, EventScope scope, uint32& at_cycle) const;
+
+	// only reading receiver buffer changes device state
+	virtual bool ReadHasSideEffects(uint32 offset) const;
+
 private:
 	struct _uart_data;
 	_uart_data* uart;
+	std::unique_ptr<HostSerialBridge> bridge_;	// host connection replacing simulator terminal, if configured
 };
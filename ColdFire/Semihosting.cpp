@@ -0,0 +1,228 @@
+/*-----------------------------------------------------------------------------
+	ColdFire Macro Assembler and Simulator
+
+	Copyright (C) 2007-2012 Mike Kowalski
+
+	See License.txt for more details
+-----------------------------------------------------------------------------*/
+
+#include "pch.h"
+#include "Semihosting.h"
+#include "Context.h"
+
+namespace {
+	const uint32 FAILURE= ~0u;
+	const uint32 MAX_NAME_LENGTH= 260;
+
+	// parameter block offsets
+	enum { OPERATION= 0, HANDLE= 4, ADDRESS= 8, LENGTH= 12, ORIGIN= 16, RESULT= 20 };
+
+	// guest name has to be a plain relative path that stays inside the root
+	bool IsSandboxed(const Path& name)
+	{
+		if (name.empty() || name.has_root_name() || name.has_root_directory())
+			return false;
+
+		for (auto& part : name)
+			if (part == "..")
+				return false;
+
+		return true;
+	}
+}
+
+
+Semihosting::Semihosting() : next_handle_(1)
+{}
+
+
+Semihosting::~Semihosting()
+{}
+
+
+void Semihosting::SetRoot(const Path& root)
+{
+	CloseAll();
+	root_ = root;
+}
+
+
+void Semihosting::CloseAll()
+{
+	files_.clear();
+}
+
+
+void Semihosting::Request(Context& ctx, uint32 block)
+{
+	auto op= static_cast<cf::SemihostOp>(ctx.ReadMemoryLongWord(block + OPERATION));
+	auto handle= ctx.ReadMemoryLongWord(block + HANDLE);
+	auto address= ctx.ReadMemoryLongWord(block + ADDRESS);
+	auto length= ctx.ReadMemoryLongWord(block + LENGTH);
+
+	uint32 result= FAILURE;
+
+	if (!root_.empty())
+		switch (op)
+		{
+		case cf::SemihostOp::OPEN:
+			result = Open(ctx, address, length);
+			break;
+
+		case cf::SemihostOp::CLOSE:
+			result = Close(handle);
+			break;
+
+		case cf::SemihostOp::READ:
+			result = Read(ctx, handle, address, length);
+			break;
+
+		case cf::SemihostOp::WRITE:
+			result = Write(ctx, handle, address, length);
+			break;
+
+		case cf::SemihostOp::SEEK:
+			result = Seek(handle, static_cast<int32>(length), ctx.ReadMemoryLongWord(block + ORIGIN));
+			break;
+
+		default:
+			break;
+		}
+
+	ctx.WriteToAddress(ctx.GetMemoryAddress(block + RESULT, S_LONG), result, S_LONG);
+}
+
+
+uint32 Semihosting::Open(Context& ctx, uint32 name, uint32 mode)
+{
+	std::string file_name;
+	for (;;)
+	{
+		if (file_name.size() >= MAX_NAME_LENGTH)
+			return FAILURE;
+
+		DecodedAddress da= ctx.GetMemoryAddress(name + static_cast<uint32>(file_name.size()), 1, true);
+		if (da.type != DecodedAddress::RAM && da.type != DecodedAddress::FLASH)
+			return FAILURE;
+
+		auto c= *static_cast<const char*>(da.address);
+		if (c == 0)
+			break;
+		file_name += c;
+	}
+
+	Path path(file_name);
+	if (!IsSandboxed(path))
+		return FAILURE;
+
+	std::ios_base::openmode open_mode= std::ios_base::binary;
+	if (mode & cf::SH_READ)
+		open_mode |= std::ios_base::in;
+	if (mode & cf::SH_WRITE)
+		open_mode |= std::ios_base::out;
+	if (mode & cf::SH_TRUNCATE)
+		open_mode |= std::ios_base::out | std::ios_base::trunc;
+	if (mode & cf::SH_APPEND)
+		open_mode |= std::ios_base::out | std::ios_base::app;
+
+	if ((open_mode & (std::ios_base::in | std::ios_base::out)) == 0)
+		return FAILURE;
+
+	std::unique_ptr<boost::filesystem::fstream> file(new boost::filesystem::fstream(root_ / path, open_mode));
+	if (!file->is_open())
+		return FAILURE;
+
+	auto handle= next_handle_++;
+	if (next_handle_ == FAILURE)
+		next_handle_ = 1;
+
+	files_[handle] = std::move(file);
+	return handle;
+}
+
+
+uint32 Semihosting::Close(uint32 handle)
+{
+	return files_.erase(handle) ? 0 : FAILURE;
+}
+
+
+std::fstream* Semihosting::File(uint32 handle)
+{
+	auto it= files_.find(handle);
+	return it != files_.end() ? it->second.get() : nullptr;
+}
+
+
+uint32 Semihosting::Read(Context& ctx, uint32 handle, uint32 buffer, uint32 length)
+{
+	auto file= File(handle);
+	if (file == nullptr)
+		return FAILURE;
+
+	if (length == 0)
+		return 0;
+
+	// whole buffer has to be in a single writable memory bank
+	DecodedAddress da= ctx.GetMemoryAddress(buffer, length, true);
+	if (da.type != DecodedAddress::RAM)
+		return FAILURE;
+
+	// data goes through the context, so write watches (LCD, watchpoints) see it
+	std::vector<uint8> data(length);
+	file->clear();
+	file->read(reinterpret_cast<char*>(data.data()), length);
+	if (file->bad())
+		return FAILURE;
+
+	auto count= static_cast<uint32>(file->gcount());
+	ctx.WriteMemory(buffer, data.data(), count);
+
+	return count;
+}
+
+
+uint32 Semihosting::Write(Context& ctx, uint32 handle, uint32 buffer, uint32 length)
+{
+	auto file= File(handle);
+	if (file == nullptr)
+		return FAILURE;
+
+	if (length == 0)
+		return 0;
+
+	DecodedAddress da= ctx.GetMemoryAddress(buffer, length, true);
+	if (da.type != DecodedAddress::RAM && da.type != DecodedAddress::FLASH)
+		return FAILURE;
+
+	file->clear();
+	file->write(static_cast<const char*>(da.address), length);
+	if (!file->good())
+		return FAILURE;
+
+	return length;
+}
+
+
+uint32 Semihosting::Seek(uint32 handle, int32 offset, uint32 origin)
+{
+	auto file= File(handle);
+	if (file == nullptr)
+		return FAILURE;
+
+	std::ios_base::seekdir dir;
+	switch (origin)
+	{
+	case 0:		dir = std::ios_base::beg; break;
+	case 1:		dir = std::ios_base::cur; break;
+	case 2:		dir = std::ios_base::end; break;
+	default:	return FAILURE;
+	}
+
+	// get and put positions are shared by file stream
+	file->clear();
+	if (file->seekg(offset, dir).fail())
+		return FAILURE;
+
+	return static_cast<uint32>(file->tellg());
+}
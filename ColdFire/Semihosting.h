@@ -0,0 +1,47 @@
+/*-----------------------------------------------------------------------------
+	ColdFire Macro Assembler and Simulator
+
+	Copyright (C) 2007-2012 Mike Kowalski
+
+	See License.txt for more details
+-----------------------------------------------------------------------------*/
+
+#pragma once
+#include "BasicTypes.h"
+#include <boost/filesystem/fstream.hpp>
+class Context;
+
+// Host file I/O requested by the guest through SimPort::SEMIHOST (see cf::SemihostOp for a parameter block layout).
+// Guest can only access files inside the root directory; data is copied directly between memory banks and files.
+
+class Semihosting
+{
+public:
+	Semihosting();
+	~Semihosting();
+
+	// directory guest files are sandboxed in; empty path disables semihosting (all requests fail)
+	void SetRoot(const Path& root);
+
+	// execute request from parameter block at 'block' and store its result there
+	void Request(Context& ctx, uint32 block);
+
+	// close all files opened by guest
+	void CloseAll();
+
+private:
+	Semihosting(const Semihosting&);
+	Semihosting& operator = (const Semihosting&);
+
+	uint32 Open(Context& ctx, uint32 name, uint32 mode);
+	uint32 Close(uint32 handle);
+	uint32 Read(Context& ctx, uint32 handle, uint32 buffer, uint32 length);
+	uint32 Write(Context& ctx, uint32 handle, uint32 buffer, uint32 length);
+	uint32 Seek(uint32 handle, int32 offset, uint32 origin);
+
+	std::fstream* File(uint32 handle);
+
+	Path root_;
+	std::map<uint32, std::unique_ptr<boost::filesystem::fstream>> files_;
+	uint32 next_handle_;
+};
@@ -0,0 +1,84 @@
+/*-----------------------------------------------------------------------------
+	ColdFire Macro Assembler and Simulator
+
+	Copyright (C) 2007-2012 Mike Kowalski
+
+	See License.txt for more details
+-----------------------------------------------------------------------------*/
+
+#pragma once
+#include <atomic>
+#include <memory>
+#include <thread>
+#include "BasicTypes.h"
+
+// Buffer of words published by a single writer thread and read by any number of reader threads.
+// Writer never waits; readers retry if they catch writer in the middle of an update, so they always
+// get a consistent (torn-free) copy.
+
+class SeqLockBuffer
+{
+public:
+	SeqLockBuffer() : sequence_(0), size_(0)
+	{}
+
+	// no reader or writer can be active at this time
+	void Resize(size_t words)
+	{
+		data_.reset(words ? new std::atomic<uint32>[words] : nullptr);
+		for (size_t i= 0; i < words; ++i)
+			data_[i].store(0, std::memory_order_relaxed);
+		size_ = words;
+		sequence_ = 0;
+	}
+
+	size_t Size() const
+	{
+		return size_;
+	}
+
+	// writer
+	void Write(const uint32* src)
+	{
+		auto seq= sequence_.load(std::memory_order_relaxed);
+		sequence_.store(seq + 1, std::memory_order_relaxed);	// odd: update in progress
+		std::atomic_thread_fence(std::memory_order_release);
+
+		for (size_t i= 0; i < size_; ++i)
+			data_[i].store(src[i], std::memory_order_relaxed);
+
+		sequence_.store(seq + 2, std::memory_order_release);
+	}
+
+	// reader; returns false if nothing has been written yet
+	bool Read(uint32* dest) const
+	{
+		for (;;)
+		{
+			auto seq= sequence_.load(std::memory_order_acquire);
+			if (seq == 0)
+				return false;
+
+			if (seq & 1)
+			{
+				std::this_thread::yield();
+				continue;
+			}
+
+			for (size_t i= 0; i < size_; ++i)
+				dest[i] = data_[i].load(std::memory_order_relaxed);
+
+			std::atomic_thread_fence(std::memory_order_acquire);
+			if (sequence_.load(std::memory_order_relaxed) == seq)
+				return true;
+		}
+	}
+
+private:
+	SeqLockBuffer(const SeqLockBuffer&);
+	SeqLockBuffer& operator = (const SeqLockBuffer&);
+
+	std::atomic<uint32> sequence_;
+	std::unique_ptr<std::atomic<uint32>[]> data_;
+	size_t size_;
+};
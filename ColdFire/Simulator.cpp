@@ -11,9 +11,18 @@
 #include "Context.h"
 #include "DebugInfo.h"
 #include "Breakpoints.h"
+#include "BreakpointCondition.h"
 #include "Instruction.h"
 #include "Peripheral.h"
 #include "PeripheralRepository.h"
+#include "SpscQueue.h"
+#include "SeqLock.h"
+#include "NativeMonitor.h"
+#include "Semihosting.h"
+#include "Cache.h"
+#include "MultiCore.h"
+#include <mutex>
+#include <condition_variable>
 #include <boost/format.hpp>
 #include "HexNumber.h"
 #include <boost/property_tree/info_parser.hpp>
@@ -55,21 +64,67 @@ public:
 	void Remove(uint32 address, cf::BreakpointType type)
 	{
 		bp_.erase(address);
+		conditions_.erase(address);
 	}
 
-	bool Hit(uint32 pc)
+	// condition and hit count apply to execution breakpoint at 'address'; null condition is always true
+	void SetCondition(uint32 address, std::shared_ptr<BreakpointCondition> condition, uint32 hit_count)
+	{
+		if (condition == nullptr && hit_count <= 1)
+		{
+			conditions_.erase(address);
+			return;
+		}
+
+		Condition c= { condition, hit_count, 0 };
+		conditions_[address] = c;
+	}
+
+	uint64 Hits(uint32 address) const
+	{
+		auto it= conditions_.find(address);
+		return it == conditions_.end() ? 0 : it->second.hits;
+	}
+
+	// conditions are checked (and hits counted) only if 'evaluate' is true, temp breakpoints are unconditional
+	bool Hit(uint32 pc, const Context& ctx, bool evaluate)
 	{
 		if (bp_.empty())
 			return false;
 		auto it= bp_.find(pc);
-		if (it != bp_.end() && (it->second & (cf::BPT_EXECUTE | cf::BPT_TEMP_EXEC)))
+		if (it == bp_.end() || !(it->second & (cf::BPT_EXECUTE | cf::BPT_TEMP_EXEC)))
+			return false;
+
+		if (conditions_.empty() || (it->second & cf::BPT_TEMP_EXEC))
+			return true;
+
+		auto c= conditions_.find(pc);
+		if (c == conditions_.end())
 			return true;
+
+		if (!evaluate)
+			return false;
+
+		auto& cond= c->second;
+		if (cond.expr && !cond.expr->Evaluate(ctx))
+			return false;
+
+		return ++cond.hits >= cond.hit_count;
+	}
+
+	// true if there's an enabled conditional breakpoint in [from..to] range
+	bool ConditionalInRange(uint32 from, uint32 to) const
+	{
+		for (auto& c : conditions_)
+			if (c.first >= from && c.first <= to && (Get(c.first) & cf::BPT_EXECUTE))
+				return true;
 		return false;
 	}
 
 	void ClearAll()
 	{
 		bp_.clear();
+		conditions_.clear();
 	}
 
 	bool ClearTemp(uint32 pc)
@@ -99,6 +154,821 @@ public:
 
 private:
 	Map bp_;
+
+	struct Condition
+	{
+		std::shared_ptr<BreakpointCondition> expr;
+		uint32 hit_count;	// stop once condition has held that many times
+		uint64 hits;		// times condition has held
+	};
+	std::unordered_map<uint32, Condition, address_hash> conditions_;
+};
+
+
+// Tracepoints capture values of expressions when execution reaches them, without stopping it. Records go
+// into a lock-free ring drained by the client; if it's full they are dropped and counted.
+
+class Tracepoints
+{
+public:
+	typedef Simulator::TraceRecord Record;
+
+	Tracepoints() : dropped_(0)
+	{}
+
+	// client thread, simulation not running
+	void Set(uint32 address, const std::vector<std::string>& expressions, std::shared_ptr<BreakpointCondition> condition)
+	{
+		if (expressions.size() > Simulator::MAX_TRACE_VALUES)
+			throw RunTimeError("Too many tracepoint expressions in " __FUNCTION__);
+
+		Tracepoint tp;
+		tp.condition = condition;
+		tp.expressions = expressions;
+		for (auto& e : expressions)
+			tp.values.push_back(BreakpointCondition(e));	// throws on syntax errors
+
+		points_[address] = tp;
+	}
+
+	void Remove(uint32 address)
+	{
+		points_.erase(address);
+	}
+
+	void ClearAll()
+	{
+		points_.clear();
+	}
+
+	// true if there's a tracepoint in [from..to] range
+	bool InRange(uint32 from, uint32 to) const
+	{
+		for (auto& p : points_)
+			if (p.first >= from && p.first <= to)
+				return true;
+		return false;
+	}
+
+	// execution thread: capture values if there's a tracepoint at 'pc' and its condition holds
+	void Capture(uint32 pc, const Context& ctx)
+	{
+		if (points_.empty())
+			return;
+		auto it= points_.find(pc);
+		if (it == points_.end())
+			return;
+
+		auto& tp= it->second;
+		if (tp.condition && !tp.condition->Evaluate(ctx))
+			return;
+
+		Record r;
+		r.cycles = ctx.TotalCycles();
+		r.address = pc;
+		r.count = static_cast<uint32>(tp.values.size());
+		for (uint32 i= 0; i < r.count; ++i)
+			r.values[i] = tp.values[i].Value(ctx);
+
+		if (!ring_.Push(r))
+			dropped_.fetch_add(1, std::memory_order_relaxed);
+	}
+
+	// client thread; returns number of records passed to 'fn'
+	template<class Fn>
+	size_t Drain(Fn fn)
+	{
+		size_t count= 0;
+		Record r;
+		while (ring_.Pop(r))
+		{
+			fn(r);
+			++count;
+		}
+		return count;
+	}
+
+	// "cycles address expr=value ..."; expressions are known only while tracepoint exists
+	std::string Format(const Record& r) const
+	{
+		std::ostringstream ost;
+		ost << boost::format("%14d $%08X") % r.cycles % r.address;
+
+		auto it= points_.find(r.address);
+		for (uint32 i= 0; i < r.count; ++i)
+		{
+			if (it != points_.end() && i < it->second.expressions.size())
+				ost << boost::format("  %s=$%08X") % it->second.expressions[i] % r.values[i];
+			else
+				ost << boost::format("  $%08X") % r.values[i];
+		}
+
+		return ost.str();
+	}
+
+	uint64 Dropped() const
+	{
+		return dropped_.load(std::memory_order_relaxed);
+	}
+
+private:
+	enum { RING_SIZE= 4096 };
+
+	struct Tracepoint
+	{
+		std::shared_ptr<BreakpointCondition> condition;	// optional
+		std::vector<std::string> expressions;
+		std::vector<BreakpointCondition> values;
+	};
+
+	std::unordered_map<uint32, Tracepoint, address_hash> points_;
+	SpscQueue<Record, RING_SIZE> ring_;
+	std::atomic<uint64> dropped_;
+};
+
+
+// Detector of tight loops that spin without changing anything (like 'bra *' or polling device status register).
+// If a loop's iteration doesn't write to memory or devices and leaves CPU registers intact, then every
+// following iteration is going to do the same, until some device changes its state.
+
+class IdleLoop
+{
+public:
+	enum : uint32 { MAX_LOOP_SIZE= 64 };	// max backward branch distance in bytes
+
+	IdleLoop()
+	{
+		Reset();
+	}
+
+	void Reset()
+	{
+		armed_ = false;
+	}
+
+	// called after taking a branch at 'branch_addr'; returns true if CPU has just completed loop iteration
+	// identical to the previous one; its cost is returned in 'cycles' and 'instructions'
+	bool Iteration(const Context& ctx, uint32 branch_addr, uint32& cycles, uint32& instructions)
+	{
+		auto head= ctx.Cpu().pc;
+		if (head > branch_addr || branch_addr - head > MAX_LOOP_SIZE)
+			return false;	// not a loop we are looking for
+
+		State state(ctx);
+		bool same= armed_ && head == head_ && side_effects_ == ctx.SideEffects() && state == state_;
+
+		if (same)
+		{
+			cycles = ctx.CyclesTaken() - cycles_;
+			instructions = ctx.ExecutedInstructions() - instructions_;
+		}
+
+		armed_ = true;
+		head_ = head;
+		state_ = state;
+		side_effects_ = ctx.SideEffects();
+		Rebase(ctx);
+
+		return same;
+	}
+
+	// start counting iteration cost anew (after cycles were skipped)
+	void Rebase(const Context& ctx)
+	{
+		cycles_ = ctx.CyclesTaken();
+		instructions_ = ctx.ExecutedInstructions();
+	}
+
+private:
+	struct State
+	{
+		State()
+		{}
+
+		explicit State(const Context& ctx)
+		{
+			auto& cpu= ctx.Cpu();
+			auto it= std::copy(cpu.d_reg, cpu.d_reg + 8, regs.begin());
+			it = std::copy(cpu.a_reg, cpu.a_reg + 8, it);
+			auto stacks= cpu.GetStackPointers();
+			*it++ = stacks.first;
+			*it++ = stacks.second;
+			*it++ = cpu.pc;
+			*it++ = cpu.vbr;
+			*it++ = cpu.mbar;
+			*it++ = uint32(cpu.extend) | uint32(cpu.carry) << 1 | uint32(cpu.zero) << 2 | uint32(cpu.negative) << 3 |
+				uint32(cpu.overflow) << 4 | uint32(cpu.Supervisor()) << 5 | uint32(cpu.Trace()) << 6 | uint32(cpu.InterruptLevel()) << 8;
+			// FPU state, compared bit for bit (so NaNs match too)
+			memcpy(&*it, cpu.fp, sizeof cpu.fp);
+			it += sizeof cpu.fp / sizeof(uint32);
+			*it++ = cpu.fpcr;
+			*it++ = cpu.fpsr;
+			*it++ = cpu.fpiar;
+		}
+
+		bool operator == (const State& s) const
+		{
+			return regs == s.regs;
+		}
+
+		std::array<uint32, 22 + 16 + 3> regs;
+	};
+
+	bool armed_;
+	uint32 head_;
+	State state_;
+	uint32 side_effects_;
+	uint32 cycles_;
+	uint32 instructions_;
+};
+
+
+// Device access notifications passed from the simulation thread to the client thread. Each device and access kind
+// has at most one event in a queue; repeated accesses are coalesced, so the queue cannot overflow and simulation
+// never waits for the client to catch up.
+
+class DeviceEvents
+{
+public:
+	DeviceEvents() : doorbell_(true)
+	{}
+
+	// allocate room for 'devices'; no simulation can be running at this time
+	void Resize(size_t devices)
+	{
+		auto count= devices * ACCESS_KINDS;
+		if (count > QUEUE_SIZE)
+			throw LogicError("Too many peripherals to report their events in " __FUNCTION__);
+
+		slots_.reset(new Slot[count]);
+		for (size_t i= 0; i < count; ++i)
+		{
+			slots_[i].queued = false;
+			slots_[i].param = 0;
+		}
+
+		uint16 index;
+		while (queue_.Pop(index))
+			;
+		doorbell_ = true;
+	}
+
+	// simulation thread; returns true if the client needs to be told that there are events waiting
+	bool Post(size_t device, cf::DeviceAccess access, uint32 param)
+	{
+		auto index= static_cast<uint16>(device * ACCESS_KINDS + static_cast<int>(access));
+		auto& slot= slots_[index];
+
+		slot.param.store(param, std::memory_order_relaxed);
+		if (slot.queued.exchange(true))
+			return false;	// already waiting in a queue
+
+		queue_.Push(index);	// cannot fail, there's room for all slots
+
+		// only the first event after the client has drained the queue rings the bell
+		return doorbell_.exchange(false);
+	}
+
+	// client thread; 'fn(device, access, param)' is called for every event pending
+	template<class Fn>
+	void Drain(Fn fn)
+	{
+		// rearm first: events posted after the queue is found empty will ring again
+		doorbell_ = true;
+
+		uint16 index;
+		while (queue_.Pop(index))
+		{
+			auto& slot= slots_[index];
+			slot.queued = false;
+			fn(index / ACCESS_KINDS, static_cast<cf::DeviceAccess>(index % ACCESS_KINDS), slot.param.load(std::memory_order_relaxed));
+		}
+	}
+
+private:
+	enum { ACCESS_KINDS= 4, QUEUE_SIZE= 1024 };	// read, write, reset, refresh for up to 0x100 devices
+
+	struct Slot
+	{
+		std::atomic<bool> queued;
+		std::atomic<uint32> param;
+	};
+
+	std::unique_ptr<Slot[]> slots_;
+	SpscQueue<uint16, QUEUE_SIZE> queue_;
+	std::atomic<bool> doorbell_;
+};
+
+
+// Code regions measured by the guest itself: begin and end markers carry address of region's name.
+// Nested begin markers of the same region are counted, and only the outermost pair is measured.
+
+class ProfileRegions
+{
+public:
+	typedef Simulator::ProfileRegion Region;
+
+	void Begin(Context& ctx, uint32 name)
+	{
+		auto& r= Find(ctx, name);
+		if (r.depth++ == 0)
+		{
+			r.start = ctx.TotalCycles();
+			if (auto caches= ctx.GetCacheModel())
+			{
+				r.icache = caches->Instructions().Stats();
+				r.dcache = caches->Data().Stats();
+			}
+		}
+	}
+
+	void End(Context& ctx, uint32 name)
+	{
+		auto it= regions_.find(name);
+		if (it == regions_.end() || it->second.depth == 0)
+			return;	// unbalanced end marker
+
+		auto& r= it->second;
+		if (--r.depth > 0)
+			return;
+
+		auto cycles= ctx.TotalCycles() - r.start;
+		auto& stat= r.stat;
+		stat.min_cycles = stat.count == 0 ? cycles : std::min(stat.min_cycles, cycles);
+		stat.max_cycles = std::max(stat.max_cycles, cycles);
+		stat.total_cycles += cycles;
+		stat.count++;
+
+		if (auto caches= ctx.GetCacheModel())
+		{
+			Accumulate(stat.icache, r.icache, caches->Instructions().Stats());
+			Accumulate(stat.dcache, r.dcache, caches->Data().Stats());
+		}
+	}
+
+	std::vector<Region> Get() const
+	{
+		std::vector<Region> v;
+		v.reserve(regions_.size());
+		for (auto& r : regions_)
+			v.push_back(r.second.stat);
+		return v;
+	}
+
+	void Clear()
+	{
+		regions_.clear();
+	}
+
+private:
+	struct Entry
+	{
+		Region stat;
+		uint64 start;
+		uint32 depth;
+		cf::CacheStats icache;	// cache counters at the start
+		cf::CacheStats dcache;
+	};
+
+	static void Accumulate(cf::CacheStats& total, const cf::CacheStats& start, const cf::CacheStats& end)
+	{
+		total.accesses += end.accesses - start.accesses;
+		total.misses += end.misses - start.misses;
+		total.writebacks += end.writebacks - start.writebacks;
+		total.uncached += end.uncached - start.uncached;
+		total.cycles += end.cycles - start.cycles;
+	}
+
+	Entry& Find(Context& ctx, uint32 name)
+	{
+		auto it= regions_.find(name);
+		if (it != regions_.end())
+			return it->second;
+
+		Entry e;
+		e.stat.id = name;
+		e.stat.count = e.stat.min_cycles = e.stat.max_cycles = e.stat.total_cycles = 0;
+		e.start = 0;
+		e.depth = 0;
+
+		// name is read once, when region is seen for the first time
+		const size_t MAX_NAME= 64;
+		for (uint32 addr= name; e.stat.name.size() < MAX_NAME; ++addr)
+		{
+			DecodedAddress da= ctx.GetMemoryAddress(addr, 1, true);
+			if (da.type != DecodedAddress::RAM && da.type != DecodedAddress::FLASH)
+				break;
+			auto c= *static_cast<const char*>(da.address);
+			if (c == 0)
+				break;
+			e.stat.name += c;
+		}
+		if (e.stat.name.empty())
+			e.stat.name = (boost::format("$%08X") % name).str();
+
+		return regions_[name] = e;
+	}
+
+	std::map<uint32, Entry> regions_;
+};
+
+
+// Interrupt requests tracked from assertion to the end of their handlers. Handlers nest, so they are kept
+// on a stack; handler ends when CPU's interrupt mask drops below its level.
+
+class InterruptLatencyStats : public InterruptObserver
+{
+public:
+	typedef Simulator::InterruptLatency Stat;
+	typedef Simulator::LatencyHistogram Histogram;
+	enum { BUCKETS= 32 };
+
+	InterruptLatencyStats() : mask_(7)
+	{}
+
+	virtual void Asserted(int source, int level, uint64 at)
+	{
+		auto& r= Find(source);
+		if (r.pending)
+			return;	// request is already pending
+
+		r.pending = true;
+		r.level = level;
+		r.asserted_at = at;
+		r.masked = 0;
+		r.masked_since = at;
+		r.is_masked = level <= mask_;
+		r.stat.asserted++;
+	}
+
+	virtual void Cleared(int source, uint64 at)
+	{
+		auto it= sources_.find(source);
+		if (it == sources_.end() || !it->second.pending)
+			return;
+
+		it->second.pending = false;
+		it->second.stat.withdrawn++;
+	}
+
+	virtual void Entered(int source, int level, uint64 at)
+	{
+		auto& r= Find(source);
+		if (r.pending)
+		{
+			if (r.is_masked)
+				r.masked += at - r.masked_since;
+			Add(r.stat.latency, at - r.asserted_at);
+			Add(r.stat.masked, r.masked);
+			r.pending = false;
+		}
+
+		Handler h= { source, level, at };
+		handlers_.push_back(h);
+	}
+
+	virtual void MaskChanged(int mask, uint64 at)
+	{
+		while (!handlers_.empty() && handlers_.back().level > mask)
+		{
+			auto& h= handlers_.back();
+			Add(Find(h.source).stat.service, at - h.entered_at);
+			handlers_.pop_back();
+		}
+
+		mask_ = mask;
+
+		for (auto& s : sources_)
+		{
+			auto& r= s.second;
+			bool masked= r.level <= mask;
+			if (!r.pending || masked == r.is_masked)
+				continue;
+
+			if (r.is_masked)
+				r.masked += at - r.masked_since;
+			else
+				r.masked_since = at;
+			r.is_masked = masked;
+		}
+	}
+
+	// forget requests and handlers in progress, keep statistics
+	void Restart(int mask)
+	{
+		for (auto& s : sources_)
+			s.second.pending = false;
+		handlers_.clear();
+		mask_ = mask;
+	}
+
+	std::vector<Stat> Get() const
+	{
+		std::vector<Stat> v;
+		v.reserve(sources_.size());
+		for (auto& s : sources_)
+			v.push_back(s.second.stat);
+		return v;
+	}
+
+	void Clear()
+	{
+		sources_.clear();
+		handlers_.clear();
+	}
+
+private:
+	struct Entry
+	{
+		Stat stat;
+		bool pending;
+		bool is_masked;
+		int level;
+		uint64 asserted_at;
+		uint64 masked_since;
+		uint64 masked;			// cycles spent masked so far
+	};
+
+	struct Handler
+	{
+		int source;
+		int level;
+		uint64 entered_at;
+	};
+
+	static void Add(Histogram& h, uint64 cycles)
+	{
+		h.min_cycles = h.count == 0 ? cycles : std::min(h.min_cycles, cycles);
+		h.max_cycles = std::max(h.max_cycles, cycles);
+		h.total_cycles += cycles;
+		h.count++;
+
+		size_t bucket= 0;
+		while (bucket < BUCKETS - 1 && (cycles >> bucket) != 0)
+			++bucket;
+		h.buckets[bucket]++;
+	}
+
+	static void Init(Histogram& h)
+	{
+		h.count = h.min_cycles = h.max_cycles = h.total_cycles = 0;
+		h.buckets.assign(BUCKETS, 0);
+	}
+
+	Entry& Find(int source)
+	{
+		auto it= sources_.find(source);
+		if (it != sources_.end())
+			return it->second;
+
+		Entry e;
+		e.stat.source = source;
+		e.stat.asserted = e.stat.withdrawn = 0;
+		Init(e.stat.latency);
+		Init(e.stat.masked);
+		Init(e.stat.service);
+		e.pending = e.is_masked = false;
+		e.level = 0;
+		e.asserted_at = e.masked_since = e.masked = 0;
+
+		return sources_[source] = e;
+	}
+
+	std::map<int, Entry> sources_;
+	std::vector<Handler> handlers_;
+	int mask_;
+};
+
+
+// Stack pointer's lowest values; A7 is attributed to SSP or USP depending on CPU mode, and independently
+// to any task stack it points into (task stack spans [base, base + size], so empty stack counts too).
+
+class StackUsageStats : public StackObserver
+{
+public:
+	typedef Simulator::StackUsage Stack;
+
+	StackUsageStats()
+	{
+		Init(ssp_, "SSP", 0, 0);
+		Init(usp_, "USP", 0, 0);
+	}
+
+	virtual void StackMoved(uint32 sp, bool supervisor, uint32 pc)
+	{
+		auto& s= supervisor ? ssp_ : usp_;
+		if (!s.used || sp > s.top)
+			s.top = sp;
+		Mark(s, sp, pc);
+
+		for (auto& t : tasks_)
+			if (sp - t.base <= t.size)
+				Mark(t, sp, pc);
+	}
+
+	void AddTask(const std::string& name, uint32 base, uint32 size)
+	{
+		Stack t;
+		Init(t, name, base, size);
+		tasks_.push_back(t);
+	}
+
+	void RemoveTasks()
+	{
+		tasks_.clear();
+	}
+
+	std::vector<Stack> Get() const
+	{
+		std::vector<Stack> v;
+		v.reserve(tasks_.size() + 2);
+		v.push_back(ssp_);
+		v.push_back(usp_);
+		v.insert(v.end(), tasks_.begin(), tasks_.end());
+		return v;
+	}
+
+	void Clear()
+	{
+		Init(ssp_, ssp_.name, 0, 0);
+		Init(usp_, usp_.name, 0, 0);
+		for (auto& t : tasks_)
+			Init(t, t.name, t.base, t.size);
+	}
+
+private:
+	static void Init(Stack& s, const std::string& name, uint32 base, uint32 size)
+	{
+		s.name = name;
+		s.base = base;
+		s.size = size;
+		s.top = s.lowest = base + size;
+		s.pc = 0;
+		s.used = false;
+	}
+
+	static void Mark(Stack& s, uint32 sp, uint32 pc)
+	{
+		if (s.used && sp >= s.lowest)
+			return;
+
+		s.lowest = sp;
+		s.pc = pc;
+		s.used = true;
+	}
+
+	Stack ssp_;
+	Stack usp_;
+	std::vector<Stack> tasks_;
+};
+
+
+// Access counters for each cache line sized block of memory banks, and misaligned access counters
+// for instructions.
+
+class HeatMapStats : public MemoryObserver
+{
+public:
+	typedef Simulator::HeatMapBlock Block;
+	typedef Simulator::MisalignedAccess Misaligned;
+
+	HeatMapStats() : shift_(4), last_(0)
+	{}
+
+	void SetLineSize(uint32 line_size)
+	{
+		uint32 shift= 0;
+		while ((uint32(1) << shift) < line_size && shift < 31)
+			++shift;
+
+		if (shift != shift_)
+		{
+			shift_ = shift;
+			banks_.clear();
+		}
+	}
+
+	// (re)create counters if memory configuration has changed
+	void Prepare(const Context& ctx)
+	{
+		std::vector<Bank> banks;
+		for (int i= 0; ; ++i)
+		{
+			auto info= ctx.GetMemoryBankInfo(i);
+			if (!info.IsValid())
+				break;
+
+			Bank b;
+			b.base = info.Base();
+			b.end = info.End();
+			banks.push_back(b);
+		}
+
+		bool same= banks.size() == banks_.size();
+		for (size_t i= 0; same && i < banks.size(); ++i)
+			same = banks[i].base == banks_[i].base && banks[i].end == banks_[i].end;
+		if (same)
+			return;
+
+		for (auto& b : banks)
+			b.counters.resize(static_cast<size_t>(((uint64(b.end) - b.base) >> shift_) + 1));
+		banks_.swap(banks);
+		last_ = 0;
+	}
+
+	virtual void Accessed(const DecodedAddress& da, int access_size, Kind kind, uint32 pc)
+	{
+		auto addr= da.cf_addr;
+
+		if ((access_size == 2 && (addr & 1)) || (access_size == 4 && (addr & 3)))
+			misaligned_[pc]++;
+
+		if (da.type != DecodedAddress::RAM && da.type != DecodedAddress::FLASH)
+			return;
+
+		// consecutive accesses tend to hit the same bank
+		if (last_ >= banks_.size() || addr < banks_[last_].base || addr > banks_[last_].end)
+		{
+			last_ = 0;
+			while (last_ < banks_.size() && (addr < banks_[last_].base || addr > banks_[last_].end))
+				++last_;
+			if (last_ == banks_.size())
+				return;
+		}
+
+		auto& bank= banks_[last_];
+		auto& c= bank.counters[(addr - bank.base) >> shift_];
+		switch (kind)
+		{
+		case Fetch:	c.fetches++; break;
+		case Read:	c.reads++; break;
+		case Write:	c.writes++; break;
+		}
+	}
+
+	std::vector<Block> GetBlocks() const
+	{
+		std::vector<Block> v;
+		for (auto& b : banks_)
+			for (size_t i= 0; i < b.counters.size(); ++i)
+			{
+				auto& c= b.counters[i];
+				if (c.fetches == 0 && c.reads == 0 && c.writes == 0)
+					continue;
+
+				Block block= { b.base + static_cast<uint32>(i << shift_), c.fetches, c.reads, c.writes };
+				v.push_back(block);
+			}
+		return v;
+	}
+
+	std::vector<Misaligned> GetMisaligned() const
+	{
+		std::vector<Misaligned> v;
+		v.reserve(misaligned_.size());
+		for (auto& m : misaligned_)
+		{
+			Misaligned a= { m.first, m.second };
+			v.push_back(a);
+		}
+		std::sort(v.begin(), v.end(), [](const Misaligned& a, const Misaligned& b) { return a.count > b.count || (a.count == b.count && a.pc < b.pc); });
+		return v;
+	}
+
+	uint32 LineSize() const
+	{
+		return uint32(1) << shift_;
+	}
+
+	void Clear()
+	{
+		for (auto& b : banks_)
+			std::fill(b.counters.begin(), b.counters.end(), Counters());
+		misaligned_.clear();
+	}
+
+private:
+	struct Counters
+	{
+		Counters() : fetches(0), reads(0), writes(0)
+		{}
+
+		uint64 fetches;
+		uint64 reads;
+		uint64 writes;
+	};
+
+	struct Bank
+	{
+		uint32 base;
+		uint32 end;
+		std::vector<Counters> counters;
+	};
+
+	uint32 shift_;			// log2 of line size
+	std::vector<Bank> banks_;
+	size_t last_;			// bank hit last time
+	std::unordered_map<uint32, uint64> misaligned_;
 };
 
 
@@ -111,13 +981,22 @@ struct Simulator::Impl
 		stop_execution_ = false;
 		debug_ = nullptr;
 		temp_bp_addr_to_clear_ = 0;
-		ctx_->SetPeripheralCallback(std::bind(&Simulator::Impl::PeripheralsIO, this, std::placeholders::_1, std::placeholders::_2, std::placeholders::_3, std::placeholders::_4));
+		snapshot_interval_ = snapshot_countdown_ = 0;
+		cycles_hi_latch_ = instructions_hi_latch_ = 0;
+		heat_map_enabled_ = false;
+		watch_hit_ = false;
+		watch_address_ = 0;
+		ctx_->SetPeripheralCallback([this](uint32 addr, int access_size, uint32& val, bool read) { return PeripheralsIO(*ctx_, addr, access_size, val, read); });
+		ctx_->SetSimulatorCallback([this](uint32 addr, int access_size, uint32& val, bool read) { return SimulatorIO(*ctx_, addr, access_size, val, read); });
+		exec_ = std::thread(&Simulator::Impl::WorkerThread, this);
 	}
 
 	~Impl()
 	{
+		stop_execution_ = true;
+		PostCommand(Command::Quit);
 		if (exec_.joinable())
-			exec_.detach();
+			exec_.join();
 	}
 
 	PeripheralDevice* AddPeripheral(const char* category, const char* version, uint16 io_area_offset, uint16 io_area_size, uint16 interrupt_source, bool trace, bool notify, PeripheralConfigData& config);
@@ -125,13 +1004,41 @@ struct Simulator::Impl
 	std::unique_ptr<Context> ctx_;
 	std::function<void (cf::Event ev, const EventArgs& params /*cf::uint32 param*/)> callback_;
 	SimulatorStatus status_;
-	std::thread exec_;
-	bool stop_execution_;
+	std::thread exec_;	// long-lived execution thread, waiting for commands
+	std::atomic<bool> stop_execution_;
 	masm::DebugInfo* debug_;
 	Breakpoints breakpoints_;
+	Tracepoints tracepoints_;
+	std::map<uint32, uint32> watchpoints_;	// address and length of write watchpoints
+	bool watch_hit_;						// set by execution thread when watched memory has been written to
+	uint32 watch_address_;
 	boost::ptr_vector<Peripheral> peripherals_;
 	std::array<uint8, Context::MBAR_WINDOW> periperals_io_area_;
 	uint32 temp_bp_addr_to_clear_;
+	IdleLoop idle_loop_;
+	DeviceEvents device_events_;
+	PeripheralCallback simulator_io_;	// client's handler of simulator I/O area
+	Semihosting semihosting_;
+	ProfileRegions profile_;
+	InterruptLatencyStats irq_latency_;
+	StackUsageStats stack_usage_;
+	HeatMapStats heat_map_;
+	bool heat_map_enabled_;
+	std::unique_ptr<CacheModel> caches_;	// optional
+	MultiCore cores_;					// cores other than ctx_ on multi-core boards
+	uint32 cycles_hi_latch_;			// high words of counters captured when low words are read
+	uint32 instructions_hi_latch_;
+
+	// published CPU state and watched memory
+	enum { SNAPSHOT_CPU_WORDS= sizeof(CpuSnapshot) / sizeof(uint32) };
+	uint32 snapshot_interval_;
+	uint32 snapshot_countdown_;
+	std::vector<std::pair<uint32, uint32>> watched_;	// address and length of watched memory ranges
+	std::vector<uint32> snapshot_data_;
+	SeqLockBuffer snapshot_;
+
+	void ResizeSnapshot();
+	void PublishSnapshot();
 
 	void SendUpdate(cf::Event ev)
 	{
@@ -155,6 +1062,15 @@ struct Simulator::Impl
 	}
 
 	enum class Condition { Run, TillRet, SingleStep };
+
+	// commands for the execution thread; they come from a single client thread
+	enum class Command : uint8 { Run, TillRet, SingleStep, Quit };
+	SpscQueue<Command, 16> commands_;
+	std::mutex wake_lock_;
+	std::condition_variable wake_;
+
+	void PostCommand(Command cmd);
+
 	SimulatorStatus Run(Condition cond);
 	SimulatorStatus StepOver();
 	SimulatorStatus Step();
@@ -163,11 +1079,39 @@ struct Simulator::Impl
 	bool CanRun() const;
 	bool CannotRun() const	{ return !CanRun(); }
 
-	bool PeripheralsIO(uint32 addr, int access_size, uint32& ret_val, bool read);
+	// device and simulator I/O made by core using 'ctx'
+	bool PeripheralsIO(Context& ctx, uint32 addr, int access_size, uint32& ret_val, bool read);
+
+	void UpdatePeripherals()
+	{
+		auto lock= cores_.LockIO();
+		for (size_t i= 0, count= peripherals_.size(); i < count; ++i)
+			if (peripherals_[i].DoUpdate(*ctx_))
+				if (device_events_.Post(i, cf::DeviceAccess::Refresh, 0))
+					SendUpdate(cf::E_DEVICE_EVENTS);
+	}
+	bool SimulatorIO(Context& ctx, uint32 addr, int access_size, uint32& ret_val, bool read);
 
 private:
+	void WorkerThread();
+	Command WaitForCommand();
 	void RunThread(Condition cond);
 	SimulatorStatus RunSimulation(Condition cond);
+	void SkipToNextEvent();
+	void SkipIdleLoop(uint32 branch_addr);
+
+	// cycles left till other cores have to catch up; zero if there are no other cores
+	uint32 CyclesToBarrier() const
+	{
+		auto now= ctx_->TotalCycles();
+		return now < cores_.NextBarrier() ? static_cast<uint32>(cores_.NextBarrier() - now) : 0;
+	}
+
+	void SyncCores()
+	{
+		if (cores_.Active() && ctx_->TotalCycles() >= cores_.NextBarrier())
+			cores_.Barrier(*ctx_);
+	}
 };
 
 
@@ -415,6 +1359,22 @@ void Simulator::Reset()
 		p.DoReset(*impl_->ctx_);
 
 	impl_->ctx_->HaltExecution(false);
+	impl_->ctx_->ExitStopState();
+
+	// other cores are held in reset till core 0 starts them
+	impl_->cores_.Reset(*impl_->ctx_);
+
+	// files opened by previous program are of no use now
+	impl_->semihosting_.CloseAll();
+
+	impl_->irq_latency_.Restart(impl_->ctx_->Cpu().InterruptLevel());
+
+	// caches come out of reset invalid and disabled (CACR is zero)
+	if (impl_->caches_)
+	{
+		impl_->caches_->Instructions().InvalidateAll();
+		impl_->caches_->Data().InvalidateAll();
+	}
 
 	impl_->status_ = SIM_STOPPED;
 
@@ -504,16 +1464,70 @@ SimulatorStatus Simulator::Impl::Run(Condition cond)
 	if (CannotRun())
 		return status_;
 
-	if (exec_.joinable())
-		exec_.detach();
-
 	stop_execution_ = false;
-	exec_.swap(std::thread(&Simulator::Impl::RunThread, this, cond));
+	// running state is set here rather than by execution thread, so the next command cannot sneak in
+	status_ = SIM_IS_RUNNING;
+
+	switch (cond)
+	{
+	case Condition::Run:		PostCommand(Command::Run); break;
+	case Condition::TillRet:	PostCommand(Command::TillRet); break;
+	case Condition::SingleStep:	PostCommand(Command::SingleStep); break;
+	}
 
 	return status_;
 }
 
 
+void Simulator::Impl::PostCommand(Command cmd)
+{
+	// queue is short, but execution thread keeps draining it
+	while (!commands_.Push(cmd))
+		std::this_thread::yield();
+
+	// wake up execution thread if it's waiting; taking the lock guarantees that it either
+	// sees the command before going to sleep, or receives this notification
+	{
+		std::lock_guard<std::mutex> lock(wake_lock_);
+	}
+	wake_.notify_one();
+}
+
+
+Simulator::Impl::Command Simulator::Impl::WaitForCommand()
+{
+	Command cmd;
+
+	// commands often come back to back (scripted stepping); spin for a while before falling asleep
+	for (int i= 0; i < 2000; ++i)
+	{
+		if (commands_.Pop(cmd))
+			return cmd;
+		std::this_thread::yield();
+	}
+
+	std::unique_lock<std::mutex> lock(wake_lock_);
+	wake_.wait(lock, [&] { return commands_.Pop(cmd); });
+
+	return cmd;
+}
+
+
+void Simulator::Impl::WorkerThread()
+{
+	for (;;)
+	{
+		switch (WaitForCommand())
+		{
+		case Command::Run:			RunThread(Condition::Run); break;
+		case Command::TillRet:		RunThread(Condition::TillRet); break;
+		case Command::SingleStep:	RunThread(Condition::SingleStep); break;
+		case Command::Quit:			return;
+		}
+	}
+}
+
+
 void Simulator::Impl::RunThread(Condition cond)
 {
 	try
@@ -522,15 +1536,32 @@ void Simulator::Impl::RunThread(Condition cond)
 
 		SendUpdate(cf::E_RUNNING);
 
+		// only accesses made by running program are counted, not those made by clients
+		if (heat_map_enabled_)
+		{
+			heat_map_.Prepare(*ctx_);
+			ctx_->SetMemoryObserver(&heat_map_);
+		}
+		ctx_->SetCacheModel(caches_.get());
+		cores_.Attach(*ctx_, std::bind(&Simulator::Impl::PeripheralsIO, this, std::placeholders::_1, std::placeholders::_2, std::placeholders::_3, std::placeholders::_4, std::placeholders::_5),
+			std::bind(&Simulator::Impl::SimulatorIO, this, std::placeholders::_1, std::placeholders::_2, std::placeholders::_3, std::placeholders::_4, std::placeholders::_5));
+
 		status_ = RunSimulation(cond);
 
-		SendUpdate(cf::E_EXEC_STOPPED);
+		cores_.Detach();
+		ctx_->SetMemoryObserver(nullptr);
+		ctx_->SetCacheModel(nullptr);
 
-		if (exec_.joinable())
-			exec_.detach();
+		if (snapshot_interval_)
+			PublishSnapshot();
+
+		SendUpdate(cf::E_EXEC_STOPPED);
 	}
 	catch (...)
 	{
+		cores_.Detach();
+		ctx_->SetMemoryObserver(nullptr);
+		ctx_->SetCacheModel(nullptr);
 		status_ = SIM_INTERNAL_ERROR;
 	}
 }
@@ -587,6 +1618,9 @@ SimulatorStatus Simulator::Impl::RunSimulation(Condition cond)
 {
 	auto old_stacks= ctx_->Cpu().GetStackPointers();
 	auto exec_pending= false;
+	auto stop_state= false;
+	idle_loop_.Reset();
+	watch_hit_ = false;
 
 	try
 	{
@@ -595,7 +1629,28 @@ SimulatorStatus Simulator::Impl::RunSimulation(Condition cond)
 			if (ctx_->IsExecutionHalted())
 				return SIM_FINISHED;
 
-			if (breakpoints_.Hit(ctx_->Cpu().pc))
+			if (ctx_->IsInStopState())
+			{
+				// instructions don't advance the snapshot countdown here; CPU state won't change till
+				// it wakes up, so it's published once on entering STOP state
+				if (!stop_state && snapshot_interval_)
+					PublishSnapshot();
+				stop_state = true;
+
+				// nothing to execute; let time pass till some device wakes CPU up
+				SkipToNextEvent();
+
+				UpdatePeripherals();
+
+				SyncCores();
+
+				if (cond == Condition::SingleStep)
+					break;
+
+				continue;
+			}
+
+			if (breakpoints_.Hit(ctx_->Cpu().pc, *ctx_, exec_pending))
 			{
 				if (breakpoints_.ClearTemp(ctx_->Cpu().pc))
 					return SIM_STOPPED;
@@ -604,7 +1659,10 @@ SimulatorStatus Simulator::Impl::RunSimulation(Condition cond)
 			}
 
 			exec_pending = true;
+			stop_state = false;
 
+			auto pc= ctx_->Cpu().pc;
+			tracepoints_.Capture(pc, *ctx_);
 			auto instruction= ctx_->ExecuteInstruction(false);
 
 			if (cond == Condition::TillRet && instruction != nullptr && instruction->ControlFlow() == IControlFlow::RETURN)
@@ -616,11 +1674,20 @@ SimulatorStatus Simulator::Impl::RunSimulation(Condition cond)
 					break;
 			}
 
+			if (instruction != nullptr && instruction->ControlFlow() == IControlFlow::BRANCH && cond != Condition::SingleStep)
+				SkipIdleLoop(pc);
+
 			// update peripherals
-			for (auto& p : peripherals_)
-				p.DoUpdate(*ctx_);
+			UpdatePeripherals();
+
+			SyncCores();
 
-			if (cond == Condition::SingleStep)
+			if (snapshot_interval_ && --snapshot_countdown_ == 0)
+				PublishSnapshot();
+
+			// write watchpoints stop execution after the instruction that wrote to watched memory;
+			// devices are updated first, so they don't lag behind
+			if (watch_hit_ || cond == Condition::SingleStep)
 				break;
 		}
 	}
@@ -644,85 +1711,247 @@ SimulatorStatus Simulator::Impl::RunSimulation(Condition cond)
 	if (ctx_->IsExecutionHalted())
 		return SIM_FINISHED;
 
+	if (watch_hit_)
+		return SIM_BREAKPOINT_HIT;
+
 	return SIM_STOPPED;
 }
 
 
-cf::uint32 Simulator::GetRegister(cf::Register reg) const
+// CPU is in a STOP state: instead of simulating idle cycles one by one advance cycle counter
+// straight to the nearest device event that can bring CPU back to life (interrupt)
+void Simulator::Impl::SkipToNextEvent()
 {
-	switch (reg)
+	const auto now= ctx_->CyclesTaken();
+	bool found= false;
+	uint32 delta= 0;
+
+	for (auto& p : peripherals_)
+	{
+		uint32 at= 0;
+		if (p.DoNextEvent(*ctx_, EventScope::Interrupt, at))
+		{
+			// events overdue are treated as immediate
+			uint32 d= static_cast<int32>(at - now) > 0 ? at - now : 0;
+			if (!found || d < delta)
+				delta = d;
+			found = true;
+		}
+	}
+
+	// other cores may wake this one up, but only at a barrier
+	if (cores_.Active())
+	{
+		auto barrier= CyclesToBarrier();
+		if (!found || barrier < delta)
+			delta = barrier;
+		found = true;
+	}
+
+	if (found)
+		ctx_->SkipCycles(delta);
+	else
 	{
-	case cf::R_D0:	return impl_->ctx_->Cpu().d_reg[0];
-	case cf::R_D1:	return impl_->ctx_->Cpu().d_reg[1];
-	case cf::R_D2:	return impl_->ctx_->Cpu().d_reg[2];
-	case cf::R_D3:	return impl_->ctx_->Cpu().d_reg[3];
-	case cf::R_D4:	return impl_->ctx_->Cpu().d_reg[4];
-	case cf::R_D5:	return impl_->ctx_->Cpu().d_reg[5];
-	case cf::R_D6:	return impl_->ctx_->Cpu().d_reg[6];
-	case cf::R_D7:	return impl_->ctx_->Cpu().d_reg[7];
+		// no device is going to generate an interrupt on its own; don't spin, wait for external input
+		// (terminal) or for the user to break execution
+		std::this_thread::sleep_for(std::chrono::milliseconds(1));
+	}
+}
 
-	case cf::R_A0:	return impl_->ctx_->Cpu().a_reg[0];
-	case cf::R_A1:	return impl_->ctx_->Cpu().a_reg[1];
-	case cf::R_A2:	return impl_->ctx_->Cpu().a_reg[2];
-	case cf::R_A3:	return impl_->ctx_->Cpu().a_reg[3];
-	case cf::R_A4:	return impl_->ctx_->Cpu().a_reg[4];
-	case cf::R_A5:	return impl_->ctx_->Cpu().a_reg[5];
-	case cf::R_A6:	return impl_->ctx_->Cpu().a_reg[6];
-	case cf::R_A7:	return impl_->ctx_->Cpu().a_reg[7];
 
-	case cf::R_SP:	return impl_->ctx_->Cpu().a_reg[7];
+// CPU spins in a loop that doesn't change anything; skip its iterations in bulk till the next device event,
+// accounting for cycles and instructions they would take; devices observe no difference
+void Simulator::Impl::SkipIdleLoop(uint32 branch_addr)
+{
+	uint32 iter_cycles= 0;
+	uint32 iter_instr= 0;
+
+	if (!idle_loop_.Iteration(*ctx_, branch_addr, iter_cycles, iter_instr) || iter_cycles == 0)
+		return;
 
-	case cf::R_PC:	return impl_->ctx_->Cpu().pc;
-	case cf::R_SR:	return impl_->ctx_->Cpu().GetSR();
+	// unconditional breakpoints inside the loop would have already stopped the execution; conditional ones
+	// and tracepoints have to see every iteration though
+	if (breakpoints_.ConditionalInRange(ctx_->Cpu().pc, branch_addr) || tracepoints_.InRange(ctx_->Cpu().pc, branch_addr))
+		return;
 
-	case cf::R_USP:
-		return impl_->ctx_->Cpu().Supervisor() ? impl_->ctx_->Cpu().a_reg[7] : impl_->ctx_->Cpu().GetUSP();
+	// limit a single skip, so terminal input and other external changes are not postponed for long
+	const uint32 MAX_SKIP= 1000000;
+	const auto now= ctx_->CyclesTaken();
+	uint32 span= MAX_SKIP;
 
-	case cf::R_MBAR:	return impl_->ctx_->Cpu().mbar;
-	case cf::R_VBR:		return impl_->ctx_->Cpu().vbr;
+	for (auto& p : peripherals_)
+	{
+		uint32 at= 0;
+		if (p.DoNextEvent(*ctx_, EventScope::Any, at))
+		{
+			uint32 d= static_cast<int32>(at - now) > 0 ? at - now : 0;
+			if (d < span)
+				span = d;
+		}
 	}
-	ASSERT(false);
-	return 0;
+
+	// other cores may change memory loop is polling; they catch up at the barrier
+	if (cores_.Active())
+		span = std::min(span, CyclesToBarrier());
+
+	// devices are updated after each iteration; the last skipped one has to end before next event is due
+	if (span == 0)
+		return;
+
+	auto count= (span - 1) / iter_cycles;
+	if (count == 0)
+		return;
+
+	ctx_->SkipCycles(count * iter_cycles, count * iter_instr);
+	idle_loop_.Rebase(*ctx_);
 }
 
 
-void Simulator::SetRegister(cf::Register reg, cf::uint32 value)
-{
-	switch (reg)
+namespace {
+	cf::uint32 GetCpuRegister(const CPU& cpu, cf::Register reg)
 	{
-	case cf::R_D0:	impl_->ctx_->Cpu().d_reg[0] = value; break;
-	case cf::R_D1:	impl_->ctx_->Cpu().d_reg[1] = value; break;
-	case cf::R_D2:	impl_->ctx_->Cpu().d_reg[2] = value; break;
-	case cf::R_D3:	impl_->ctx_->Cpu().d_reg[3] = value; break;
-	case cf::R_D4:	impl_->ctx_->Cpu().d_reg[4] = value; break;
-	case cf::R_D5:	impl_->ctx_->Cpu().d_reg[5] = value; break;
-	case cf::R_D6:	impl_->ctx_->Cpu().d_reg[6] = value; break;
-	case cf::R_D7:	impl_->ctx_->Cpu().d_reg[7] = value; break;
+		switch (reg)
+		{
+		case cf::R_D0:	return cpu.d_reg[0];
+		case cf::R_D1:	return cpu.d_reg[1];
+		case cf::R_D2:	return cpu.d_reg[2];
+		case cf::R_D3:	return cpu.d_reg[3];
+		case cf::R_D4:	return cpu.d_reg[4];
+		case cf::R_D5:	return cpu.d_reg[5];
+		case cf::R_D6:	return cpu.d_reg[6];
+		case cf::R_D7:	return cpu.d_reg[7];
+
+		case cf::R_A0:	return cpu.a_reg[0];
+		case cf::R_A1:	return cpu.a_reg[1];
+		case cf::R_A2:	return cpu.a_reg[2];
+		case cf::R_A3:	return cpu.a_reg[3];
+		case cf::R_A4:	return cpu.a_reg[4];
+		case cf::R_A5:	return cpu.a_reg[5];
+		case cf::R_A6:	return cpu.a_reg[6];
+		case cf::R_A7:	return cpu.a_reg[7];
+
+		case cf::R_SP:	return cpu.a_reg[7];
+
+		case cf::R_PC:	return cpu.pc;
+		case cf::R_SR:	return cpu.GetSR();
+		case cf::R_CCR:	return cpu.GetSR() & 0xff;
+
+		case cf::R_USP:
+			return cpu.Supervisor() ? cpu.a_reg[7] : cpu.GetUSP();
+
+		case cf::R_MBAR:	return cpu.mbar;
+		case cf::R_VBR:		return cpu.vbr;
+		}
+		ASSERT(false);
+		return 0;
+	}
+}
 
-	case cf::R_A0:	impl_->ctx_->Cpu().a_reg[0] = value; break;
-	case cf::R_A1:	impl_->ctx_->Cpu().a_reg[1] = value; break;
-	case cf::R_A2:	impl_->ctx_->Cpu().a_reg[2] = value; break;
-	case cf::R_A3:	impl_->ctx_->Cpu().a_reg[3] = value; break;
-	case cf::R_A4:	impl_->ctx_->Cpu().a_reg[4] = value; break;
-	case cf::R_A5:	impl_->ctx_->Cpu().a_reg[5] = value; break;
-	case cf::R_A6:	impl_->ctx_->Cpu().a_reg[6] = value; break;
-	case cf::R_A7:	impl_->ctx_->Cpu().a_reg[7] = value; break;
 
-	case cf::R_PC:	impl_->ctx_->Cpu().pc = value; break;
-	case cf::R_SR:	impl_->ctx_->Cpu().SetSR(cf::uint16(value)); break;
+cf::uint32 Simulator::GetRegister(cf::Register reg) const
+{
+	return GetCpuRegister(impl_->ctx_->Cpu(), reg);
+}
 
-	case cf::R_MBAR:impl_->ctx_->Cpu().mbar = value & CPU::MBAR_ADDR_MASK; break;
-	case cf::R_VBR:	impl_->ctx_->Cpu().vbr = value; break;
 
-	default:
-		ASSERT(false);
-		break;
+void Simulator::SetCores(int count, cf::uint32 quantum, int interrupt_level)
+{
+	if (impl_->status_ == SIM_IS_RUNNING)
+		throw LogicError("Cores cannot be changed while simulator is running in " __FUNCTION__);
+
+	impl_->cores_.Configure(count, quantum, interrupt_level);
+	impl_->cores_.Reset(*impl_->ctx_);
+}
+
+
+int Simulator::GetCoreCount() const
+{
+	return impl_->cores_.Cores();
+}
+
+
+cf::uint32 Simulator::GetCoreRegister(int core, cf::Register reg) const
+{
+	if (core == 0)
+		return GetRegister(reg);
+
+	if (impl_->status_ == SIM_IS_RUNNING)
+		throw LogicError("Registers of other cores cannot be read while simulator is running in " __FUNCTION__);
+
+	if (core < 0 || core >= impl_->cores_.Cores())
+		throw RunTimeError("No such core " __FUNCTION__);
+
+	return GetCpuRegister(impl_->cores_.Core(core).Cpu(), reg);
+}
+
+
+namespace {
+	void SetCpuRegister(CPU& cpu, cf::Register reg, cf::uint32 value)
+	{
+		switch (reg)
+		{
+		case cf::R_D0:	cpu.d_reg[0] = value; break;
+		case cf::R_D1:	cpu.d_reg[1] = value; break;
+		case cf::R_D2:	cpu.d_reg[2] = value; break;
+		case cf::R_D3:	cpu.d_reg[3] = value; break;
+		case cf::R_D4:	cpu.d_reg[4] = value; break;
+		case cf::R_D5:	cpu.d_reg[5] = value; break;
+		case cf::R_D6:	cpu.d_reg[6] = value; break;
+		case cf::R_D7:	cpu.d_reg[7] = value; break;
+
+		case cf::R_A0:	cpu.a_reg[0] = value; break;
+		case cf::R_A1:	cpu.a_reg[1] = value; break;
+		case cf::R_A2:	cpu.a_reg[2] = value; break;
+		case cf::R_A3:	cpu.a_reg[3] = value; break;
+		case cf::R_A4:	cpu.a_reg[4] = value; break;
+		case cf::R_A5:	cpu.a_reg[5] = value; break;
+		case cf::R_A6:	cpu.a_reg[6] = value; break;
+		case cf::R_A7:	cpu.a_reg[7] = value; break;
+
+		case cf::R_PC:	cpu.pc = value; break;
+		case cf::R_SR:	cpu.SetSR(cf::uint16(value)); break;
+		case cf::R_CCR:	cpu.SetSR(cf::uint16((cpu.GetSR() & 0xff00) | (value & 0xff))); break;	// system byte stays
+
+		case cf::R_MBAR:cpu.mbar = value & CPU::MBAR_ADDR_MASK; break;
+		case cf::R_VBR:	cpu.vbr = value; break;
+
+		default:
+			ASSERT(false);
+			break;
+		}
 	}
+}
+
+
+void Simulator::SetRegister(cf::Register reg, cf::uint32 value)
+{
+	SetCpuRegister(impl_->ctx_->Cpu(), reg, value);
 
 	impl_->SendUpdate(cf::E_REGISTER);
 }
 
 
+void Simulator::GetRegisters(const cf::Register* regs, cf::uint32* values, size_t count) const
+{
+	const CPU& cpu= impl_->ctx_->Cpu();
+
+	for (size_t i= 0; i < count; ++i)
+		values[i] = GetCpuRegister(cpu, regs[i]);
+}
+
+
+void Simulator::SetRegisters(const cf::Register* regs, const cf::uint32* values, size_t count)
+{
+	CPU& cpu= impl_->ctx_->Cpu();
+
+	for (size_t i= 0; i < count; ++i)
+		SetCpuRegister(cpu, regs[i], values[i]);
+
+	if (count > 0)
+		impl_->SendUpdate(cf::E_REGISTER);
+}
+
+
 void Simulator::SetRegister(cf::Register reg, cf::uint32 add, cf::uint32 remove)
 {
 	cf::uint32 r= GetRegister(reg);
@@ -737,6 +1966,104 @@ void Simulator::SetEventCallback(const std::function<void (cf::Event ev, const E
 }
 
 
+void Simulator::DrainDeviceEvents(const std::function<void (const EventArgs& params)>& fn)
+{
+	impl_->device_events_.Drain([&](size_t device, cf::DeviceAccess access, uint32 param)
+	{
+		EventArgs args(param, &impl_->peripherals_[device], access);
+		fn(args);
+	});
+}
+
+
+void Simulator::SetSnapshotInterval(cf::uint32 instructions)
+{
+	impl_->snapshot_interval_ = instructions;
+	impl_->ResizeSnapshot();
+}
+
+
+void Simulator::WatchMemory(cf::uint32 address, cf::uint32 length)
+{
+	impl_->watched_.push_back(std::make_pair(address, length));
+	impl_->ResizeSnapshot();
+}
+
+
+void Simulator::ClearWatchedMemory()
+{
+	impl_->watched_.clear();
+	impl_->ResizeSnapshot();
+}
+
+
+bool Simulator::GetSnapshot(CpuSnapshot& cpu, std::vector<cf::uint8>* memory) const
+{
+	std::vector<uint32> data(impl_->snapshot_.Size());
+	if (data.empty() || !impl_->snapshot_.Read(data.data()))
+		return false;
+
+	memcpy(&cpu, data.data(), sizeof(cpu));
+
+	if (memory)
+	{
+		memory->clear();
+		auto src= reinterpret_cast<const uint8*>(data.data() + Impl::SNAPSHOT_CPU_WORDS);
+		for (auto& range : impl_->watched_)
+		{
+			memory->insert(memory->end(), src, src + range.second);
+			src += (range.second + 3) & ~3;
+		}
+	}
+
+	return true;
+}
+
+
+void Simulator::Impl::ResizeSnapshot()
+{
+	if (status_ == SIM_IS_RUNNING)
+		throw LogicError("Snapshot cannot be reconfigured while simulator is running in " __FUNCTION__);
+
+	size_t words= SNAPSHOT_CPU_WORDS;
+	for (auto& range : watched_)
+		words += (range.second + 3) / 4;
+
+	snapshot_data_.assign(words, 0);
+	snapshot_.Resize(snapshot_interval_ ? words : 0);
+	snapshot_countdown_ = snapshot_interval_;
+}
+
+
+// execution thread: copy registers and watched memory for readers
+void Simulator::Impl::PublishSnapshot()
+{
+	snapshot_countdown_ = snapshot_interval_;
+
+	CpuSnapshot cpu;
+	auto& regs= ctx_->Cpu();
+	std::copy(regs.d_reg, regs.d_reg + 8, cpu.d_reg);
+	std::copy(regs.a_reg, regs.a_reg + 8, cpu.a_reg);
+	cpu.pc = regs.pc;
+	cpu.sr = regs.GetSR();
+	auto stacks= regs.GetStackPointers();
+	cpu.usp = stacks.first;
+	cpu.ssp = stacks.second;
+	cpu.cycles = ctx_->CyclesTaken();
+	cpu.instructions = ctx_->ExecutedInstructions();
+	memcpy(snapshot_data_.data(), &cpu, sizeof(cpu));
+
+	auto dest= reinterpret_cast<uint8*>(snapshot_data_.data() + SNAPSHOT_CPU_WORDS);
+	for (auto& range : watched_)
+	{
+		ctx_->ReadMemory(dest, range.first, range.second);
+		dest += (range.second + 3) & ~3;
+	}
+
+	snapshot_.Write(snapshot_data_.data());
+}
+
+
 bool Simulator::GetFlag(cf::Flag flag) const
 {
 	switch (flag)
@@ -823,34 +2150,140 @@ void Simulator::ClearMemory()
 
 void Simulator::SetSimulatorCallback(const PeripheralCallback& io)
 {
-	impl_->ctx_->SetSimulatorCallback(io);
+	impl_->simulator_io_ = io;
+}
+
+
+void Simulator::SetSemihostingRoot(const wchar_t* dir)
+{
+	if (impl_->status_ == SIM_IS_RUNNING)
+		throw LogicError("Semihosting root cannot be changed while simulator is running in " __FUNCTION__);
+
+	impl_->semihosting_.SetRoot(dir != nullptr ? Path(dir) : Path());
 }
 
 
 cf::uint32 Simulator::GetSimulatorIOArea() const
 {
-	return impl_->ctx_->GetSimulatorIOArea();
+	return impl_->ctx_->GetSimulatorIOArea();
+}
+
+
+void Simulator::SetNativeMonitor(bool enable)
+{
+	if (enable)
+		impl_->ctx_->SetTrapHandler(15, &NativeMonitorCall);
+	else
+		impl_->ctx_->SetTrapHandler(15, nullptr);
+}
+
+
+void Simulator::SetExceptionCallback(const ExceptionCallback& ex)
+{
+	impl_->ctx_->SetExceptionCallback(ex);
+}
+
+
+void Simulator::SetTempBreakpoint(uint32 address)
+{
+	impl_->breakpoints_.Set(address, cf::BPT_TEMP_EXEC);
+}
+
+
+void Simulator::SetBreakpoint(uint32 address, bool set)
+{
+	if (set)
+	{
+		impl_->breakpoints_.Set(address, cf::BPT_EXECUTE);
+		impl_->breakpoints_.SetCondition(address, nullptr, 0);
+	}
+	else
+		impl_->breakpoints_.Remove(address, cf::BPT_EXECUTE);
+}
+
+
+void Simulator::SetConditionalBreakpoint(uint32 address, const std::string& condition, cf::uint32 hit_count)
+{
+	// compile first, so syntax error leaves breakpoints intact
+	std::shared_ptr<BreakpointCondition> expr;
+	if (!condition.empty())
+		expr = std::make_shared<BreakpointCondition>(condition);
+
+	impl_->breakpoints_.Set(address, cf::BPT_EXECUTE);
+	impl_->breakpoints_.SetCondition(address, expr, hit_count);
+}
+
+
+cf::uint64 Simulator::GetBreakpointHits(uint32 address) const
+{
+	return impl_->breakpoints_.Hits(address);
+}
+
+
+void Simulator::SetTracepoint(uint32 address, const std::vector<std::string>& expressions, const std::string& condition)
+{
+	if (impl_->status_ == SIM_IS_RUNNING)
+		throw LogicError("Tracepoints cannot be changed while simulator is running in " __FUNCTION__);
+
+	std::shared_ptr<BreakpointCondition> expr;
+	if (!condition.empty())
+		expr = std::make_shared<BreakpointCondition>(condition);
+
+	impl_->tracepoints_.Set(address, expressions, expr);
+}
+
+
+void Simulator::RemoveTracepoint(uint32 address)
+{
+	if (impl_->status_ == SIM_IS_RUNNING)
+		throw LogicError("Tracepoints cannot be changed while simulator is running in " __FUNCTION__);
+
+	impl_->tracepoints_.Remove(address);
+}
+
+
+void Simulator::ClearAllTracepoints()
+{
+	if (impl_->status_ == SIM_IS_RUNNING)
+		throw LogicError("Tracepoints cannot be changed while simulator is running in " __FUNCTION__);
+
+	impl_->tracepoints_.ClearAll();
+}
+
+
+size_t Simulator::DrainTraceRecords(const std::function<void (const TraceRecord& rec)>& fn)
+{
+	return impl_->tracepoints_.Drain(fn);
 }
 
 
-void Simulator::SetExceptionCallback(const ExceptionCallback& ex)
+std::string Simulator::FormatTraceRecord(const TraceRecord& rec) const
 {
-	impl_->ctx_->SetExceptionCallback(ex);
+	return impl_->tracepoints_.Format(rec);
 }
 
 
-void Simulator::SetTempBreakpoint(uint32 address)
+size_t Simulator::SaveTraceRecords(const wchar_t* path, bool append)
 {
-	impl_->breakpoints_.Set(address, cf::BPT_TEMP_EXEC);
+	std::ofstream out(path, append ? std::ios::out | std::ios::app : std::ios::out | std::ios::trunc);
+	if (!out)
+		throw RunTimeError("Cannot open trace file in " __FUNCTION__);
+
+	auto count= impl_->tracepoints_.Drain([&](const TraceRecord& rec)
+	{
+		out << impl_->tracepoints_.Format(rec) << '\n';
+	});
+
+	if (!out)
+		throw RunTimeError("Error writing trace file in " __FUNCTION__);
+
+	return count;
 }
 
 
-void Simulator::SetBreakpoint(uint32 address, bool set)
+cf::uint64 Simulator::GetDroppedTraceRecords() const
 {
-	if (set)
-		impl_->breakpoints_.Set(address, cf::BPT_EXECUTE);
-	else
-		impl_->breakpoints_.Remove(address, cf::BPT_EXECUTE);
+	return impl_->tracepoints_.Dropped();
 }
 
 
@@ -879,6 +2312,51 @@ void Simulator::ClearAllBreakpoints()
 }
 
 
+void Simulator::SetWatchpoint(uint32 address, cf::uint32 length, bool set)
+{
+	if (impl_->status_ == SIM_IS_RUNNING)
+		throw LogicError("Watchpoints cannot be changed while simulator is running in " __FUNCTION__);
+
+	auto& watchpoints= impl_->watchpoints_;
+	auto it= watchpoints.find(address);
+	if (it != watchpoints.end())
+	{
+		impl_->ctx_->SetWriteWatch(&*it, 0, 0, nullptr);
+		watchpoints.erase(it);
+	}
+
+	if (!set || length == 0)
+		return;
+
+	// map entry serves as an owner of the write watch
+	auto& entry= *watchpoints.insert(std::make_pair(address, length)).first;
+	auto impl= impl_;
+	impl_->ctx_->SetWriteWatch(&entry, address, length, [impl](uint32 addr, int size)
+	{
+		// only program writes count, not those made by clients
+		if (impl->status_ == SIM_IS_RUNNING)
+		{
+			impl->watch_hit_ = true;
+			impl->watch_address_ = addr;
+		}
+	});
+}
+
+
+void Simulator::ClearAllWatchpoints()
+{
+	while (!impl_->watchpoints_.empty())
+		SetWatchpoint(impl_->watchpoints_.begin()->first, 0, false);
+}
+
+
+bool Simulator::GetWatchpointHit(cf::uint32& address) const
+{
+	address = impl_->watch_address_;
+	return impl_->watch_hit_;
+}
+
+
 std::vector<uint32> Simulator::GetAllBreakpoints() const
 {
 	std::vector<uint32> v;
@@ -957,13 +2435,18 @@ PeripheralDevice* Simulator::Impl::AddPeripheral(const char* category, const cha
 
 	ctx_->SetICM(icms);
 
+	device_events_.Resize(peripherals_.size());
+
 	return peripheral;
 }
 
 
 // find peripheral mapped into 'addr' and carry on read/write
-bool Simulator::Impl::PeripheralsIO(uint32 addr, int access_size, uint32& ret_val, bool read)
+bool Simulator::Impl::PeripheralsIO(Context& ctx, uint32 addr, int access_size, uint32& ret_val, bool read)
 {
+	// devices are shared by all cores; they are mapped at core 0's MBAR
+	auto lock= cores_.LockIO();
+
 	auto mbar= ctx_->Cpu().mbar;
 	if (addr < mbar)
 		return false;
@@ -980,17 +2463,23 @@ bool Simulator::Impl::PeripheralsIO(uint32 addr, int access_size, uint32& ret_va
 			TRACE("Peripheral IO: addr %x, dev %d, port %x, read: %d", addr, int(dev_index), offset, int(read));
 
 			if (read)
-				ret_val = device.DoRead(*ctx_, offset, access_size);
+			{
+				ret_val = device.DoRead(ctx, offset, access_size);
+				if (device.DoReadHasSideEffects(offset))
+					ctx.NoteSideEffect();
+			}
 			else
-				device.DoWrite(*ctx_, offset, access_size, ret_val);
+				device.DoWrite(ctx, offset, access_size, ret_val);
 
 			if (read)
 				TRACE(" val read: $%x\n", int(ret_val));
 			else
 				TRACE(" val written: $%x\n", int(ret_val));
 
+			// don't call the client here; queue event, and let client know if it needs to drain the queue
 			if (device.NotifyClient())
-				SendUpdate(cf::E_DEVICE_IO, addr, &device, read ? cf::DeviceAccess::Read : cf::DeviceAccess::Write);
+				if (device_events_.Post(dev_index, read ? cf::DeviceAccess::Read : cf::DeviceAccess::Write, addr))
+					SendUpdate(cf::E_DEVICE_EVENTS);
 
 			return true;
 		}
@@ -1000,6 +2489,77 @@ bool Simulator::Impl::PeripheralsIO(uint32 addr, int access_size, uint32& ret_va
 }
 
 
+bool Simulator::Impl::SimulatorIO(Context& ctx, uint32 addr, int access_size, uint32& ret_val, bool read)
+{
+	// semihosting, counters and profiling are serviced by the simulator; remaining ports are client's responsibility
+	auto port= static_cast<cf::SimPort>(addr - ctx.GetSimulatorIOArea());
+	if (cores_.SimulatorIO(0, ctx, port, access_size, ret_val, read))
+		return true;
+
+	auto lock= cores_.LockIO();
+
+	switch (port)
+	{
+	case cf::SimPort::SEMIHOST:
+	case cf::SimPort::CYCLES:
+	case cf::SimPort::CYCLES_HI:
+	case cf::SimPort::INSTRUCTIONS:
+	case cf::SimPort::INSTRUCTIONS_HI:
+	case cf::SimPort::PROFILE_BEGIN:
+	case cf::SimPort::PROFILE_END:
+		if (access_size != 4)
+			return false;
+
+		if (read)
+		{
+			switch (port)
+			{
+			case cf::SimPort::CYCLES:
+				cycles_hi_latch_ = static_cast<uint32>(ctx.TotalCycles() >> 32);
+				ret_val = static_cast<uint32>(ctx.TotalCycles());
+				break;
+			case cf::SimPort::CYCLES_HI:
+				ret_val = cycles_hi_latch_;
+				break;
+			case cf::SimPort::INSTRUCTIONS:
+				instructions_hi_latch_ = static_cast<uint32>(ctx.TotalInstructions() >> 32);
+				ret_val = static_cast<uint32>(ctx.TotalInstructions());
+				break;
+			case cf::SimPort::INSTRUCTIONS_HI:
+				ret_val = instructions_hi_latch_;
+				break;
+			default:
+				ret_val = 0;
+				break;
+			}
+		}
+		else
+		{
+			switch (port)
+			{
+			case cf::SimPort::SEMIHOST:
+				semihosting_.Request(ctx, ret_val);
+				break;
+			case cf::SimPort::PROFILE_BEGIN:
+				profile_.Begin(ctx, ret_val);
+				break;
+			case cf::SimPort::PROFILE_END:
+				profile_.End(ctx, ret_val);
+				break;
+			default:
+				break;	// counters are read-only
+			}
+		}
+		return true;
+
+	default:
+		break;
+	}
+
+	return simulator_io_ != nullptr && simulator_io_(addr, access_size, ret_val, read);
+}
+
+
 // how to handle exception 'ex'
 void Simulator::ExceptionHandling(CpuExceptions ex, bool stop)
 {
@@ -1025,6 +2585,342 @@ void Simulator::ZeroStats()	// clear cycle and instruction counter
 }
 
 
+std::vector<Simulator::ProfileRegion> Simulator::GetProfileRegions() const
+{
+	if (impl_->status_ == SIM_IS_RUNNING)
+		throw LogicError("Profile cannot be read while simulator is running in " __FUNCTION__);
+
+	return impl_->profile_.Get();
+}
+
+
+std::string Simulator::GetProfileReport() const
+{
+	auto regions= GetProfileRegions();
+	if (regions.empty())
+		return std::string();
+
+	std::ostringstream ost;
+	ost << boost::format("%-24s %10s %14s %14s %14s %18s\n") % "Region" % "Count" % "Min" % "Avg" % "Max" % "Total";
+
+	for (auto& r : regions)
+	{
+		if (r.count == 0)
+		{
+			ost << boost::format("%-24s %10d\n") % r.name % 0;
+			continue;
+		}
+
+		ost << boost::format("%-24s %10d %14d %14d %14d %18d\n") % r.name % r.count % r.min_cycles % (r.total_cycles / r.count) % r.max_cycles % r.total_cycles;
+	}
+
+	return ost.str();
+}
+
+
+void Simulator::ClearProfileRegions()
+{
+	if (impl_->status_ == SIM_IS_RUNNING)
+		throw LogicError("Profile cannot be cleared while simulator is running in " __FUNCTION__);
+
+	impl_->profile_.Clear();
+}
+
+
+void Simulator::EnableInterruptLatency(bool enable)
+{
+	if (impl_->status_ == SIM_IS_RUNNING)
+		throw LogicError("Interrupt latency measurement cannot be changed while simulator is running in " __FUNCTION__);
+
+	impl_->irq_latency_.Restart(impl_->ctx_->Cpu().InterruptLevel());
+	impl_->ctx_->SetInterruptObserver(enable ? &impl_->irq_latency_ : nullptr);
+}
+
+
+std::vector<Simulator::InterruptLatency> Simulator::GetInterruptLatency() const
+{
+	if (impl_->status_ == SIM_IS_RUNNING)
+		throw LogicError("Interrupt latency cannot be read while simulator is running in " __FUNCTION__);
+
+	return impl_->irq_latency_.Get();
+}
+
+
+std::string Simulator::GetInterruptLatencyReport() const
+{
+	auto sources= GetInterruptLatency();
+	if (sources.empty())
+		return std::string();
+
+	std::ostringstream ost;
+	ost << boost::format("%-8s %10s %10s %10s %12s %12s %12s %12s %12s\n") % "Source" % "Asserted" % "Withdrawn" % "Serviced" % "Min" % "Avg" % "Max" % "Avg masked" % "Avg service";
+
+	for (auto& s : sources)
+	{
+		auto& l= s.latency;
+		if (l.count == 0)
+		{
+			ost << boost::format("%-8d %10d %10d %10d\n") % s.source % s.asserted % s.withdrawn % 0;
+			continue;
+		}
+
+		ost << boost::format("%-8d %10d %10d %10d %12d %12d %12d %12d %12d\n") % s.source % s.asserted % s.withdrawn % l.count %
+			l.min_cycles % (l.total_cycles / l.count) % l.max_cycles % (s.masked.total_cycles / l.count) %
+			(s.service.count ? s.service.total_cycles / s.service.count : 0);
+	}
+
+	// latency histograms, nonempty buckets only
+	for (auto& s : sources)
+	{
+		if (s.latency.count == 0)
+			continue;
+
+		ost << boost::format("\nSource %d latency:\n") % s.source;
+		for (size_t i= 0; i < s.latency.buckets.size(); ++i)
+		{
+			if (s.latency.buckets[i] == 0)
+				continue;
+
+			if (i == 0)
+				ost << boost::format("%24s %10d\n") % "0" % s.latency.buckets[i];
+			else if (i == s.latency.buckets.size() - 1)
+				ost << boost::format("%24s %10d\n") % (boost::format(">= %d") % (uint64(1) << (i - 1))).str() % s.latency.buckets[i];
+			else
+				ost << boost::format("%24s %10d\n") % (boost::format("%d..%d") % (uint64(1) << (i - 1)) % ((uint64(1) << i) - 1)).str() % s.latency.buckets[i];
+		}
+	}
+
+	return ost.str();
+}
+
+
+void Simulator::ClearInterruptLatency()
+{
+	if (impl_->status_ == SIM_IS_RUNNING)
+		throw LogicError("Interrupt latency cannot be cleared while simulator is running in " __FUNCTION__);
+
+	impl_->irq_latency_.Clear();
+}
+
+
+void Simulator::EnableStackTracking(bool enable)
+{
+	if (impl_->status_ == SIM_IS_RUNNING)
+		throw LogicError("Stack tracking cannot be changed while simulator is running in " __FUNCTION__);
+
+	impl_->ctx_->SetStackObserver(enable ? &impl_->stack_usage_ : nullptr);
+}
+
+
+void Simulator::AddTaskStack(const std::string& name, cf::uint32 base, cf::uint32 size)
+{
+	if (impl_->status_ == SIM_IS_RUNNING)
+		throw LogicError("Task stacks cannot be changed while simulator is running in " __FUNCTION__);
+
+	impl_->stack_usage_.AddTask(name, base, size);
+}
+
+
+void Simulator::RemoveTaskStacks()
+{
+	if (impl_->status_ == SIM_IS_RUNNING)
+		throw LogicError("Task stacks cannot be changed while simulator is running in " __FUNCTION__);
+
+	impl_->stack_usage_.RemoveTasks();
+}
+
+
+std::vector<Simulator::StackUsage> Simulator::GetStackUsage() const
+{
+	if (impl_->status_ == SIM_IS_RUNNING)
+		throw LogicError("Stack usage cannot be read while simulator is running in " __FUNCTION__);
+
+	return impl_->stack_usage_.Get();
+}
+
+
+std::string Simulator::GetStackUsageReport() const
+{
+	auto stacks= GetStackUsage();
+
+	std::ostringstream ost;
+	ost << boost::format("%-24s %-19s %10s %10s %10s\n") % "Stack" % "Area" % "Lowest" % "Used" % "PC";
+
+	for (auto& s : stacks)
+	{
+		auto area= s.size ? (boost::format("$%08X-$%08X") % s.base % (s.base + s.size - 1)).str() : std::string();
+		if (s.used)
+			ost << boost::format("%-24s %-19s  $%08X %10d  $%08X\n") % s.name % area % s.lowest % (s.top - s.lowest) % s.pc;
+		else
+			ost << boost::format("%-24s %-19s %10s\n") % s.name % area % "-";
+	}
+
+	return ost.str();
+}
+
+
+void Simulator::ClearStackUsage()
+{
+	if (impl_->status_ == SIM_IS_RUNNING)
+		throw LogicError("Stack usage cannot be cleared while simulator is running in " __FUNCTION__);
+
+	impl_->stack_usage_.Clear();
+}
+
+
+void Simulator::EnableHeatMap(bool enable, cf::uint32 line_size)
+{
+	if (impl_->status_ == SIM_IS_RUNNING)
+		throw LogicError("Heat map cannot be changed while simulator is running in " __FUNCTION__);
+
+	if (line_size == 0 || (line_size & (line_size - 1)) != 0)
+		throw LogicError("Heat map line size has to be a power of 2 in " __FUNCTION__);
+
+	impl_->heat_map_.SetLineSize(line_size);
+	impl_->heat_map_enabled_ = enable;
+}
+
+
+std::vector<Simulator::HeatMapBlock> Simulator::GetHeatMap() const
+{
+	if (impl_->status_ == SIM_IS_RUNNING)
+		throw LogicError("Heat map cannot be read while simulator is running in " __FUNCTION__);
+
+	return impl_->heat_map_.GetBlocks();
+}
+
+
+std::vector<Simulator::MisalignedAccess> Simulator::GetMisalignedAccesses() const
+{
+	if (impl_->status_ == SIM_IS_RUNNING)
+		throw LogicError("Heat map cannot be read while simulator is running in " __FUNCTION__);
+
+	return impl_->heat_map_.GetMisaligned();
+}
+
+
+std::string Simulator::GetHeatMapReport(size_t top_count) const
+{
+	auto blocks= GetHeatMap();
+	auto misaligned= GetMisalignedAccesses();
+
+	std::ostringstream ost;
+
+	uint64 total= 0;
+	for (auto& b : blocks)
+		total += b.fetches + b.reads + b.writes;
+
+	ost << boost::format("Hottest %d-byte blocks:\n") % impl_->heat_map_.LineSize();
+	ost << boost::format("%-10s %14s %14s %14s %8s\n") % "Address" % "Fetches" % "Reads" % "Writes" % "Share";
+
+	auto hot= [](const HeatMapBlock& b) { return b.fetches + b.reads + b.writes; };
+	std::sort(blocks.begin(), blocks.end(), [&](const HeatMapBlock& a, const HeatMapBlock& b) { return hot(a) > hot(b) || (hot(a) == hot(b) && a.address < b.address); });
+	if (blocks.size() > top_count)
+		blocks.resize(top_count);
+
+	for (auto& b : blocks)
+		ost << boost::format("$%08X  %14d %14d %14d %7.2f%%\n") % b.address % b.fetches % b.reads % b.writes % (100.0 * hot(b) / total);
+
+	ost << "\nMisaligned accesses:\n";
+	ost << boost::format("%-10s %14s\n") % "PC" % "Count";
+
+	if (misaligned.size() > top_count)
+		misaligned.resize(top_count);
+
+	for (auto& m : misaligned)
+		ost << boost::format("$%08X  %14d\n") % m.pc % m.count;
+
+	return ost.str();
+}
+
+
+void Simulator::ClearHeatMap()
+{
+	if (impl_->status_ == SIM_IS_RUNNING)
+		throw LogicError("Heat map cannot be cleared while simulator is running in " __FUNCTION__);
+
+	impl_->heat_map_.Clear();
+}
+
+
+bool Simulator::HasCacheModel() const
+{
+	return impl_->caches_ != nullptr;
+}
+
+
+void Simulator::GetCacheStats(cf::CacheStats& icache, cf::CacheStats& dcache) const
+{
+	if (impl_->status_ == SIM_IS_RUNNING)
+		throw LogicError("Cache statistics cannot be read while simulator is running in " __FUNCTION__);
+
+	if (impl_->caches_)
+	{
+		icache = impl_->caches_->Instructions().Stats();
+		dcache = impl_->caches_->Data().Stats();
+	}
+	else
+		icache = dcache = cf::CacheStats();
+}
+
+
+namespace {
+	std::string HitRate(const cf::CacheStats& s)
+	{
+		if (s.accesses == 0)
+			return "-";
+		return (boost::format("%.2f%%") % (100.0 * (s.accesses - s.misses) / s.accesses)).str();
+	}
+}
+
+
+std::string Simulator::GetCacheReport() const
+{
+	if (!impl_->caches_)
+		return std::string();
+
+	cf::CacheStats icache, dcache;
+	GetCacheStats(icache, dcache);
+
+	std::ostringstream ost;
+	ost << boost::format("%-24s %14s %12s %10s %12s %12s %14s\n") % "Cache" % "Accesses" % "Misses" % "Hit rate" % "Write backs" % "Uncached" % "Cycles";
+
+	auto line= [&](const std::string& name, const cf::CacheStats& s)
+	{
+		ost << boost::format("%-24s %14d %12d %10s %12d %12d %14d\n") % name % s.accesses % s.misses % HitRate(s) % s.writebacks % s.uncached % s.cycles;
+	};
+
+	if (impl_->caches_->Instructions().Present())
+		line("Instruction", icache);
+	if (impl_->caches_->Data().Present())
+		line("Data", dcache);
+
+	auto regions= GetProfileRegions();
+	if (!regions.empty())
+	{
+		ost << boost::format("\n%-24s %10s %12s %12s %10s %12s %12s %10s\n") % "Region" % "Count" % "I-accesses" % "I-misses" % "I-hit" % "D-accesses" % "D-misses" % "D-hit";
+		for (auto& r : regions)
+			ost << boost::format("%-24s %10d %12d %12d %10s %12d %12d %10s\n") % r.name % r.count %
+				r.icache.accesses % r.icache.misses % HitRate(r.icache) % r.dcache.accesses % r.dcache.misses % HitRate(r.dcache);
+	}
+
+	return ost.str();
+}
+
+
+void Simulator::ClearCacheStats()
+{
+	if (impl_->status_ == SIM_IS_RUNNING)
+		throw LogicError("Cache statistics cannot be cleared while simulator is running in " __FUNCTION__);
+
+	if (impl_->caches_)
+	{
+		impl_->caches_->Instructions().ClearStats();
+		impl_->caches_->Data().ClearStats();
+	}
+}
+
+
 void Simulator::SetConfigDefaults(cf::Register reg, uint32 value)
 {
 	impl_->ctx_->Cpu().SetDefaults(reg, value);
@@ -1045,6 +2941,10 @@ void Simulator::LoadConfiguration(const wchar_t* cfg_file)
 	if (auto isa= config.get_optional<std::string>("ISA"))
 		default_isa = StringToISA(*isa);
 
+	// optional floating point unit
+	if (config.get<int>("FPU", 0) != 0)
+		default_isa = default_isa | ISA::FPU;
+
 	SetIsa(default_isa);
 
 	typedef HexNumber<unsigned int> Hex;
@@ -1080,6 +2980,47 @@ void Simulator::LoadConfiguration(const wchar_t* cfg_file)
 		CreateMemoryBank(p.first, base, size, bank++, access);
 	}
 
+	// multi-core boards; single core unless specified
+	{
+		auto cores= config.get_child_optional("Cores");
+		int count= cores ? cores->get<int>("count", 1) : 1;
+		unsigned int quantum= cores ? cores->get<unsigned int>("quantum", 1000) : 1000;
+		int level= cores ? cores->get<int>("interrupt_level", 6) : 6;
+		SetCores(count, quantum, level);
+	}
+
+	impl_->caches_.reset();
+	if (auto cache= config.get_child_optional("Cache"))
+	{
+		auto read= [&](const char* name) -> CacheConfig
+		{
+			CacheConfig c;
+			auto section= cache->get_child_optional(name);
+			if (!section)
+				return c;
+
+			c.size = section->get<Hex>("size", 0);
+			c.ways = section->get<unsigned int>("ways", c.ways);
+			c.line_size = section->get<unsigned int>("line_size", c.line_size);
+			c.always_enabled = section->get<int>("always_enabled", 0) != 0;
+			c.hit_cycles = section->get<unsigned int>("hit_cycles", c.hit_cycles);
+			c.miss_cycles = section->get<unsigned int>("miss_cycles", c.miss_cycles);
+			c.memory_cycles = section->get<unsigned int>("memory_cycles", c.memory_cycles);
+
+			auto policy= section->get<std::string>("write_policy", "cacr");
+			if (policy == "copy_back")
+				c.write_policy = CacheConfig::COPY_BACK;
+			else if (policy == "write_through")
+				c.write_policy = CacheConfig::WRITE_THROUGH;
+			else if (policy != "cacr")
+				throw std::exception((boost::format("Cache write policy '%s' not recognized") % policy).str().c_str());
+
+			return c;
+		};
+
+		impl_->caches_.reset(new CacheModel(read("Instruction"), read("Data")));
+	}
+
 	if (auto peripherals= config.get_child_optional("Peripherals"))
 	{
 		for (auto& p : *peripherals)
@@ -100,6 +100,10 @@ public:
 	cf::uint32 GetRegister(cf::Register reg) const;
 	void SetRegister(cf::Register reg, cf::uint32 value);
 	void SetRegister(cf::Register reg, cf::uint32 add, cf::uint32 remove);
+	// registers in bulk: values[i] is the value of regs[i]; they are set in the given order
+	// (SR before A7 if SR switches stacks), sending a single E_REGISTER event
+	void GetRegisters(const cf::Register* regs, cf::uint32* values, size_t count) const;
+	void SetRegisters(const cf::Register* regs, const cf::uint32* values, size_t count);
 
 	// condition flags
 	bool GetFlag(cf::Flag flag) const;
@@ -120,6 +124,11 @@ public:
 	// event callback to notify client about changes
 	void SetEventCallback(const std::function<void (cf::Event ev, const EventArgs& params /*cf::uint32 param*/)>& callback);
 
+	// device accesses made by running simulation are not reported directly; they are queued and client receives
+	// E_DEVICE_EVENTS when queue stops being empty; repeated accesses of the same kind to a device are coalesced;
+	// client drains queue at its own pace, receiving E_DEVICE_IO event args
+	void DrainDeviceEvents(const std::function<void (const EventArgs& params)>& fn);
+
 	// disassemble single instruction
 	DecodedInstruction DecodeInstruction(uint32 addr);
 
@@ -128,6 +137,15 @@ public:
 	void SetSimulatorCallback(const PeripheralCallback& io);
 	cf::uint32 GetSimulatorIOArea() const;
 
+	// perform monitor's TRAP #15 services natively instead of running monitor code (GetS, Sleep
+	// and RunAsSuper are still executed by the monitor); off by default: while it's on, every TRAP #15
+	// is intercepted, so it is only meant for programs running with the bundled monitor
+	void SetNativeMonitor(bool enable);
+
+	// host directory that semihosting requests (SimPort::SEMIHOST) can open files in; nullptr or empty
+	// string disables semihosting; files opened by guest are closed on reset
+	void SetSemihostingRoot(const wchar_t* dir);
+
 	// CPU exceptions
 	typedef std::function<bool (uint32 address, CpuExceptions vector, uint32 pc)> ExceptionCallback;
 	void SetExceptionCallback(const ExceptionCallback& ex);
@@ -140,6 +158,44 @@ public:
 	void ClearAllBreakpoints();
 	std::vector<uint32> GetAllBreakpoints() const;
 
+	// write watchpoints: execution stops (SIM_BREAKPOINT_HIT) after an instruction writes to RAM in
+	// [address, address + length); writes made by clients don't stop anything
+	void SetWatchpoint(uint32 address, cf::uint32 length, bool set);
+	void ClearAllWatchpoints();
+	// true if the last stop was caused by a watchpoint; 'address' receives the address written to
+	bool GetWatchpointHit(cf::uint32& address) const;
+
+	// conditional execution breakpoint: it stops only when 'condition' holds (empty condition always holds)
+	// and it has held at least 'hit_count' times; condition is compiled once and evaluated by the running
+	// simulator, syntax is described in BreakpointCondition.h, e.g. "D0 == 5 && (A1).L > $1000";
+	// throws RunTimeError on syntax errors; SetBreakpoint(address, true) makes breakpoint unconditional again
+	void SetConditionalBreakpoint(uint32 address, const std::string& condition, cf::uint32 hit_count= 0);
+	// how many times condition of a breakpoint has held so far
+	cf::uint64 GetBreakpointHits(uint32 address) const;
+
+	// tracepoints don't stop execution: when reached, and their optional condition holds, they capture values
+	// of up to MAX_TRACE_VALUES expressions (same syntax as breakpoint conditions, e.g. "D0", "(A1).W")
+	// into a lock-free buffer; records that don't fit in it are dropped and counted
+	enum { MAX_TRACE_VALUES= 8 };
+	struct TraceRecord
+	{
+		cf::uint64 cycles;		// total cycles when tracepoint was reached
+		cf::uint32 address;		// tracepoint
+		cf::uint32 count;		// number of values
+		cf::uint32 values[MAX_TRACE_VALUES];
+	};
+	// tracepoints can only be changed when simulation is not running; throws RunTimeError on syntax errors
+	void SetTracepoint(uint32 address, const std::vector<std::string>& expressions, const std::string& condition= std::string());
+	void RemoveTracepoint(uint32 address);
+	void ClearAllTracepoints();
+	// records can be drained from a single client thread, also while simulation is running; returns their count
+	size_t DrainTraceRecords(const std::function<void (const TraceRecord& rec)>& fn);
+	// single line of text: cycles, address, and expressions with their values
+	std::string FormatTraceRecord(const TraceRecord& rec) const;
+	// drain records into a text file
+	size_t SaveTraceRecords(const wchar_t* path, bool append);
+	cf::uint64 GetDroppedTraceRecords() const;
+
 	// set exception handling for exception 'ex':
 	// stop = true -> stop execution
 	// stop = false -> go to exception handler
@@ -151,9 +207,142 @@ public:
 	uint32 ExecutedInstructions() const;
 	void ZeroStats();	// clear cycle and instruciton counter
 
+	// code regions measured by guest program; it writes address of region's name to SimPort::PROFILE_BEGIN
+	// and SimPort::PROFILE_END; statistics are in simulated cycles and accumulate until cleared
+	struct ProfileRegion
+	{
+		std::string name;
+		cf::uint32 id;			// address of region's name
+		cf::uint64 count;		// completed measurements
+		cf::uint64 min_cycles;
+		cf::uint64 max_cycles;
+		cf::uint64 total_cycles;
+		cf::CacheStats icache;	// cache activity inside region; zero if there's no cache model
+		cf::CacheStats dcache;
+	};
+
+	// these are available when simulation is not running (after E_EXEC_STOPPED)
+	std::vector<ProfileRegion> GetProfileRegions() const;
+	std::string GetProfileReport() const;	// formatted table, empty if there are no regions
+	void ClearProfileRegions();
+
+	// interrupt latency per interrupt source, in simulated cycles; histograms use log2 buckets:
+	// bucket 0 counts zero cycles, bucket n counts [2^(n-1), 2^n), and the last one everything above
+	struct LatencyHistogram
+	{
+		cf::uint64 count;
+		cf::uint64 min_cycles;
+		cf::uint64 max_cycles;
+		cf::uint64 total_cycles;
+		std::vector<cf::uint64> buckets;
+	};
+
+	struct InterruptLatency
+	{
+		int source;
+		cf::uint64 asserted;		// requests raised by a device
+		cf::uint64 withdrawn;		// requests cleared by device before CPU accepted them
+		LatencyHistogram latency;	// from request till entering handler
+		LatencyHistogram masked;	// part of latency when request was held off by CPU's interrupt priority mask
+		LatencyHistogram service;	// from entering handler till CPU mask drops below request's level (RTE or SR write)
+	};
+
+	// measuring is off by default; statistics accumulate until cleared
+	void EnableInterruptLatency(bool enable);
+	// these are available when simulation is not running (after E_EXEC_STOPPED)
+	std::vector<InterruptLatency> GetInterruptLatency() const;
+	std::string GetInterruptLatencyReport() const;	// formatted table, empty if there were no interrupts
+	void ClearInterruptLatency();
+
+	// stack high-water marks: lowest A7 seen in supervisor and user mode, and in registered task stacks
+	struct StackUsage
+	{
+		std::string name;		// "SSP", "USP" or task stack name
+		cf::uint32 base;		// task stack area; 0 for SSP and USP
+		cf::uint32 size;
+		cf::uint32 top;			// initial stack pointer: end of task stack area, or highest A7 seen for SSP/USP
+		cf::uint32 lowest;		// high-water mark
+		cf::uint32 pc;			// address of instruction that moved A7 to the lowest point
+		bool used;				// false if A7 never pointed into this stack
+	};
+
+	// tracking is off by default; marks accumulate until cleared
+	void EnableStackTracking(bool enable);
+	void AddTaskStack(const std::string& name, cf::uint32 base, cf::uint32 size);
+	void RemoveTaskStacks();
+	// these are available when simulation is not running; SSP and USP come first, then task stacks
+	std::vector<StackUsage> GetStackUsage() const;
+	std::string GetStackUsageReport() const;
+	void ClearStackUsage();
+
+	// memory heat map: accesses made by executing program counted per block of 'line_size' bytes (cache line)
+	// in every memory bank; misaligned word and long word accesses are counted per instruction; idle loops
+	// skipped by the simulator are not counted
+	struct HeatMapBlock
+	{
+		cf::uint32 address;		// start of the block
+		cf::uint64 fetches;		// opcode and extension word reads
+		cf::uint64 reads;
+		cf::uint64 writes;
+	};
+
+	struct MisalignedAccess
+	{
+		cf::uint32 pc;			// address of instruction
+		cf::uint64 count;
+	};
+
+	// counting is off by default; counters accumulate until cleared
+	void EnableHeatMap(bool enable, cf::uint32 line_size= 16);
+	// these are available when simulation is not running
+	std::vector<HeatMapBlock> GetHeatMap() const;					// accessed blocks only, in address order
+	std::vector<MisalignedAccess> GetMisalignedAccesses() const;	// most frequent first
+	std::string GetHeatMapReport(size_t top_count= 20) const;		// hottest blocks and worst misaligned accesses
+	void ClearHeatMap();
+
+	// instruction and data cache model, configured in the board file (Cache section); caches are controlled
+	// by CACR and ACR0-3 (V4 layout); their hit and miss costs are added to the cycle counter
+	bool HasCacheModel() const;
+	// these are available when simulation is not running; statistics accumulate until cleared
+	void GetCacheStats(cf::CacheStats& icache, cf::CacheStats& dcache) const;
+	std::string GetCacheReport() const;		// caches and profile regions with hit rates; empty without caches
+	void ClearCacheStats();
+
+	// multi-core boards (Cores section of the board file): cores 1 and up share memory and peripherals with
+	// core 0, which is the one all other functions here refer to; each core runs on its own host thread, and
+	// all of them wait for each other every 'quantum' cycles; cross-core interrupts come at 'interrupt_level';
+	// other cores are held in reset till core 0 starts them (SimPort::CORE_START)
+	void SetCores(int count, cf::uint32 quantum, int interrupt_level);
+	int GetCoreCount() const;
+	// registers of any core; other cores can only be inspected when simulation is not running
+	cf::uint32 GetCoreRegister(int core, cf::Register reg) const;
+
 	// set default values for some MCU configuration registers (VBR, MBAR)
 	void SetConfigDefaults(cf::Register reg, uint32 value);
 
+	// CPU state published by the execution thread; it can be read while simulation is running
+	struct CpuSnapshot
+	{
+		cf::uint32 d_reg[8];
+		cf::uint32 a_reg[8];
+		cf::uint32 pc;
+		cf::uint32 sr;
+		cf::uint32 usp;
+		cf::uint32 ssp;
+		cf::uint32 cycles;
+		cf::uint32 instructions;
+	};
+
+	// publish snapshot every 'instructions' executed (0 turns publishing off); it is also published when execution
+	// stops; contents of watched memory ranges are copied along with registers; configure it before running
+	void SetSnapshotInterval(cf::uint32 instructions);
+	void WatchMemory(cf::uint32 address, cf::uint32 length);
+	void ClearWatchedMemory();
+
+	// latest published state; 'memory' (if given) receives contents of all watched ranges one after another;
+	// this call never pauses simulation; returns false if there's no snapshot yet
+	bool GetSnapshot(CpuSnapshot& cpu, std::vector<cf::uint8>* memory) const;
+
 private:
 	Simulator(const Simulator&);
 	Simulator& operator = (const Simulator&);
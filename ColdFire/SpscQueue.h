@@ -0,0 +1,62 @@
+/*-----------------------------------------------------------------------------
+	ColdFire Macro Assembler and Simulator
+
+	Copyright (C) 2007-2012 Mike Kowalski
+
+	See License.txt for more details
+-----------------------------------------------------------------------------*/
+
+#pragma once
+#include <atomic>
+#include <array>
+
+// Lock-free queue with fixed capacity for exactly one producer thread and one consumer thread.
+// Producer calls Push only, consumer calls Pop only; neither of them ever blocks.
+
+template<class T, size_t CAPACITY>
+class SpscQueue
+{
+	static_assert(CAPACITY > 0 && (CAPACITY & (CAPACITY - 1)) == 0, "SpscQueue capacity has to be a power of 2");
+
+public:
+	SpscQueue() : head_(0), tail_(0)
+	{}
+
+	// producer: returns false if queue is full
+	bool Push(const T& item)
+	{
+		auto tail= tail_.load(std::memory_order_relaxed);
+		if (tail - head_.load(std::memory_order_acquire) == CAPACITY)
+			return false;
+
+		items_[tail & (CAPACITY - 1)] = item;
+		tail_.store(tail + 1, std::memory_order_release);
+		return true;
+	}
+
+	// consumer: returns false if queue is empty
+	bool Pop(T& item)
+	{
+		auto head= head_.load(std::memory_order_relaxed);
+		if (head == tail_.load(std::memory_order_acquire))
+			return false;
+
+		item = items_[head & (CAPACITY - 1)];
+		head_.store(head + 1, std::memory_order_release);
+		return true;
+	}
+
+	// either side: snapshot only, may be outdated by the time it's returned
+	bool Empty() const
+	{
+		return head_.load(std::memory_order_acquire) == tail_.load(std::memory_order_acquire);
+	}
+
+private:
+	SpscQueue(const SpscQueue&);
+	SpscQueue& operator = (const SpscQueue&);
+
+	std::array<T, CAPACITY> items_;
+	std::atomic<size_t> head_;	// next item to pop; written by consumer
+	std::atomic<size_t> tail_;	// next free slot; written by producer
+};
@@ -101,7 +101,8 @@ enum Event
 	E_MEMORY,		// memory has been changed (from the outside of a simulator)
 	E_PROG_SET,		// program has been set
 	E_EXEC_STOPPED,	// state has changed, simulation is stopped
-	E_DEVICE_IO		// device has been read or written to
+	E_DEVICE_IO,	// device has been read or written to
+	E_DEVICE_EVENTS	// device accesses are queued, waiting to be drained by the client (Simulator::DrainDeviceEvents)
 };
 
 
@@ -110,7 +111,8 @@ enum class DeviceAccess
 {
 	Read,
 	Write,
-	Reset
+	Reset,
+	Refresh		// device asks client to update its view (display contents changed)
 };
 
 
@@ -148,6 +150,20 @@ private:
 };
 
 
+// cache model statistics (see Simulator::GetCacheStats)
+struct CacheStats
+{
+	CacheStats() : accesses(0), misses(0), writebacks(0), uncached(0), cycles(0)
+	{}
+
+	uint64 accesses;	// cacheable accesses
+	uint64 misses;		// cacheable accesses that missed; reads and copy-back writes fill a line
+	uint64 writebacks;	// dirty lines written back
+	uint64 uncached;	// accesses that bypassed the cache (disabled or cache-inhibited)
+	uint64 cycles;		// cycles added to the cycle counter
+};
+
+
 // Simulator I/O works by writing/reading simulator "ports"; following ports are defined:
 //
 enum class SimPort : uint32
@@ -166,7 +182,39 @@ enum class SimPort : uint32
 	WIDTH= 0x1c,			// terminal size
 	HEIGHT= 0x1e,
 	// other ports
-	RND_NUM= 0x20			// random number
+	RND_NUM= 0x20,			// random number
+	SEMIHOST= 0x24,			// write address of semihosting parameter block here to execute a request
+	// performance counters; reading low word latches high word, so it should be read first
+	CYCLES= 0x28,			// simulated cycles, low word
+	CYCLES_HI= 0x2c,
+	INSTRUCTIONS= 0x30,		// executed instructions, low word
+	INSTRUCTIONS_HI= 0x34,
+	// profiling; write address of NUL-terminated region name to begin/end measurement of that region
+	PROFILE_BEGIN= 0x38,
+	PROFILE_END= 0x3c,
+	// multi-core boards
+	CORE_ID= 0x40,			// index of the core reading it (0 - primary core)
+	CORE_COUNT= 0x44,		// number of cores
+	CORE_START= 0x48,		// write address of a start block: core index, initial PC, initial SSP (long words)
+	CORE_INTERRUPT= 0x4c	// write core index << 8 | vector to interrupt that core
+};
+
+
+// Semihosting (file I/O serviced by the host). Parameter block (long words):
+//   +0  operation (SemihostOp)
+//   +4  file handle (as returned by OPEN)
+//   +8  address of buffer or NUL-terminated file name
+//   +12 length of buffer, open mode (SemihostMode) or seek offset (signed)
+//   +16 seek origin (0 - begin, 1 - current, 2 - end)
+//   +20 result written by simulator: handle, byte count, new position, 0, or -1 on failure
+enum class SemihostOp : uint32
+{
+	OPEN= 1, CLOSE, READ, WRITE, SEEK
+};
+
+enum SemihostMode : uint32
+{
+	SH_READ= 1, SH_WRITE= 2, SH_TRUNCATE= 4, SH_APPEND= 8
 };
 
 
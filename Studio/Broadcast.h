@@ -18,7 +18,8 @@ public:
 	{
 		WM_USER_OFFSET = WM_APP + 0x100,
 		WM_USER_REMOVE_ERR_MARK = WM_USER_OFFSET,
-		WM_APP_STATE_CHANGED
+		WM_APP_STATE_CHANGED,
+		WM_APP_DEVICE_EVENTS
 	};
 
 	static void SendMessageToViews(UINT msg, WPARAM wParam= 0, LPARAM lParam= 0);
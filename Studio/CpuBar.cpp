@@ -10,7 +10,7 @@
 #include "CpuBar.h"
 #include "Debugger.h"
 
-CpuBar::CpuBar()
+CpuBar::CpuBar() : debugger_(nullptr)
 {}
 
 CpuBar::~CpuBar()
@@ -19,6 +19,7 @@ CpuBar::~CpuBar()
 
 BEGIN_MESSAGE_MAP(CpuBar, CSizingControlBarCF)
 	ON_WM_CREATE()
+	ON_WM_TIMER()
 END_MESSAGE_MAP()
 
 
@@ -136,6 +137,52 @@ void CpuBar::Notify(int event, UINT data, Debugger& debugger)
 	dlg_.SetStatusMsg(debugger.GetStatusMessage(status));
 
 	dlg_.EnableDialog(enabled);
+
+	// registers cannot be read directly while simulator is running; show the state it publishes instead
+	debugger_ = &debugger;
+	if (status == SIM_IS_RUNNING)
+	{
+		if (live_timer_.Id() == 0)
+			live_timer_.Start(m_hWnd, 102, 250);
+	}
+	else
+		live_timer_.Stop();
+}
+
+
+void CpuBar::OnTimer(UINT_PTR id_event)
+{
+	if (live_timer_.Id() == id_event)
+		ShowSnapshot();
+	else
+		CSizingControlBarCF::OnTimer(id_event);
+}
+
+
+void CpuBar::ShowSnapshot()
+{
+	Simulator::CpuSnapshot cpu;
+	if (debugger_ == nullptr || !debugger_->GetCpuSnapshot(cpu))
+		return;
+
+	// changes are marked relative to the last stop, so old values are left alone
+	for (size_t i= 0; i < array_count(g_registers); ++i)
+	{
+		auto& r= g_registers[i];
+		cf::uint32 val= 0;
+		if (r.reg >= cf::R_D0 && r.reg <= cf::R_D7)
+			val = cpu.d_reg[r.reg - cf::R_D0];
+		else if (r.reg >= cf::R_A0 && r.reg <= cf::R_A7)
+			val = cpu.a_reg[r.reg - cf::R_A0];
+		else if (r.reg == cf::R_SR)
+			val = cpu.sr;
+		else if (r.reg == cf::R_PC)
+			val = cpu.pc;
+		dlg_.SetRegister(r.id, val, r.old_value != val);
+	}
+
+	dlg_.SetInstructionCount(cpu.instructions);
+	dlg_.SetSupervisorMode((cpu.sr & cf::SR_SUPERVISOR) != 0);
 }
 
 
@@ -9,6 +9,7 @@
 #pragma once
 #include "scbarcf.h"
 #include "CpuDlg.h"
+#include "WndTimer.h"
 class Debugger;
 
 
@@ -28,6 +29,11 @@ private:
 private:
 	virtual void OnUpdateCmdUI(CFrameWnd* target, BOOL disableIfNoHndler);
 	int OnCreate(CREATESTRUCT* cs);
+	void OnTimer(UINT_PTR id_event);
+
+	void ShowSnapshot();
 
 	CpuDlg dlg_;
+	WndTimer live_timer_;		// refreshes registers from CPU snapshot while program is running
+	Debugger* debugger_;
 };
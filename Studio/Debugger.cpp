@@ -32,6 +32,7 @@ Debugger::Debugger() : SettingsClient(L"Debugger")
 	current_line_ = 0;
 	default_isa_ = ISA::C;
 	io_port_addr_ = ~0;
+	semihosting_ = false;
 
 	// read configuration file
 
@@ -42,6 +43,9 @@ Debugger::Debugger() : SettingsClient(L"Debugger")
 
 		simulator_.LoadConfiguration(path.c_str());
 
+		// let windows peek at registers while program is running
+		simulator_.SetSnapshotInterval(100000);
+
 		init();
 	}, L"Simulator initialization failed."); //TODO: how to bail gracefully? Program shouldn't continue
 }
@@ -120,6 +124,11 @@ void Debugger::SimEvent(cf::Event event, const Simulator::EventArgs& params)
 	{
 		main_wnd_->DeviceIO(params.device, params.access, params.param);
 	}
+	else if (event == cf::E_DEVICE_EVENTS)
+	{
+		// don't hold simulator; main window will drain events when it gets to it
+		main_wnd_->PostMsg(Broadcast::WM_APP_DEVICE_EVENTS, 0, 0);
+	}
 	else if (event != cf::E_RUNNING)
 	{
 		int line= -1;
@@ -258,7 +267,7 @@ void Debugger::Restart()
 		// it will run monitor code to initialize SP, and go to the start of the simulated progam
 		simulator_.SetRegister(cf::R_PC, monitor_.GetProgramStart());
 		simulator_.SetTempBreakpoint(code_.GetProgramStart());
-		simulator_.SetIsa(code_.GetIsa());
+		simulator_.SetIsa(ProgramIsa());
 		simulator_.ZeroStats();
 		simulator_.Run();
 	}
@@ -562,13 +571,27 @@ void Debugger::LoadMonitor()
 }
 
 
+void Debugger::SetProgramDirectory(const std::wstring& dir)
+{
+	program_dir_ = dir;
+	UpdateSemihostingRoot();
+}
+
+
+void Debugger::UpdateSemihostingRoot()
+{
+	// guest can only reach files next to its own source
+	simulator_.SetSemihostingRoot(semihosting_ && !program_dir_.empty() ? program_dir_.c_str() : nullptr);
+}
+
+
 void Debugger::SetProgram(const cf::BinaryProgram& code, bool run_monitor)
 {
 	code_ = code;
 	if (run_monitor)
 	{
 		// program may have different ISA, set it before monitor code is initialized
-		simulator_.SetIsa(code_.GetIsa());
+		simulator_.SetIsa(ProgramIsa());
 		Restart();
 	}
 	else
@@ -577,7 +600,7 @@ void Debugger::SetProgram(const cf::BinaryProgram& code, bool run_monitor)
 		{
 			simulator_.ClearMemory();
 			simulator_.SetProgram(code_);
-			simulator_.SetIsa(code_.GetIsa());
+			simulator_.SetIsa(ProgramIsa());
 			simulator_.Reset();
 			simulator_.SetRegister(cf::R_PC, code.GetProgramStart());
 			cur_prog_counter_ = simulator_.GetRegister(cf::R_PC);
@@ -674,6 +697,14 @@ cf::uint32 Debugger::ReadMemory(cf::uint8* dest_buf, cf::uint32 address, cf::uin
 
 void Debugger::ApplySettings(SettingsSection& settings)
 {
+	// terminal I/O requested through TRAP #15 may be served without running monitor code (off by default,
+	// as guest programs can install their own TRAP #15 handler)
+	simulator_.SetNativeMonitor(settings.get_bool("simulator.native_monitor"));
+
+	semihosting_ = settings.get_bool("simulator.semihosting");
+	if (simulator_.GetStatus() != SIM_IS_RUNNING)
+		UpdateSemihostingRoot();
+
 	auto exceptions= settings.section("simulator.exceptions");
 
 	for (auto& ex : exceptions)
@@ -685,6 +716,22 @@ void Debugger::ApplySettings(SettingsSection& settings)
 }
 
 
+std::string Debugger::GetProfileReport() const
+{
+	return simulator_.GetProfileReport();
+}
+
+
+// program's ISA; FPU present on the board stays enabled even if program doesn't use it
+ISA Debugger::ProgramIsa() const
+{
+	auto isa= code_.GetIsa();
+	if (IsIsaPresent(default_isa_, ISA::FPU))
+		isa = isa | ISA::FPU;
+	return isa;
+}
+
+
 ISA Debugger::GetDefaultIsa() const
 {
 	return default_isa_;
@@ -719,3 +766,21 @@ PeripheralDevice* Debugger::FindDevice(const char* category, const char* version
 {
 	return simulator_.FindPeripheral(category, version);
 }
+
+
+bool Debugger::GetCpuSnapshot(Simulator::CpuSnapshot& cpu) const
+{
+	return simulator_.GetSnapshot(cpu, nullptr);
+}
+
+
+void Debugger::DrainDeviceEvents()
+{
+	if (main_wnd_ == nullptr)
+		return;
+
+	simulator_.DrainDeviceEvents([&](const Simulator::EventArgs& params)
+	{
+		main_wnd_->DeviceIO(params.device, params.access, params.param);
+	});
+}
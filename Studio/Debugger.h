@@ -101,6 +101,9 @@ public:
 
 	void SetProgram(const cf::BinaryProgram& code, bool run_monitor);
 
+	// directory program was loaded from; semihosting requests (if enabled) can access files there
+	void SetProgramDirectory(const std::wstring& dir);
+
 	cf::uint32 GetRegister(cf::Register reg) const;
 	void SetRegister(cf::Register reg, cf::uint32 value);
 	void ModifyRegister(cf::Register reg, cf::uint32 add, cf::uint32 remove);
@@ -144,6 +147,15 @@ public:
 
 	PeripheralDevice* FindDevice(const char* category, const char* version) const;
 
+	// pass device accesses queued by the simulator to the main window; to be called by UI thread
+	void DrainDeviceEvents();
+
+	// registers as published by running simulator
+	bool GetCpuSnapshot(Simulator::CpuSnapshot& cpu) const;
+
+	// cycle counts of profiled code regions; empty if program doesn't mark any
+	std::string GetProfileReport() const;
+
 private:
 	virtual void ApplySettings(SettingsSection& settings);
 	void SimEvent(cf::Event event, const Simulator::EventArgs& params);
@@ -175,6 +187,10 @@ private:
 	// the source file is; this path is kept for debugger clients
 	std::wstring cur_line_path_;
 	ISA default_isa_;
+	std::wstring program_dir_;
+	bool semihosting_;
+	void UpdateSemihostingRoot();
+	ISA ProgramIsa() const;
 };
 
 #endif
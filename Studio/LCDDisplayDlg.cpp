@@ -196,11 +196,27 @@ void LCDDisplayDlg::Refresh(PeripheralDevice* device, DisplayDevice* display)
 		return;
 
 	auto base_address= display->GetScreenBaseAddress();
-	std::vector<cf::uint8> buffer(size, 0);
+	cf::uint32 first= 0, last= 0;
 
-	GetDebugger().ReadMemory(buffer.data(), base_address, size);
+	if (frame_.size() != size)
+	{
+		// new screen geometry; read it all
+		frame_.assign(size, 0);
+		display->TakeDirtyRows(first, last);
+		GetDebugger().ReadMemory(frame_.data(), base_address, size);
+	}
+	else if (display->TakeDirtyRows(first, last))
+	{
+		const auto row_bits= display->GetWidth() * display->GetBitsPerPixel();
+		const auto from= first * row_bits / 8;
+		const auto to= std::min<cf::uint32>(size, ((last + 1) * row_bits + 7) / 8);
+		if (from < to)
+			GetDebugger().ReadMemory(frame_.data() + from, base_address + from, to - from);
+	}
+	else
+		return;	// nothing changed
 
-	Refresh(buffer.data(), size);
+	Refresh(frame_.data(), size);
 }
 
 
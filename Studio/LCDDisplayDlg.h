@@ -36,4 +36,5 @@ private:
 	int zoom_;
 	CBitmap display_;
 	COLORREF backgnd_color_;
+	std::vector<cf::uint8> frame_;	// copy of screen memory; only changed rows are re-read
 };
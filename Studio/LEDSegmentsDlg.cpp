@@ -153,9 +153,12 @@ void LEDSegmentsDlg::ShowSegments(const unsigned int segments[], size_t count)
 void LEDSegmentsDlg::Refresh(PeripheralDevice* device, DisplayDevice* display)
 {
 	const auto size= display->GetWidth() * display->GetHeight();
+	// take all segments at once, so they come from the same moment
+	std::vector<cf::uint8> raw(size * 4, 0);
+	device->ReadBuffer(0, raw.data(), static_cast<cf::uint32>(raw.size()));
 	std::vector<unsigned int> buffer(size, 0);
 	for (cf::uint32 i= 0; i < size; ++i)
-		buffer[i] = device->ReadBufferLongWord(i);
+		buffer[i] = (raw[i * 4] << 24) | (raw[i * 4 + 1] << 16) | (raw[i * 4 + 2] << 8) | raw[i * 4 + 3];
 
 	ShowSegments(buffer.data(), buffer.size());
 }
@@ -158,6 +158,7 @@ BEGIN_MESSAGE_MAP(MainFrame, CMDIFrameWnd)
 	ON_COMMAND_RANGE(ID_VIEW_MEMORY_1, ID_VIEW_MEMORY_4, &MainFrame::OnViewMemory)
 	ON_UPDATE_COMMAND_UI_RANGE(ID_VIEW_MEMORY_1, ID_VIEW_MEMORY_4, &MainFrame::OnUpdateViewMemory)
 	ON_MESSAGE(Broadcast::WM_APP_STATE_CHANGED, &MainFrame::OnExecEvent)
+	ON_MESSAGE(Broadcast::WM_APP_DEVICE_EVENTS, &MainFrame::OnDeviceEvents)
 	ON_MESSAGE(WM_APP, &MainFrame::OnMDIRefresh)
 	ON_MESSAGE(WM_GET_TERMINAL, &MainFrame::OnGetTerminalWnd)
 	ON_NOTIFY(CTCN_SELCHANGE, IDC_TAB, &MainFrame::OnTabSelected)
@@ -550,6 +551,10 @@ LRESULT MainFrame::OnExecEvent(WPARAM wevent, LPARAM lline)
 
 		if (event != cf::E_RUNNING)
 		{
+			// displays may hold changes made since their last refresh notification
+			for (auto& p : display_map_)
+				::InterlockedCompareExchange(&p.second.dirty, DispInfo::Dirty, DispInfo::None);
+
 			auto path= dbg.GetCurrentLinePath();
 			auto pc= dbg.GetCurrentProgCounter();
 
@@ -606,6 +611,20 @@ LRESULT MainFrame::OnExecEvent(WPARAM wevent, LPARAM lline)
 			wnd.Notify(event, line, GetDebugger());
 
 		call_stack_.Notify(event, line, GetDebugger());
+
+		if (event == cf::E_EXEC_STOPPED)
+		{
+			// print profiled regions to the terminal; only when counts have changed, so stepping doesn't repeat them
+			auto report= dbg.GetProfileReport();
+			if (!report.empty() && report != last_profile_report_)
+			{
+				if (!io_window_.m_hWnd)
+					OnViewIOWindow();
+				io_window_.PutS("\nProfile:\n");
+				io_window_.PutS(report.c_str());
+			}
+			last_profile_report_ = report;
+		}
 	}, "Error processing simulator event.");
 
 	return 0;
@@ -740,6 +759,8 @@ void MainFrame::Assemble(bool enter_debugger)
 	auto& s= AppSettings().section("asm");
 	auto case_sensitive= s.get_bool("case_sens");
 	auto isa= StringToISA(s.get_string("isa")) | StringToISA(s.get_string("mac"));
+	if (s.get_bool("fpu"))
+		isa = isa | ISA::FPU;
 
 	//TODO: start assembly thread
 
@@ -777,6 +798,7 @@ void MainFrame::Assemble(bool enter_debugger)
 			// this call may fail if destination memory is not available
 			try
 			{
+				dbg.SetProgramDirectory(dir.wstring());
 				dbg.SetProgram(a->GetCode(), true);
 			}
 			catch (std::exception& ex)
@@ -1356,6 +1378,7 @@ void MainFrame::OnFileLoadCode()
 		}
 
 		GetDebugger().SetDebugInfo(nullptr);
+		GetDebugger().SetProgramDirectory(path.parent_path().wstring());
 		GetDebugger().SetProgram(code, run);
 
 	}, "Error loading binary code.");
@@ -1631,6 +1654,14 @@ LRESULT MainFrame::PostMsg(int msg, WPARAM wparam, LPARAM lparam)
 }
 
 
+// simulator has queued device accesses
+LRESULT MainFrame::OnDeviceEvents(WPARAM, LPARAM)
+{
+	GetDebugger().DrainDeviceEvents();
+	return 0;
+}
+
+
 void MainFrame::DeviceIO(PeripheralDevice* device, cf::DeviceAccess access, cf::uint32 addr)
 {
 	if (access == cf::DeviceAccess::Read)
@@ -132,6 +132,7 @@ private:
 	afx_msg void OnUpdateViewDisplayWindow(CCmdUI* cmd_ui);
 	void OnUpdateSimDebugStop(CCmdUI* cmd_ui);
 	LRESULT OnExecEvent(WPARAM, LPARAM);
+	LRESULT OnDeviceEvents(WPARAM, LPARAM);
 	afx_msg void OnShowHelp();
 	DECLARE_MESSAGE_MAP()
 
@@ -183,6 +184,7 @@ private:
 	};
 	std::map<PeripheralDevice*, DispInfo> display_map_;
 	DWORD last_refresh_time_;
+	std::string last_profile_report_;
 
 	static const TCHAR REG_ENTRY_MAINFRM[];
 	static const TCHAR REG_POSX[], REG_POSY[], REG_SIZX[], REG_SIZY[], REG_STATE[];